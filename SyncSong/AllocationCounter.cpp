@@ -0,0 +1,111 @@
+#include "AllocationCounter.hpp"
+
+namespace AllocationCounter
+{
+	namespace
+	{
+		constexpr size_t SubsystemCount = static_cast<size_t>(Subsystem::Count);
+
+		std::array<std::atomic<uint64>, SubsystemCount> CurrentCounts{};
+		std::array<std::atomic<uint64>, SubsystemCount> CurrentBytes{};
+		std::array<Stats, SubsystemCount> LastFrame{};
+		uint64 AllocatingFrameCount = 0;
+
+		thread_local Subsystem CurrentSubsystem = Subsystem::Other;
+	}
+
+	// operator new から呼ばれる（確保を現在のサブシステムに計上）
+	void Record(size_t size) noexcept
+	{
+		const size_t index = static_cast<size_t>(CurrentSubsystem);
+		CurrentCounts[index].fetch_add(1, std::memory_order_relaxed);
+		CurrentBytes[index].fetch_add(size, std::memory_order_relaxed);
+	}
+
+	ScopedSubsystem::ScopedSubsystem(Subsystem subsystem)
+		: previous{ CurrentSubsystem }
+	{
+		CurrentSubsystem = subsystem;
+	}
+
+	ScopedSubsystem::~ScopedSubsystem()
+	{
+		CurrentSubsystem = previous;
+	}
+
+	void BeginFrame()
+	{
+		for (size_t i = 0; i < SubsystemCount; ++i)
+		{
+			LastFrame[i] = { CurrentCounts[i].exchange(0, std::memory_order_relaxed), CurrentBytes[i].exchange(0, std::memory_order_relaxed) };
+		}
+
+		if (LastFrame[static_cast<size_t>(Subsystem::Logic)].count || LastFrame[static_cast<size_t>(Subsystem::Render)].count)
+		{
+			++AllocatingFrameCount;
+		}
+	}
+
+	Stats GetLastFrame(Subsystem subsystem)
+	{
+		return LastFrame[static_cast<size_t>(subsystem)];
+	}
+
+	uint64 GetAllocatingFrameCount()
+	{
+		return AllocatingFrameCount;
+	}
+}
+
+#ifdef SYNCSONG_COUNT_ALLOCATIONS
+
+// グローバルな operator new / delete を置き換えて確保を数える
+// （配列版・nothrow 版・サイズ付き delete は標準の既定実装がこれらを呼ぶ）
+
+void* operator new(std::size_t size)
+{
+	AllocationCounter::Record(size);
+
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	AllocationCounter::Record(size);
+
+# if defined(_MSC_VER)
+	void* p = ::_aligned_malloc(size ? size : 1, static_cast<size_t>(alignment));
+# else
+	// aligned_alloc はサイズがアライメントの倍数である必要がある
+	const size_t align = static_cast<size_t>(alignment);
+	void* p = std::aligned_alloc(align, (((size ? size : 1) + align - 1) & ~(align - 1)));
+# endif
+
+	if (p)
+	{
+		return p;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+# if defined(_MSC_VER)
+	::_aligned_free(p);
+# else
+	std::free(p);
+# endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// ヒープ確保の回数とバイト数をフレーム・サブシステムごとに数える
+// SYNCSONG_COUNT_ALLOCATIONS を定義してビルドしたときだけ operator new を置き換えて計測する
+namespace AllocationCounter
+{
+	enum class Subsystem : uint8
+	{
+		Other,
+		Logic,
+		Render,
+		Count,
+	};
+
+	struct Stats
+	{
+		uint64 count = 0;
+		uint64 bytes = 0;
+	};
+
+	// 計測が有効なビルドか
+	constexpr bool IsEnabled()
+	{
+	#ifdef SYNCSONG_COUNT_ALLOCATIONS
+		return true;
+	#else
+		return false;
+	#endif
+	}
+
+	// スコープ内の確保を指定したサブシステムに計上する（現在のスレッドのみ）
+	struct ScopedSubsystem
+	{
+		Subsystem previous;
+
+		explicit ScopedSubsystem(Subsystem subsystem);
+
+		~ScopedSubsystem();
+
+		ScopedSubsystem(const ScopedSubsystem&) = delete;
+
+		ScopedSubsystem& operator=(const ScopedSubsystem&) = delete;
+	};
+
+	// フレームの区切り: これまでの計測結果を前フレームの値として確定し、カウンタを 0 に戻す
+	void BeginFrame();
+
+	// 前フレームの計測結果
+	Stats GetLastFrame(Subsystem subsystem);
+
+	// ロジックか描画で確保があったフレームの数（計測開始から）
+	uint64 GetAllocatingFrameCount();
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "AudioClock.hpp"
+#include "Config.hpp"
+#include "FrameTracer.hpp"
+
+namespace AudioClockUtils
+{
+	namespace
+	{
+		// 再生位置を細かく読み取り、値が変化した時刻を記録する
+		void RunPoller(AudioClock& clock)
+		{
+			FrameTracer::SetCurrentThreadName(U"audio clock");
+
+			// 最初に読んだ値はいつから続いているか分からないので、値が変化した時点から記録する
+			double previousSec = clock.audio.posSec();
+
+			while (not clock.stopRequested.load(std::memory_order_relaxed))
+			{
+				const double reportedSec = clock.audio.posSec();
+				const double wallSec = clock.stopwatch.sF();
+
+				if (reportedSec != previousSec)
+				{
+					std::lock_guard lock{ clock.mutex };
+					clock.lastReportedSec = reportedSec;
+					clock.lastReportWallSec = wallSec;
+					++clock.reportCount;
+					previousSec = reportedSec;
+				}
+
+				std::this_thread::sleep_for(std::chrono::microseconds{ Config::AudioClockPollIntervalUs });
+			}
+		}
+	}
+
+	bool Start(AudioClock& clock, const FilePath& path, double latencySec)
+	{
+		Stop(clock);
+
+		clock.audio = Audio{ Audio::Stream, path, Loop::Yes };
+		if (not clock.audio)
+		{
+			return false;
+		}
+
+		clock.lastReportedSec = -1.0;
+		clock.lastReportWallSec = 0.0;
+		clock.reportCount = 0;
+		clock.consumedReportCount = 0;
+		clock.latencySec = latencySec;
+		clock.hasMusicTime = false;
+		clock.samples.clear();
+		clock.samples.reserve(Config::AudioSyncLogCapacity);
+
+		clock.stopwatch.restart();
+		clock.audio.play();
+
+		clock.stopRequested = false;
+		clock.poller = std::thread{ RunPoller, std::ref(clock) };
+		clock.running = true;
+		return true;
+	}
+
+	void Stop(AudioClock& clock)
+	{
+		if (not clock.running)
+		{
+			return;
+		}
+
+		clock.stopRequested = true;
+		clock.poller.join();
+		clock.audio.stop();
+		clock.running = false;
+	}
+
+	double Update(AudioClock& clock)
+	{
+		const double wallSec = clock.stopwatch.sF();
+
+		double reportedSec;
+		double reportWallSec;
+		uint64 reportCount;
+		{
+			std::lock_guard lock{ clock.mutex };
+			reportedSec = clock.lastReportedSec;
+			reportWallSec = clock.lastReportWallSec;
+			reportCount = clock.reportCount;
+		}
+
+		// 再生速度は 1 倍なので、最後に合わせた位置から経過時間だけ進める
+		const auto estimateAt = [&](double atWallSec) { return (clock.anchorSec + (atWallSec - clock.anchorWallSec)); };
+
+		bool resynced = false;
+		if ((reportCount != clock.consumedReportCount) && (0.0 <= reportedSec))
+		{
+			clock.consumedReportCount = reportCount;
+
+			// 報告が変化した時刻での推定値と比べる
+			const double estimatedSec = estimateAt(reportWallSec);
+			const double errorSec = (estimatedSec - reportedSec);
+
+			if ((not clock.hasMusicTime) || (Config::AudioResyncThresholdSec < Math::Abs(errorSec)))
+			{
+				// 再生開始・ループ・シーク
+				clock.anchorSec = reportedSec;
+				resynced = true;
+			}
+			else
+			{
+				if (clock.samples.size() < Config::AudioSyncLogCapacity)
+				{
+					clock.samples.push_back(AudioSyncSample{ reportWallSec, reportedSec, estimatedSec, (errorSec * 1000.0) });
+				}
+
+				// 報告の粗さによる揺れを抑えるため、差の一部だけ補正する
+				clock.anchorSec = (estimatedSec - errorSec * Config::AudioClockCorrectionGain);
+			}
+			clock.anchorWallSec = reportWallSec;
+		}
+
+		if ((not clock.hasMusicTime) && (not resynced))
+		{
+			// まだ報告が無い
+			return 0.0;
+		}
+
+		const double musicTime = (estimateAt(wallSec) - clock.latencySec);
+		const double deltaSec = ((not clock.hasMusicTime) ? 0.0 : resynced ? (wallSec - clock.lastUpdateWallSec) : (musicTime - clock.musicTime));
+
+		clock.musicTime = musicTime;
+		clock.lastUpdateWallSec = wallSec;
+		clock.hasMusicTime = true;
+		return deltaSec;
+	}
+
+	AudioSyncStats GetSyncStats(const AudioClock& clock)
+	{
+		AudioSyncStats stats;
+		stats.sampleCount = clock.samples.size();
+		if (not clock.samples)
+		{
+			return stats;
+		}
+
+		Array<double> absErrors(clock.samples.size());
+		for (size_t i = 0; i < clock.samples.size(); ++i)
+		{
+			absErrors[i] = Math::Abs(clock.samples[i].errorMs);
+			stats.meanAbsErrorMs += absErrors[i];
+			stats.maxAbsErrorMs = Max(stats.maxAbsErrorMs, absErrors[i]);
+		}
+		stats.meanAbsErrorMs /= absErrors.size();
+
+		const size_t n = Min(static_cast<size_t>(0.99 * absErrors.size()), (absErrors.size() - 1));
+		std::nth_element(absErrors.begin(), (absErrors.begin() + n), absErrors.end());
+		stats.p99AbsErrorMs = absErrors[n];
+		return stats;
+	}
+
+	bool SaveCSV(const FilePath& path, const AudioClock& clock)
+	{
+		TextWriter writer{ path };
+		if (not writer)
+		{
+			return false;
+		}
+
+		writer.writeln(U"wall_sec,reported_sec,estimated_sec,error_ms");
+		for (const AudioSyncSample& sample : clock.samples)
+		{
+			writer.writeln(U"{:.6f},{:.6f},{:.6f},{:.4f}"_fmt(sample.wallSec, sample.reportedSec, sample.estimatedSec, sample.errorMs));
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
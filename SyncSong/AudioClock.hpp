@@ -0,0 +1,66 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 音声の再生位置の報告1回分と、そのときの推定値との差（同期誤差の記録用）
+struct AudioSyncSample
+{
+	double wallSec = 0.0;     // 報告が変化した時刻（AudioClock::stopwatch）
+	double reportedSec = 0.0; // Audio::posSec() の値
+	double estimatedSec = 0.0; // 補正前の推定値
+	double errorMs = 0.0;     // estimatedSec - reportedSec
+};
+
+// 同期誤差の集計
+struct AudioSyncStats
+{
+	size_t sampleCount = 0;
+	double meanAbsErrorMs = 0.0;
+	double p99AbsErrorMs = 0.0;
+	double maxAbsErrorMs = 0.0;
+};
+
+// 音声の再生位置から作る滑らかな時計（回転を音楽に同期させるため）
+// Audio::posSec() はミキサーのバッファ単位でしか進まないので、別スレッドで細かく読み取って値が変化した時刻を記録し、
+// その間は高分解能の時計で補間する。報告との差は少しずつ補正し、シークやループで大きくずれたときは合わせ直す
+struct AudioClock
+{
+	Audio audio;
+	Stopwatch stopwatch; // 報告の時刻と補間に使う
+
+	// 読み取りスレッドが書き、メインスレッドが読む（mutex で保護）
+	std::thread poller;
+	std::mutex mutex;
+	std::atomic<bool> stopRequested = false;
+	double lastReportedSec = -1.0;
+	double lastReportWallSec = 0.0;
+	uint64 reportCount = 0;
+
+	// メインスレッドだけが触る
+	uint64 consumedReportCount = 0;
+	double anchorSec = 0.0;     // anchorWallSec における推定再生位置
+	double anchorWallSec = 0.0;
+	double latencySec = 0.0;    // 出力の遅延（聞こえている位置 = 再生位置 - latencySec）
+	double musicTime = 0.0;     // 前回 Update で求めた、聞こえている位置
+	double lastUpdateWallSec = 0.0;
+	bool hasMusicTime = false;
+	Array<AudioSyncSample> samples; // 最大 Config::AudioSyncLogCapacity 件
+	bool running = false;
+};
+
+namespace AudioClockUtils
+{
+	// 音声をストリーミング再生で開き、再生と位置の読み取りを開始（開けなければ false）
+	bool Start(AudioClock& clock, const FilePath& path, double latencySec);
+
+	// 再生と読み取りを停止
+	void Stop(AudioClock& clock);
+
+	// 現在の聞こえている位置を推定し、前回からの進み（秒）を返す（ループやシークで合わせ直したフレームは経過時間を返す）
+	double Update(AudioClock& clock);
+
+	// 記録した同期誤差の集計
+	AudioSyncStats GetSyncStats(const AudioClock& clock);
+
+	// 同期誤差を CSV で書き出す
+	bool SaveCSV(const FilePath& path, const AudioClock& clock);
+}
\ No newline at end of file
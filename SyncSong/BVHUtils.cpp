@@ -0,0 +1,444 @@
+#include "BVHUtils.hpp"
+#include "Config.hpp"
+#include "FrameProfiler.hpp"
+
+namespace BVHUtils
+{
+	namespace
+	{
+		bool IsLeaf(const SphereBVHNode& node)
+		{
+			return (node.left == -1);
+		}
+
+		double SurfaceArea(const Vec3& boundsMin, const Vec3& boundsMax)
+		{
+			const Vec3 size = boundsMax - boundsMin;
+			return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		Vec3 MinVec(const Vec3& a, const Vec3& b)
+		{
+			return{ Min(a.x, b.x), Min(a.y, b.y), Min(a.z, b.z) };
+		}
+
+		Vec3 MaxVec(const Vec3& a, const Vec3& b)
+		{
+			return{ Max(a.x, b.x), Max(a.y, b.y), Max(a.z, b.z) };
+		}
+
+		// 子ノードのAABBと高さから親ノードを更新
+		void UpdateFromChildren(SphereBVH& bvh, int32 index)
+		{
+			SphereBVHNode& node = bvh.nodes[index];
+			const SphereBVHNode& left = bvh.nodes[node.left];
+			const SphereBVHNode& right = bvh.nodes[node.right];
+			node.boundsMin = MinVec(left.boundsMin, right.boundsMin);
+			node.boundsMax = MaxVec(left.boundsMax, right.boundsMax);
+			node.height = 1 + Max(left.height, right.height);
+		}
+
+		int32 AllocateNode(SphereBVH& bvh)
+		{
+			if (bvh.freeNodes)
+			{
+				const int32 index = bvh.freeNodes.back();
+				bvh.freeNodes.pop_back();
+				bvh.nodes[index] = SphereBVHNode{};
+				return index;
+			}
+
+			bvh.nodes.emplace_back();
+			return static_cast<int32>(bvh.nodes.size() - 1);
+		}
+
+		void FreeNode(SphereBVH& bvh, int32 index)
+		{
+			bvh.nodes[index].height = -1;
+			bvh.freeNodes.push_back(index);
+		}
+
+		// 親の子ポインタ（または根）を oldChild から newChild に付け替える
+		void ReplaceChild(SphereBVH& bvh, int32 parent, int32 oldChild, int32 newChild)
+		{
+			if (parent == -1)
+			{
+				bvh.root = newChild;
+			}
+			else if (bvh.nodes[parent].left == oldChild)
+			{
+				bvh.nodes[parent].left = newChild;
+			}
+			else
+			{
+				bvh.nodes[parent].right = newChild;
+			}
+		}
+
+		// 高さの差が2以上あれば回転して平衡を保つ（部分木の新しい根を返す）
+		int32 Balance(SphereBVH& bvh, int32 iA)
+		{
+			if (IsLeaf(bvh.nodes[iA]) || (bvh.nodes[iA].height < 2))
+			{
+				return iA;
+			}
+
+			const int32 iB = bvh.nodes[iA].left;
+			const int32 iC = bvh.nodes[iA].right;
+			const int32 balance = (bvh.nodes[iC].height - bvh.nodes[iB].height);
+
+			// 右の子 C を持ち上げる
+			if (balance > 1)
+			{
+				const int32 iF = bvh.nodes[iC].left;
+				const int32 iG = bvh.nodes[iC].right;
+
+				bvh.nodes[iC].left = iA;
+				bvh.nodes[iC].parent = bvh.nodes[iA].parent;
+				bvh.nodes[iA].parent = iC;
+				ReplaceChild(bvh, bvh.nodes[iC].parent, iA, iC);
+
+				const bool keepF = (bvh.nodes[iF].height > bvh.nodes[iG].height);
+				const int32 kept = keepF ? iF : iG;
+				const int32 moved = keepF ? iG : iF;
+				bvh.nodes[iC].right = kept;
+				bvh.nodes[iA].right = moved;
+				bvh.nodes[moved].parent = iA;
+
+				UpdateFromChildren(bvh, iA);
+				UpdateFromChildren(bvh, iC);
+				return iC;
+			}
+
+			// 左の子 B を持ち上げる
+			if (balance < -1)
+			{
+				const int32 iD = bvh.nodes[iB].left;
+				const int32 iE = bvh.nodes[iB].right;
+
+				bvh.nodes[iB].left = iA;
+				bvh.nodes[iB].parent = bvh.nodes[iA].parent;
+				bvh.nodes[iA].parent = iB;
+				ReplaceChild(bvh, bvh.nodes[iB].parent, iA, iB);
+
+				const bool keepD = (bvh.nodes[iD].height > bvh.nodes[iE].height);
+				const int32 kept = keepD ? iD : iE;
+				const int32 moved = keepD ? iE : iD;
+				bvh.nodes[iB].right = kept;
+				bvh.nodes[iA].left = moved;
+				bvh.nodes[moved].parent = iA;
+
+				UpdateFromChildren(bvh, iA);
+				UpdateFromChildren(bvh, iB);
+				return iB;
+			}
+
+			return iA;
+		}
+
+		// index から根までAABBと高さを更新
+		void RefitAncestors(SphereBVH& bvh, int32 index, bool balance)
+		{
+			while (index != -1)
+			{
+				if (balance)
+				{
+					index = Balance(bvh, index);
+				}
+
+				UpdateFromChildren(bvh, index);
+				index = bvh.nodes[index].parent;
+			}
+		}
+
+		void InsertLeaf(SphereBVH& bvh, int32 leaf)
+		{
+			if (bvh.root == -1)
+			{
+				bvh.root = leaf;
+				bvh.nodes[leaf].parent = -1;
+				return;
+			}
+
+			// 表面積ヒューリスティックで兄弟ノードを選ぶ
+			const Vec3 leafMin = bvh.nodes[leaf].boundsMin;
+			const Vec3 leafMax = bvh.nodes[leaf].boundsMax;
+			int32 index = bvh.root;
+
+			while (not IsLeaf(bvh.nodes[index]))
+			{
+				const SphereBVHNode& node = bvh.nodes[index];
+				const double area = SurfaceArea(node.boundsMin, node.boundsMax);
+				const double combinedArea = SurfaceArea(MinVec(node.boundsMin, leafMin), MaxVec(node.boundsMax, leafMax));
+
+				// ここで兄弟にする場合のコストと、子へ降りる場合に増える祖先のコスト
+				const double cost = 2.0 * combinedArea;
+				const double inheritanceCost = 2.0 * (combinedArea - area);
+
+				const auto descendCost = [&](int32 childIndex)
+				{
+					const SphereBVHNode& child = bvh.nodes[childIndex];
+					const double unionArea = SurfaceArea(MinVec(child.boundsMin, leafMin), MaxVec(child.boundsMax, leafMax));
+					return (IsLeaf(child) ? unionArea : (unionArea - SurfaceArea(child.boundsMin, child.boundsMax))) + inheritanceCost;
+				};
+
+				const double leftCost = descendCost(node.left);
+				const double rightCost = descendCost(node.right);
+
+				if ((cost < leftCost) && (cost < rightCost))
+				{
+					break;
+				}
+
+				index = (leftCost < rightCost) ? node.left : node.right;
+			}
+
+			const int32 sibling = index;
+			const int32 oldParent = bvh.nodes[sibling].parent;
+			const int32 newParent = AllocateNode(bvh);
+
+			bvh.nodes[newParent].parent = oldParent;
+			bvh.nodes[newParent].left = sibling;
+			bvh.nodes[newParent].right = leaf;
+			bvh.nodes[sibling].parent = newParent;
+			bvh.nodes[leaf].parent = newParent;
+			ReplaceChild(bvh, oldParent, sibling, newParent);
+
+			RefitAncestors(bvh, newParent, true);
+		}
+
+		void RemoveLeaf(SphereBVH& bvh, int32 leaf)
+		{
+			if (leaf == bvh.root)
+			{
+				bvh.root = -1;
+				return;
+			}
+
+			const int32 parent = bvh.nodes[leaf].parent;
+			const int32 grandParent = bvh.nodes[parent].parent;
+			const int32 sibling = (bvh.nodes[parent].left == leaf) ? bvh.nodes[parent].right : bvh.nodes[parent].left;
+
+			// 親ノードを兄弟で置き換える
+			ReplaceChild(bvh, grandParent, parent, sibling);
+			bvh.nodes[sibling].parent = grandParent;
+			FreeNode(bvh, parent);
+
+			RefitAncestors(bvh, grandParent, true);
+		}
+
+		void SetLeafBounds(SphereBVHNode& node, const Vec3& center, double radius)
+		{
+			const Vec3 extent{ radius + Config::BVHFatMargin, radius + Config::BVHFatMargin, radius + Config::BVHFatMargin };
+			node.boundsMin = center - extent;
+			node.boundsMax = center + extent;
+		}
+
+		// レイとAABBの交差距離（スラブ法）
+		Optional<double> RayAABBDistance(const Vec3& origin, const Vec3& inverseDirection,
+			const Vec3& boundsMin, const Vec3& boundsMax, double maxDistance)
+		{
+			const Vec3 t1 = (boundsMin - origin) * inverseDirection;
+			const Vec3 t2 = (boundsMax - origin) * inverseDirection;
+
+			const double tMin = Max({ 0.0, Min(t1.x, t2.x), Min(t1.y, t2.y), Min(t1.z, t2.z) });
+			const double tMax = Min({ maxDistance, Max(t1.x, t2.x), Max(t1.y, t2.y), Max(t1.z, t2.z) });
+
+			if (tMax < tMin)
+			{
+				return none;
+			}
+
+			return tMin;
+		}
+
+		// 末尾の未登録エントリを切り詰める（球の配列が縮んだとき用）
+		void TrimSphereLeaves(SphereBVH& bvh)
+		{
+			while (bvh.sphereLeaves && (bvh.sphereLeaves.back() == -1))
+			{
+				bvh.sphereLeaves.pop_back();
+			}
+		}
+	}
+
+	void Clear(SphereBVH& bvh)
+	{
+		bvh.nodes.clear();
+		bvh.freeNodes.clear();
+		bvh.sphereLeaves.clear();
+		bvh.root = -1;
+	}
+
+	void InsertSphere(SphereBVH& bvh, int32 sphereIndex, const Vec3& center, double radius)
+	{
+		if (sphereIndex < 0)
+		{
+			return;
+		}
+
+		if (static_cast<size_t>(sphereIndex) >= bvh.sphereLeaves.size())
+		{
+			bvh.sphereLeaves.resize(sphereIndex + 1, -1);
+		}
+
+		if (bvh.sphereLeaves[sphereIndex] != -1)
+		{
+			ReinsertSphere(bvh, sphereIndex, center, radius);
+			return;
+		}
+
+		const int32 leaf = AllocateNode(bvh);
+		bvh.nodes[leaf].sphereIndex = sphereIndex;
+		SetLeafBounds(bvh.nodes[leaf], center, radius);
+		bvh.sphereLeaves[sphereIndex] = leaf;
+
+		InsertLeaf(bvh, leaf);
+	}
+
+	void RemoveSphere(SphereBVH& bvh, int32 sphereIndex)
+	{
+		if ((sphereIndex < 0) || (static_cast<size_t>(sphereIndex) >= bvh.sphereLeaves.size()) || (bvh.sphereLeaves[sphereIndex] == -1))
+		{
+			return;
+		}
+
+		const int32 leaf = bvh.sphereLeaves[sphereIndex];
+		RemoveLeaf(bvh, leaf);
+		FreeNode(bvh, leaf);
+		bvh.sphereLeaves[sphereIndex] = -1;
+		TrimSphereLeaves(bvh);
+	}
+
+	void RenameSphere(SphereBVH& bvh, int32 fromIndex, int32 toIndex)
+	{
+		if ((fromIndex < 0) || (toIndex < 0)
+			|| (static_cast<size_t>(fromIndex) >= bvh.sphereLeaves.size()) || (bvh.sphereLeaves[fromIndex] == -1))
+		{
+			return;
+		}
+
+		if (static_cast<size_t>(toIndex) >= bvh.sphereLeaves.size())
+		{
+			bvh.sphereLeaves.resize(toIndex + 1, -1);
+		}
+
+		const int32 leaf = bvh.sphereLeaves[fromIndex];
+		bvh.nodes[leaf].sphereIndex = toIndex;
+		bvh.sphereLeaves[toIndex] = leaf;
+		bvh.sphereLeaves[fromIndex] = -1;
+		TrimSphereLeaves(bvh);
+	}
+
+	void RefitSphere(SphereBVH& bvh, int32 sphereIndex, const Vec3& center, double radius)
+	{
+		if ((sphereIndex < 0) || (static_cast<size_t>(sphereIndex) >= bvh.sphereLeaves.size()) || (bvh.sphereLeaves[sphereIndex] == -1))
+		{
+			return;
+		}
+
+		const int32 leaf = bvh.sphereLeaves[sphereIndex];
+		SphereBVHNode& node = bvh.nodes[leaf];
+
+		// 広げたAABBの中に収まっている間は何もしない
+		const Vec3 extent{ radius, radius, radius };
+		const Vec3 tightMin = center - extent;
+		const Vec3 tightMax = center + extent;
+		if ((MinVec(node.boundsMin, tightMin) == node.boundsMin) && (MaxVec(node.boundsMax, tightMax) == node.boundsMax))
+		{
+			return;
+		}
+
+		SetLeafBounds(node, center, radius);
+		RefitAncestors(bvh, node.parent, false);
+	}
+
+	void ReinsertSphere(SphereBVH& bvh, int32 sphereIndex, const Vec3& center, double radius)
+	{
+		if ((sphereIndex < 0) || (static_cast<size_t>(sphereIndex) >= bvh.sphereLeaves.size()) || (bvh.sphereLeaves[sphereIndex] == -1))
+		{
+			return;
+		}
+
+		const int32 leaf = bvh.sphereLeaves[sphereIndex];
+		RemoveLeaf(bvh, leaf);
+		SetLeafBounds(bvh.nodes[leaf], center, radius);
+		InsertLeaf(bvh, leaf);
+	}
+
+	Optional<int32> RayCastNearest(const SphereBVH& bvh, const SphereStore& spheres, const Ray& ray,
+		double radius, double& nearestDistance, FrameArena& arena)
+	{
+		if (bvh.root == -1)
+		{
+			return none;
+		}
+
+		const Vec3 origin = ray.getOrigin();
+		const Vec3 direction = ray.getDirection();
+		const Vec3 inverseDirection{ 1.0 / direction.x, 1.0 / direction.y, 1.0 / direction.z };
+
+		Optional<int32> nearestIndex;
+		// 手前の子を後に積む深さ優先探索なので、スタックは木の高さ + 1 を超えない
+		const std::span<int32> stack = arena.allocateArray<int32>(bvh.nodes[bvh.root].height + 2);
+		size_t stackSize = 0;
+		stack[stackSize++] = bvh.root;
+
+		while (stackSize)
+		{
+			const SphereBVHNode& node = bvh.nodes[stack[--stackSize]];
+
+			// x < 0 の球は相互作用しない
+			if (node.boundsMax.x < 0)
+			{
+				continue;
+			}
+
+			if (not RayAABBDistance(origin, inverseDirection, node.boundsMin, node.boundsMax, nearestDistance))
+			{
+				continue;
+			}
+
+			if (IsLeaf(node))
+			{
+				const Vec3 center = spheres.position(node.sphereIndex);
+				if (center.x < 0)
+				{
+					continue;
+				}
+
+				FrameProfiler::AddCount(FrameProfiler::Counter::RayTests, 1);
+				const auto intersection = ray.intersects(Sphere{ center, radius });
+				if (intersection && (*intersection < nearestDistance))
+				{
+					nearestDistance = *intersection;
+					nearestIndex = node.sphereIndex;
+				}
+				continue;
+			}
+
+			// 手前の子から先に調べる（スタックなので遠い方を先に積む）
+			const SphereBVHNode& left = bvh.nodes[node.left];
+			const SphereBVHNode& right = bvh.nodes[node.right];
+			const auto leftDistance = RayAABBDistance(origin, inverseDirection, left.boundsMin, left.boundsMax, nearestDistance);
+			const auto rightDistance = RayAABBDistance(origin, inverseDirection, right.boundsMin, right.boundsMax, nearestDistance);
+
+			if (leftDistance && rightDistance)
+			{
+				const bool leftFirst = (*leftDistance <= *rightDistance);
+				stack[stackSize++] = (leftFirst ? node.right : node.left);
+				stack[stackSize++] = (leftFirst ? node.left : node.right);
+			}
+			else if (leftDistance)
+			{
+				stack[stackSize++] = node.left;
+			}
+			else if (rightDistance)
+			{
+				stack[stackSize++] = node.right;
+			}
+		}
+
+		return nearestIndex;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <Siv3D.hpp>
+#include "GameTypes.hpp"
+#include "SphereStore.hpp"
+#include "FrameArena.hpp"
+
+namespace BVHUtils
+{
+	// BVHを空にする
+	void Clear(SphereBVH& bvh);
+
+	// 球を葉として登録
+	void InsertSphere(SphereBVH& bvh, int32 sphereIndex, const Vec3& center, double radius);
+
+	// 球を取り除く
+	void RemoveSphere(SphereBVH& bvh, int32 sphereIndex);
+
+	// 球のインデックスが変わったときに葉の対応を付け替える（toIndex は未登録であること）
+	void RenameSphere(SphereBVH& bvh, int32 fromIndex, int32 toIndex);
+
+	// 移動した球の葉を広げ、祖先のAABBを更新（ドラッグ中の小さな移動用）
+	void RefitSphere(SphereBVH& bvh, int32 sphereIndex, const Vec3& center, double radius);
+
+	// 球を挿入し直して木の品質を回復（ドロップ時用）
+	void ReinsertSphere(SphereBVH& bvh, int32 sphereIndex, const Vec3& center, double radius);
+
+	// レイと最も手前で交差する球を検索（nearestDistance より手前のみ、見つかれば nearestDistance を更新）
+	// 探索用のスタックは arena から確保する
+	Optional<int32> RayCastNearest(const SphereBVH& bvh, const SphereStore& spheres, const Ray& ray,
+		double radius, double& nearestDistance, FrameArena& arena);
+}
\ No newline at end of file
@@ -0,0 +1,636 @@
+#include "BeatMap.hpp"
+#include "Config.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	include <immintrin.h>
+#	define SYNCSONG_USE_SSE 1
+#endif
+
+namespace BeatMapUtils
+{
+	namespace
+	{
+		// キャッシュはリトルエンディアンのまま書き出す
+		static_assert(std::endian::native == std::endian::little);
+		static_assert(std::has_single_bit(Config::BeatFFTSize) && (Config::BeatHopSize <= Config::BeatFFTSize));
+
+		constexpr std::array<uint8, 4> Magic{ 'S', 'S', 'B', 'M' };
+		constexpr uint32 Version = 1;
+
+		constexpr uint64 FNVOffsetBasis = 14695981039346656037ull;
+		constexpr uint64 FNVPrime = 1099511628211ull;
+
+		// キャッシュファイルの先頭
+		struct CacheHeader
+		{
+			std::array<uint8, 4> magic;
+			uint32 version;
+			uint64 analysisKey; // 解析の設定のハッシュ（設定を変えたら解析し直す）
+			uint64 contentHash;
+			uint32 sampleRate;
+			uint32 reserved;
+			double durationSec;
+			uint64 onsetCount; // この後ろに float × onsetCount の時刻、float × onsetCount の強さ
+		};
+		static_assert(sizeof(CacheHeader) == 48);
+
+		uint64 HashWords(uint64 hash, const uint8* data, size_t size)
+		{
+			size_t i = 0;
+			for (; (i + sizeof(uint64)) <= size; i += sizeof(uint64))
+			{
+				uint64 word;
+				std::memcpy(&word, (data + i), sizeof(word));
+				hash = ((hash ^ word) * FNVPrime);
+			}
+
+			// 8 バイトに満たない末尾
+			for (; i < size; ++i)
+			{
+				hash = ((hash ^ data[i]) * FNVPrime);
+			}
+			return hash;
+		}
+
+		uint64 GetAnalysisKey()
+		{
+			const std::array<double, 7> settings{
+				static_cast<double>(Config::BeatFFTSize),
+				static_cast<double>(Config::BeatHopSize),
+				Config::BeatLogCompression,
+				static_cast<double>(Config::BeatThresholdWindow),
+				Config::BeatThresholdScale,
+				Config::BeatThresholdOffset,
+				Config::BeatMinIntervalSec,
+			};
+			return HashWords(FNVOffsetBasis, reinterpret_cast<const uint8*>(settings.data()), sizeof(settings));
+		}
+
+		////////////////////////////////
+		//
+		//	チャンクごとのデコード
+		//
+		////////////////////////////////
+
+		// ファイルから少しずつ読む WAV
+		struct WavStream
+		{
+			BinaryReader reader;
+			uint16 format = 0; // 1: PCM, 3: float
+			uint16 channelCount = 0;
+			uint16 bitsPerSample = 0;
+			uint32 sampleRate = 0;
+			int64 dataEnd = 0;
+			Array<uint8> buffer;
+		};
+
+		constexpr uint16 WavFormatPCM = 1;
+		constexpr uint16 WavFormatFloat = 3;
+		constexpr uint16 WavFormatExtensible = 0xFFFE;
+
+		// RIFF のチャンクを読み、data チャンクの先頭に位置を合わせる（対応しない形式なら false）
+		bool OpenWav(WavStream& wav, const FilePath& path)
+		{
+			wav.reader = BinaryReader{ path };
+			if (not wav.reader)
+			{
+				return false;
+			}
+
+			std::array<uint8, 12> riff;
+			if ((wav.reader.read(riff.data(), riff.size()) != static_cast<int64>(riff.size()))
+				|| (std::memcmp(riff.data(), "RIFF", 4) != 0) || (std::memcmp((riff.data() + 8), "WAVE", 4) != 0))
+			{
+				return false;
+			}
+
+			bool hasFormat = false;
+			std::array<uint8, 8> chunk;
+			while (wav.reader.read(chunk.data(), chunk.size()) == static_cast<int64>(chunk.size()))
+			{
+				uint32 chunkSize;
+				std::memcpy(&chunkSize, (chunk.data() + 4), sizeof(chunkSize));
+				const int64 chunkBegin = wav.reader.getPos();
+
+				if (std::memcmp(chunk.data(), "fmt ", 4) == 0)
+				{
+					std::array<uint8, 26> fmt{};
+					const int64 readSize = Min<int64>(chunkSize, fmt.size());
+					if ((chunkSize < 16) || (wav.reader.read(fmt.data(), readSize) != readSize))
+					{
+						return false;
+					}
+
+					std::memcpy(&wav.format, (fmt.data() + 0), sizeof(uint16));
+					std::memcpy(&wav.channelCount, (fmt.data() + 2), sizeof(uint16));
+					std::memcpy(&wav.sampleRate, (fmt.data() + 4), sizeof(uint32));
+					std::memcpy(&wav.bitsPerSample, (fmt.data() + 14), sizeof(uint16));
+
+					// WAVE_FORMAT_EXTENSIBLE はサブフォーマットの GUID の先頭 2 バイトが形式
+					if ((wav.format == WavFormatExtensible) && (24 < readSize))
+					{
+						std::memcpy(&wav.format, (fmt.data() + 24), sizeof(uint16));
+					}
+					hasFormat = true;
+				}
+				else if (std::memcmp(chunk.data(), "data", 4) == 0)
+				{
+					const bool supported = (((wav.format == WavFormatPCM) && ((wav.bitsPerSample == 16) || (wav.bitsPerSample == 24)))
+						|| ((wav.format == WavFormatFloat) && (wav.bitsPerSample == 32)));
+					if ((not hasFormat) || (not supported) || (wav.channelCount == 0) || (wav.sampleRate == 0))
+					{
+						return false;
+					}
+
+					wav.dataEnd = Min((chunkBegin + static_cast<int64>(chunkSize)), wav.reader.size());
+					return true;
+				}
+
+				// チャンクは 2 バイト境界にそろえて並ぶ
+				wav.reader.setPos(chunkBegin + chunkSize + (chunkSize & 1));
+			}
+
+			return false;
+		}
+
+		// 最大 maxFrames サンプルを読み、チャンネルを平均したモノラルにして mono に書き込む（読んだサンプル数を返す）
+		size_t ReadWav(WavStream& wav, Array<float>& mono, size_t maxFrames)
+		{
+			const size_t bytesPerSample = (wav.bitsPerSample / 8);
+			const size_t frameSize = (bytesPerSample * wav.channelCount);
+			const size_t remainingFrames = static_cast<size_t>(Max<int64>((wav.dataEnd - wav.reader.getPos()), 0) / frameSize);
+			const size_t frameCount = Min(maxFrames, remainingFrames);
+
+			wav.buffer.resize(frameCount * frameSize);
+			const size_t readFrames = static_cast<size_t>(Max<int64>(wav.reader.read(wav.buffer.data(), wav.buffer.size()), 0) / frameSize);
+			mono.resize(readFrames);
+
+			const float channelScale = (1.0f / wav.channelCount);
+			for (size_t i = 0; i < readFrames; ++i)
+			{
+				const uint8* p = (wav.buffer.data() + i * frameSize);
+				float sum = 0.0f;
+
+				for (size_t channel = 0; channel < wav.channelCount; ++channel, p += bytesPerSample)
+				{
+					if (wav.format == WavFormatFloat)
+					{
+						float value;
+						std::memcpy(&value, p, sizeof(value));
+						sum += value;
+					}
+					else if (wav.bitsPerSample == 16)
+					{
+						int16 value;
+						std::memcpy(&value, p, sizeof(value));
+						sum += (value / 32768.0f);
+					}
+					else
+					{
+						// 24 ビットは上位に詰めてから符号付きで読む
+						const int32 value = static_cast<int32>((static_cast<uint32>(p[0]) << 8) | (static_cast<uint32>(p[1]) << 16) | (static_cast<uint32>(p[2]) << 24));
+						sum += (value / 2147483648.0f);
+					}
+				}
+
+				mono[i] = (sum * channelScale);
+			}
+
+			return readFrames;
+		}
+
+		// モノラルのサンプルを Config::BeatDecodeChunkFrames ずつ fn(chunk, sampleRate) に渡す（読めなければ false）
+		template <class Fn>
+		bool ForEachChunk(const FilePath& path, Fn&& fn)
+		{
+			Array<float> chunk;
+
+			if (WavStream wav; OpenWav(wav, path))
+			{
+				while (ReadWav(wav, chunk, Config::BeatDecodeChunkFrames))
+				{
+					fn(std::span<const float>{ chunk }, wav.sampleRate);
+				}
+				return true;
+			}
+
+			// Siv3D には圧縮形式を少しずつデコードする公開 API が無いので、WAV 以外はまとめてデコードする
+			const Wave wave{ path };
+			if ((not wave) || wave.isEmpty())
+			{
+				return false;
+			}
+
+			for (size_t begin = 0; begin < wave.size(); begin += Config::BeatDecodeChunkFrames)
+			{
+				chunk.resize(Min(Config::BeatDecodeChunkFrames, (wave.size() - begin)));
+				for (size_t i = 0; i < chunk.size(); ++i)
+				{
+					const auto& sample = wave.data()[begin + i];
+					chunk[i] = ((sample.left + sample.right) * 0.5f);
+				}
+				fn(std::span<const float>{ chunk }, wave.sampleRate());
+			}
+			return true;
+		}
+
+		////////////////////////////////
+		//
+		//	FFT
+		//
+		////////////////////////////////
+
+		// 基数 2 の FFT の前計算（実部と虚部を別の配列に持ち、バタフライを 4 組（AVX2 では 8 組）ずつ計算する）
+		struct FFTPlan
+		{
+			size_t size = 0;
+			Array<uint32> bitReverse;
+			Array<float> twiddleRe; // 半分の長さ h の段の回転因子は [h, 2h)
+			Array<float> twiddleIm;
+			Array<float> window;    // Hann 窓
+		};
+
+		FFTPlan CreateFFTPlan(size_t size)
+		{
+			FFTPlan plan;
+			plan.size = size;
+			plan.bitReverse.resize(size);
+			plan.twiddleRe.resize(size);
+			plan.twiddleIm.resize(size);
+			plan.window.resize(size);
+
+			const uint32 bitCount = static_cast<uint32>(std::countr_zero(size));
+			for (size_t i = 0; i < size; ++i)
+			{
+				uint32 reversed = 0;
+				for (uint32 bit = 0; bit < bitCount; ++bit)
+				{
+					reversed |= (((i >> bit) & 1) << (bitCount - 1 - bit));
+				}
+				plan.bitReverse[i] = reversed;
+				plan.window[i] = static_cast<float>(0.5 - 0.5 * std::cos(Math::TwoPi * i / size));
+			}
+
+			for (size_t half = 1; half < size; half *= 2)
+			{
+				for (size_t k = 0; k < half; ++k)
+				{
+					const double angle = (-Math::Pi * k / half);
+					plan.twiddleRe[half + k] = static_cast<float>(std::cos(angle));
+					plan.twiddleIm[half + k] = static_cast<float>(std::sin(angle));
+				}
+			}
+
+			return plan;
+		}
+
+		// その場で FFT（re, im はビット反転の順に並べ替え済み）
+		void TransformInPlace(const FFTPlan& plan, float* re, float* im)
+		{
+			for (size_t half = 1; half < plan.size; half *= 2)
+			{
+				const float* wr = (plan.twiddleRe.data() + half);
+				const float* wi = (plan.twiddleIm.data() + half);
+
+				for (size_t begin = 0; begin < plan.size; begin += (half * 2))
+				{
+					float* ar = (re + begin);
+					float* ai = (im + begin);
+					float* br = (ar + half);
+					float* bi = (ai + half);
+					size_t k = 0;
+
+#if SYNCSONG_USE_SSE
+					// FMA は使わず、スカラー版と同じ順に掛けて足す（ビルドによってビートマップが変わらないように）
+	#if defined(__AVX2__)
+					for (; (k + 8) <= half; k += 8)
+					{
+						const __m256 xr = _mm256_loadu_ps(br + k), xi = _mm256_loadu_ps(bi + k);
+						const __m256 twr = _mm256_loadu_ps(wr + k), twi = _mm256_loadu_ps(wi + k);
+						const __m256 tr = _mm256_sub_ps(_mm256_mul_ps(xr, twr), _mm256_mul_ps(xi, twi));
+						const __m256 ti = _mm256_add_ps(_mm256_mul_ps(xr, twi), _mm256_mul_ps(xi, twr));
+						const __m256 yr = _mm256_loadu_ps(ar + k), yi = _mm256_loadu_ps(ai + k);
+						_mm256_storeu_ps((ar + k), _mm256_add_ps(yr, tr));
+						_mm256_storeu_ps((ai + k), _mm256_add_ps(yi, ti));
+						_mm256_storeu_ps((br + k), _mm256_sub_ps(yr, tr));
+						_mm256_storeu_ps((bi + k), _mm256_sub_ps(yi, ti));
+					}
+	#endif
+					for (; (k + 4) <= half; k += 4)
+					{
+						const __m128 xr = _mm_loadu_ps(br + k), xi = _mm_loadu_ps(bi + k);
+						const __m128 twr = _mm_loadu_ps(wr + k), twi = _mm_loadu_ps(wi + k);
+						const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, twr), _mm_mul_ps(xi, twi));
+						const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, twi), _mm_mul_ps(xi, twr));
+						const __m128 yr = _mm_loadu_ps(ar + k), yi = _mm_loadu_ps(ai + k);
+						_mm_storeu_ps((ar + k), _mm_add_ps(yr, tr));
+						_mm_storeu_ps((ai + k), _mm_add_ps(yi, ti));
+						_mm_storeu_ps((br + k), _mm_sub_ps(yr, tr));
+						_mm_storeu_ps((bi + k), _mm_sub_ps(yi, ti));
+					}
+#endif
+
+					// 最初の 2 段（SIMD 非対応環境ではすべての段）
+					for (; k < half; ++k)
+					{
+						const float tr = (br[k] * wr[k] - bi[k] * wi[k]);
+						const float ti = (br[k] * wi[k] + bi[k] * wr[k]);
+						br[k] = (ar[k] - tr);
+						bi[k] = (ai[k] - ti);
+						ar[k] += tr;
+						ai[k] += ti;
+					}
+				}
+			}
+		}
+
+		////////////////////////////////
+		//
+		//	オンセット検出
+		//
+		////////////////////////////////
+
+		// 届いたサンプルからホップごとにスペクトルフラックスを求める
+		struct OnsetDetector
+		{
+			FFTPlan plan;
+			uint32 sampleRate = 0;
+			uint64 sampleCount = 0;
+			Array<float> pending; // まだ解析していないサンプル（最後の窓の分だけ残す）
+			Array<float> re;
+			Array<float> im;
+			Array<float> spectrum;         // 対数圧縮した振幅（0 ～ FFTSize/2）
+			Array<float> previousSpectrum;
+			Array<float> flux;             // ホップごとのスペクトルフラックス
+		};
+
+		OnsetDetector CreateOnsetDetector(uint32 sampleRate)
+		{
+			OnsetDetector detector;
+			detector.plan = CreateFFTPlan(Config::BeatFFTSize);
+			detector.sampleRate = sampleRate;
+			detector.re.resize(Config::BeatFFTSize);
+			detector.im.resize(Config::BeatFFTSize);
+			detector.spectrum.resize(Config::BeatFFTSize / 2 + 1);
+			detector.previousSpectrum.assign(detector.spectrum.size(), 0.0f);
+			return detector;
+		}
+
+		void AnalyzeFrame(OnsetDetector& detector, const float* samples)
+		{
+			const FFTPlan& plan = detector.plan;
+			for (size_t i = 0; i < plan.size; ++i)
+			{
+				detector.re[plan.bitReverse[i]] = (samples[i] * plan.window[i]);
+			}
+			std::fill(detector.im.begin(), detector.im.end(), 0.0f);
+
+			TransformInPlace(plan, detector.re.data(), detector.im.data());
+
+			// 対数圧縮した振幅の増加分だけを足す（半波整流）
+			float flux = 0.0f;
+			for (size_t k = 0; k < detector.spectrum.size(); ++k)
+			{
+				const float magnitude = std::sqrt(detector.re[k] * detector.re[k] + detector.im[k] * detector.im[k]);
+				detector.spectrum[k] = static_cast<float>(std::log1p(Config::BeatLogCompression * magnitude));
+				flux += Max((detector.spectrum[k] - detector.previousSpectrum[k]), 0.0f);
+			}
+
+			detector.flux.push_back(flux / detector.spectrum.size());
+			std::swap(detector.spectrum, detector.previousSpectrum);
+		}
+
+		void PushSamples(OnsetDetector& detector, std::span<const float> samples)
+		{
+			detector.pending.insert(detector.pending.end(), samples.begin(), samples.end());
+			detector.sampleCount += samples.size();
+
+			size_t offset = 0;
+			for (; (offset + Config::BeatFFTSize) <= detector.pending.size(); offset += Config::BeatHopSize)
+			{
+				AnalyzeFrame(detector, (detector.pending.data() + offset));
+			}
+
+			detector.pending.erase(detector.pending.begin(), (detector.pending.begin() + offset));
+		}
+
+		// 前後の平均より十分大きい極大をオンセットにする
+		void PickOnsets(const OnsetDetector& detector, BeatMap& beatMap)
+		{
+			const Array<float>& flux = detector.flux;
+			const size_t window = Config::BeatThresholdWindow;
+			const double hopSec = (static_cast<double>(Config::BeatHopSize) / detector.sampleRate);
+			const double centerSec = (static_cast<double>(Config::BeatFFTSize / 2) / detector.sampleRate);
+
+			// 区間の和を累積和で求める
+			Array<double> prefixSum(flux.size() + 1, 0.0);
+			for (size_t i = 0; i < flux.size(); ++i)
+			{
+				prefixSum[i + 1] = (prefixSum[i] + flux[i]);
+			}
+
+			double lastOnsetSec = -Config::BeatMinIntervalSec;
+			for (size_t i = 1; (i + 1) < flux.size(); ++i)
+			{
+				if ((flux[i] < flux[i - 1]) || (flux[i] <= flux[i + 1]))
+				{
+					continue;
+				}
+
+				const size_t begin = ((window < i) ? (i - window) : 0);
+				const size_t end = Min((i + window + 1), flux.size());
+				const double mean = ((prefixSum[end] - prefixSum[begin]) / (end - begin));
+				if (flux[i] <= (mean * Config::BeatThresholdScale + Config::BeatThresholdOffset))
+				{
+					continue;
+				}
+
+				const double timeSec = (i * hopSec + centerSec);
+				if (timeSec < (lastOnsetSec + Config::BeatMinIntervalSec))
+				{
+					continue;
+				}
+
+				beatMap.onsetTimes.push_back(static_cast<float>(timeSec));
+				beatMap.onsetStrengths.push_back(flux[i]);
+				lastOnsetSec = timeSec;
+			}
+		}
+	}
+
+	Optional<uint64> HashFile(const FilePath& path)
+	{
+		BinaryReader reader{ path };
+		if (not reader)
+		{
+			return none;
+		}
+
+		// チャンクの大きさは 8 の倍数なので、区切り方によらず 8 バイトずつのハッシュになる
+		static_assert((Config::BeatHashChunkSize % sizeof(uint64)) == 0);
+		Array<uint8> buffer(Config::BeatHashChunkSize);
+
+		uint64 hash = FNVOffsetBasis;
+		for (int64 readSize; 0 < (readSize = reader.read(buffer.data(), static_cast<int64>(buffer.size())));)
+		{
+			hash = HashWords(hash, buffer.data(), static_cast<size_t>(readSize));
+		}
+
+		const uint64 fileSize = static_cast<uint64>(reader.size());
+		return ((hash ^ fileSize) * FNVPrime);
+	}
+
+	FilePath GetCachePath(uint64 contentHash)
+	{
+		return (Config::BeatMapCacheDirectory + U"{:016X}.ssbm"_fmt(contentHash));
+	}
+
+	Optional<BeatMap> Analyze(const FilePath& audioPath, uint64 contentHash)
+	{
+		Optional<OnsetDetector> detector;
+
+		const bool decoded = ForEachChunk(audioPath, [&](std::span<const float> chunk, uint32 sampleRate)
+		{
+			if (not detector)
+			{
+				detector = CreateOnsetDetector(sampleRate);
+			}
+			PushSamples(*detector, chunk);
+		});
+
+		if ((not decoded) || (not detector))
+		{
+			return none;
+		}
+
+		BeatMap beatMap;
+		beatMap.contentHash = contentHash;
+		beatMap.sampleRate = detector->sampleRate;
+		beatMap.durationSec = (static_cast<double>(detector->sampleCount) / detector->sampleRate);
+		PickOnsets(*detector, beatMap);
+		return beatMap;
+	}
+
+	Optional<BeatMap> LoadCache(const FilePath& audioPath)
+	{
+		const auto contentHash = HashFile(audioPath);
+		if (not contentHash)
+		{
+			return none;
+		}
+
+		BinaryReader reader{ GetCachePath(*contentHash) };
+		if (not reader)
+		{
+			return none;
+		}
+
+		CacheHeader header;
+		if ((reader.read(&header, sizeof(header)) != static_cast<int64>(sizeof(header)))
+			|| (header.magic != Magic) || (header.version != Version) || (header.analysisKey != GetAnalysisKey())
+			|| (header.contentHash != *contentHash) || (header.sampleRate == 0)
+			|| (reader.size() != static_cast<int64>(sizeof(header) + header.onsetCount * sizeof(float) * 2)))
+		{
+			return none;
+		}
+
+		BeatMap beatMap;
+		beatMap.contentHash = header.contentHash;
+		beatMap.sampleRate = header.sampleRate;
+		beatMap.durationSec = header.durationSec;
+		beatMap.onsetTimes.resize(static_cast<size_t>(header.onsetCount));
+		beatMap.onsetStrengths.resize(static_cast<size_t>(header.onsetCount));
+
+		const int64 arraySize = static_cast<int64>(header.onsetCount * sizeof(float));
+		if ((reader.read(beatMap.onsetTimes.data(), arraySize) != arraySize)
+			|| (reader.read(beatMap.onsetStrengths.data(), arraySize) != arraySize))
+		{
+			return none;
+		}
+
+		return beatMap;
+	}
+
+	bool SaveCache(const BeatMap& beatMap)
+	{
+		FileSystem::CreateDirectories(Config::BeatMapCacheDirectory);
+
+		BinaryWriter writer{ GetCachePath(beatMap.contentHash) };
+		if (not writer)
+		{
+			return false;
+		}
+
+		CacheHeader header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.analysisKey = GetAnalysisKey();
+		header.contentHash = beatMap.contentHash;
+		header.sampleRate = beatMap.sampleRate;
+		header.durationSec = beatMap.durationSec;
+		header.onsetCount = beatMap.onsetTimes.size();
+
+		const int64 arraySize = static_cast<int64>(beatMap.onsetTimes.size() * sizeof(float));
+		return ((writer.write(&header, sizeof(header)) == static_cast<int64>(sizeof(header)))
+			&& (writer.write(beatMap.onsetTimes.data(), arraySize) == arraySize)
+			&& (writer.write(beatMap.onsetStrengths.data(), arraySize) == arraySize));
+	}
+
+	Optional<BeatMap> AnalyzeAndCache(const FilePath& audioPath)
+	{
+		const auto contentHash = HashFile(audioPath);
+		if (not contentHash)
+		{
+			return none;
+		}
+
+		auto beatMap = Analyze(audioPath, *contentHash);
+		if (beatMap)
+		{
+			SaveCache(*beatMap);
+		}
+		return beatMap;
+	}
+
+	Array<uint64> MakeYellowSlotBits(const BeatMap& beatMap, int32 uDiv, int32 vDiv)
+	{
+		const size_t slotCount = (static_cast<size_t>(uDiv) * vDiv);
+		Array<uint64> bits(((slotCount + 63) / 64), 0);
+
+		if (beatMap.onsetTimes.isEmpty())
+		{
+			for (size_t slot = 0; slot < slotCount; ++slot)
+			{
+				bits[slot / 64] |= (uint64{ 1 } << (slot % 64));
+			}
+			return bits;
+		}
+
+		// 1 列が正面を通り過ぎる時間ごとに区切る（回転角 a のとき正面にあるのは角度 -a の列）
+		// 曲が全スロットより長ければ先頭の行に戻り、強い方のオンセットを残す
+		const double slotDurationSec = (360.0 / Config::RotationSpeedDeg / uDiv);
+		Array<float> slotStrengths(slotCount, 0.0f);
+
+		for (size_t i = 0; i < beatMap.onsetTimes.size(); ++i)
+		{
+			const size_t step = (static_cast<size_t>(beatMap.onsetTimes[i] / slotDurationSec) % slotCount);
+			const size_t u = ((uDiv - (step % uDiv)) % uDiv);
+			const size_t v = ((vDiv - 1) - (step / uDiv));
+			float& strength = slotStrengths[v * uDiv + u];
+			strength = Max(strength, beatMap.onsetStrengths[i]);
+		}
+
+		Array<float> sorted = slotStrengths;
+		std::nth_element(sorted.begin(), (sorted.begin() + sorted.size() / 2), sorted.end());
+		const float median = sorted[sorted.size() / 2];
+
+		for (size_t slot = 0; slot < slotCount; ++slot)
+		{
+			if ((0.0f < slotStrengths[slot]) && (median <= slotStrengths[slot]))
+			{
+				bits[slot / 64] |= (uint64{ 1 } << (slot % 64));
+			}
+		}
+		return bits;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 曲のオンセット（拍の立ち上がり）の解析結果
+struct BeatMap
+{
+	uint64 contentHash = 0; // 解析した音声ファイルの内容のハッシュ
+	uint32 sampleRate = 0;
+	double durationSec = 0.0;
+	Array<float> onsetTimes;     // オンセットの時刻（秒、昇順）
+	Array<float> onsetStrengths; // オンセットのスペクトルフラックス
+};
+
+namespace BeatMapUtils
+{
+	// ファイルの内容のハッシュ（8 バイトずつ FNV-1a、チャンクごとに読むのでファイル全体は読み込まない）
+	Optional<uint64> HashFile(const FilePath& path);
+
+	// 内容のハッシュに対応するキャッシュのパス（Config::BeatMapCacheDirectory の下）
+	FilePath GetCachePath(uint64 contentHash);
+
+	// 音声をチャンクごとにデコードしながら FFT（AVX2/SSE）のスペクトルフラックスでオンセットを検出（読めなければ none）
+	// WAV（PCM 16/24 ビット、float）はファイルから少しずつ読む。それ以外の形式は Siv3D の Wave でデコードしてからチャンクごとに処理
+	Optional<BeatMap> Analyze(const FilePath& audioPath, uint64 contentHash);
+
+	// キャッシュを読み込む（キャッシュが無いか、形式・解析の設定・内容のハッシュが違えば none。解析はしない）
+	Optional<BeatMap> LoadCache(const FilePath& audioPath);
+
+	// キャッシュに書き出す
+	bool SaveCache(const BeatMap& beatMap);
+
+	// 解析してキャッシュに書き出す（別スレッドで呼べる）
+	Optional<BeatMap> AnalyzeAndCache(const FilePath& audioPath);
+
+	// 格子スロットを黄色で始めるかのビット列（64 スロットずつ、スロットの並びは GenerateCylinderGridPositions と同じ）
+	// 円筒が Config::RotationSpeedDeg で回るとき、正面（+X）を通る列の順に曲の区間を割り当て、1周ごとに上の行から下の行へ進む
+	// 区間内のオンセットの強さが全スロットの中央値以上なら黄色、それ以外（オンセットが無い区間を含む）は灰色。オンセットが無い曲はすべて黄色
+	Array<uint64> MakeYellowSlotBits(const BeatMap& beatMap, int32 uDiv, int32 vDiv);
+}
\ No newline at end of file
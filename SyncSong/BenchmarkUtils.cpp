@@ -0,0 +1,421 @@
+#include "BenchmarkUtils.hpp"
+#include "Config.hpp"
+#include "GeometryUtils.hpp"
+#include "GameLogic.hpp"
+#include "BVHUtils.hpp"
+#include "BoardSnapshot.hpp"
+#include "SimulationPipeline.hpp"
+
+namespace BenchmarkUtils
+{
+	namespace
+	{
+		// 盤面の球の数（20×8 の既定の格子から 100 万球まで）
+		constexpr std::array<size_t, 5> SphereCounts{ 160, 1'000, 10'000, 100'000, 1'000'000 };
+
+		// 取り外された球・灰色の球の割合の組み合わせ
+		constexpr std::array<std::pair<double, double>, 5> BoardRatios{ {
+			{ 0.0, 0.5 },
+			{ 0.1, 0.5 },
+			{ 0.5, 0.5 },
+			{ 0.1, 0.1 },
+			{ 0.1, 0.9 },
+		} };
+
+		// 1つのベンチマークにかける最低時間とサンプル数
+		constexpr double MinBenchmarkSec = 0.2;
+		constexpr size_t MinSamples = 10;
+		constexpr size_t MaxSamples = 1000;
+
+		// 1サンプルの最低時間（タイマーの分解能より十分長くする）
+		constexpr int64 MinSampleNs = 20'000;
+
+		const Size SceneSize{ 800, 600 };
+
+		// 最適化で計算が消えないように結果を書き込む先
+		volatile uint64 Sink = 0;
+
+		template <class T>
+		void Consume(const T& value)
+		{
+			uint64 bits = 0;
+			std::memcpy(&bits, &value, Min(sizeof(T), sizeof(bits)));
+			Sink = (Sink + bits);
+		}
+
+		// 合成盤面
+		struct Board
+		{
+			size_t sphereCount = 0;
+			double detachedRatio = 0.0;
+			double grayRatio = 0.0;
+			int32 uDiv = 0;
+			int32 vDiv = 0;
+			Array<Vec3> gridPositions;
+			SphereStore spheres;
+			std::unique_ptr<SpherePickIndex> pickIndex;
+			Mat4x4 transform = Mat4x4::Identity();
+		};
+
+		// 20:8 の比を保って、おおよそ sphereCount 個の格子点になる分割数を選ぶ
+		std::pair<int32, int32> GetGridDivisions(size_t sphereCount)
+		{
+			const double scale = Math::Sqrt(sphereCount / static_cast<double>(Config::GridUDiv * Config::GridVDiv));
+			const int32 uDiv = Max(static_cast<int32>(Math::Round(Config::GridUDiv * scale)), 3);
+			const int32 vDiv = Max(static_cast<int32>(Math::Round(static_cast<double>(sphereCount) / uDiv)), 2);
+			return{ uDiv, vDiv };
+		}
+
+		Board MakeBoard(size_t sphereCount, double detachedRatio, double grayRatio, SmallRNG& rng)
+		{
+			Board board;
+			board.detachedRatio = detachedRatio;
+			board.grayRatio = grayRatio;
+			std::tie(board.uDiv, board.vDiv) = GetGridDivisions(sphereCount);
+
+			board.gridPositions = GeometryUtils::GenerateCylinderGridPositions(
+				Config::CylinderRadius, Config::CylinderHeight, board.uDiv, board.vDiv, Config::GridMargin);
+
+			const size_t gridCount = board.gridPositions.size();
+			const size_t detachedCount = static_cast<size_t>(gridCount * detachedRatio);
+			board.spheres.reserve(gridCount + detachedCount);
+
+			// 取り付けられた球は格子を SoA に直接生成
+			board.spheres.assignAttached(gridCount, true);
+			GeometryUtils::GenerateCylinderGrid(Config::CylinderRadius, Config::CylinderHeight, board.uDiv, board.vDiv, Config::GridMargin,
+				board.spheres.x, board.spheres.y, board.spheres.z);
+
+			for (size_t i = 0; i < gridCount; ++i)
+			{
+				board.spheres.setYellow(i, (grayRatio <= Random(0.0, 1.0, rng)));
+			}
+
+			// 取り外された球はドラッグ平面上にばらまく
+			for (size_t i = 0; i < detachedCount; ++i)
+			{
+				const Vec3 pos{ Config::DragPlaneX, Random(-3.0, 3.0, rng), Random(-3.0, 3.0, rng) };
+				board.spheres.push_back(SphereState{ pos, false, true, static_cast<int32>(i % board.gridPositions.size()) });
+			}
+
+			board.sphereCount = board.spheres.size();
+			board.pickIndex = std::make_unique<SpherePickIndex>(Config::CylinderRadius, Config::CylinderHeight,
+				board.uDiv, board.vDiv, Config::GridMargin);
+			GameLogic::RebuildPickIndex(board.spheres, *board.pickIndex);
+			board.transform = Mat4x4::RotateZ(Random(0.0, Math::TwoPi, rng));
+			return board;
+		}
+
+		// operation(i) を繰り返し実行し、1操作あたりの時間の分布を求める
+		template <class Operation>
+		BenchmarkResult Measure(StringView name, const Board& board, double itemsPerOperation, Operation operation)
+		{
+			// 1サンプルが MinSampleNs 以上になるまで1サンプルの操作回数を倍にする
+			uint64 batchSize = 1;
+			uint64 counter = 0;
+			for (;;)
+			{
+				const Stopwatch stopwatch{ StartImmediately::Yes };
+				for (uint64 i = 0; i < batchSize; ++i)
+				{
+					operation(counter++);
+				}
+
+				if ((MinSampleNs <= stopwatch.ns()) || (batchSize >= (uint64{ 1 } << 24)))
+				{
+					break;
+				}
+				batchSize *= 2;
+			}
+
+			Array<double> samples;
+			samples.reserve(MaxSamples);
+			const Stopwatch total{ StartImmediately::Yes };
+
+			while ((samples.size() < MaxSamples) && ((samples.size() < MinSamples) || (total.sF() < MinBenchmarkSec)))
+			{
+				const Stopwatch stopwatch{ StartImmediately::Yes };
+				for (uint64 i = 0; i < batchSize; ++i)
+				{
+					operation(counter++);
+				}
+				samples.push_back(static_cast<double>(stopwatch.ns()) / batchSize);
+			}
+
+			std::sort(samples.begin(), samples.end());
+			const auto percentile = [&](double p)
+			{
+				return samples[Min(static_cast<size_t>(p * samples.size()), samples.size() - 1)];
+			};
+
+			BenchmarkResult result;
+			result.name = String{ name };
+			result.sphereCount = board.sphereCount;
+			result.detachedRatio = board.detachedRatio;
+			result.grayRatio = board.grayRatio;
+			result.operationCount = (samples.size() * batchSize);
+			result.meanNs = (std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size());
+			result.p50Ns = percentile(0.50);
+			result.p90Ns = percentile(0.90);
+			result.p99Ns = percentile(0.99);
+			result.minNs = samples.front();
+			result.maxNs = samples.back();
+			result.itemsPerOperation = itemsPerOperation;
+			return result;
+		}
+
+		// 盤面の割合に依存しない処理（格子生成・点と直線・レイと平面・盤面スナップショット）
+		void MeasureGeometry(const Board& board, SmallRNG& rng, Array<BenchmarkResult>& results)
+		{
+			const size_t gridCount = board.gridPositions.size();
+
+			results.push_back(Measure(U"GenerateCylinderGridPositions", board, static_cast<double>(gridCount), [&](uint64)
+			{
+				const Array<Vec3> positions = GeometryUtils::GenerateCylinderGridPositions(
+					Config::CylinderRadius, Config::CylinderHeight, board.uDiv, board.vDiv, Config::GridMargin);
+				Consume(positions.size());
+			}));
+
+			Array<float> xs(gridCount);
+			Array<float> ys(gridCount);
+			Array<float> zs(gridCount);
+			results.push_back(Measure(U"GenerateCylinderGrid (float SoA)", board, static_cast<double>(gridCount), [&](uint64)
+			{
+				GeometryUtils::GenerateCylinderGrid(Config::CylinderRadius, Config::CylinderHeight, board.uDiv, board.vDiv, Config::GridMargin, xs, ys, zs);
+				Consume(zs.back());
+			}));
+
+			const Vec3 lineStart{ 10, 0, 0 };
+			const Vec3 lineEnd{ Config::DragPlaneX, 0.5, 0.5 };
+
+			results.push_back(Measure(U"CalculatePointToLineDistance", board, 1.0, [&](uint64 i)
+			{
+				Consume(GeometryUtils::CalculatePointToLineDistance(board.gridPositions[i % gridCount], lineStart, lineEnd));
+			}));
+
+			// 1操作で盤面の全点を判定
+			Array<uint64> mask((board.spheres.size() + 63) / 64);
+			results.push_back(Measure(U"CalculatePointToLineDistanceMask", board, static_cast<double>(board.spheres.size()), [&](uint64)
+			{
+				GeometryUtils::CalculatePointToLineDistanceMask(board.spheres.x.data(), board.spheres.y.data(), board.spheres.z.data(),
+					board.spheres.size(), lineStart, lineEnd, Config::SnapDistance, Vec4{ 1, 0, 0, 0 }, mask);
+				Consume(mask[0]);
+			}));
+
+			Array<Ray> rays;
+			rays.reserve(1024);
+			for (size_t i = 0; i < 1024; ++i)
+			{
+				const Vec3 direction = Vec3{ Random(-1.0, -0.1, rng), Random(-1.0, 1.0, rng), Random(-1.0, 1.0, rng) }.normalized();
+				rays.push_back(Ray{ Float3{ 10, 0, 0 }, Float3{ direction } });
+			}
+
+			results.push_back(Measure(U"GetRayPlaneIntersection", board, 1.0, [&](uint64 i)
+			{
+				Consume(GeometryUtils::GetRayPlaneIntersection(rays[i % rays.size()], Config::DragPlaneX).has_value());
+			}));
+
+			// 書き出しはメインスレッドで Encode、別スレッドで Seal してから書き込む
+			Array<uint8> snapshotBytes;
+			results.push_back(Measure(U"BoardSnapshot Encode", board, static_cast<double>(board.spheres.size()), [&](uint64)
+			{
+				BoardSnapshotUtils::Encode(board.spheres, 0.0, snapshotBytes);
+				Consume(snapshotBytes.size());
+			}));
+
+			results.push_back(Measure(U"BoardSnapshot Seal", board, static_cast<double>(board.spheres.size()), [&](uint64)
+			{
+				BoardSnapshotUtils::Seal(snapshotBytes);
+				Consume(snapshotBytes[0]);
+			}));
+
+			// 読み込みはマップしたメモリを参照してから球の配列に複製する
+			SphereStore restoredSpheres;
+			results.push_back(Measure(U"BoardSnapshot MakeView + CopySpheres", board, static_cast<double>(board.spheres.size()), [&](uint64)
+			{
+				const auto view = BoardSnapshotUtils::MakeView(snapshotBytes.data(), snapshotBytes.size());
+				BoardSnapshotUtils::CopySpheres(*view, restoredSpheres);
+				Consume(restoredSpheres.size());
+			}));
+		}
+
+		// 盤面の割合に依存する処理（クリック判定・スナップ検索）
+		void MeasureLogic(const Board& board, SmallRNG& rng, FrameArena& arena, Array<BenchmarkResult>& results)
+		{
+			const BasicCamera3D camera{ SceneSize, 45_deg, Vec3{ 10, 0, 0 } };
+			const Vec3 playerPos = camera.getEyePosition();
+
+			Array<Vec2> clickPositions(1024);
+			for (Vec2& pos : clickPositions)
+			{
+				pos = Vec2{ Random(0.0, static_cast<double>(SceneSize.x), rng), Random(0.0, static_cast<double>(SceneSize.y), rng) };
+			}
+
+			results.push_back(Measure(U"CheckSphereClick", board, 1.0, [&](uint64 i)
+			{
+				arena.reset();
+				Consume(GameLogic::CheckSphereClick(clickPositions[i % clickPositions.size()], board.spheres, *board.pickIndex,
+					camera, board.transform, arena).value_or(-1));
+			}));
+
+			Array<Vec3> draggedPositions(1024);
+			for (Vec3& pos : draggedPositions)
+			{
+				pos = Vec3{ Config::DragPlaneX, Random(-2.5, 2.5, rng), Random(-2.5, 2.5, rng) };
+			}
+
+			results.push_back(Measure(U"FindSnapTarget", board, static_cast<double>(board.spheres.size()), [&](uint64 i)
+			{
+				Consume(GameLogic::FindSnapTarget(draggedPositions[i % draggedPositions.size()], board.spheres, -1,
+					playerPos, board.transform).value_or(-1));
+			}));
+
+			results.push_back(Measure(U"GetSnapCandidates", board, static_cast<double>(board.spheres.size()), [&](uint64 i)
+			{
+				arena.reset();
+				Consume(GameLogic::GetSnapCandidates(draggedPositions[i % draggedPositions.size()], board.spheres, -1,
+					playerPos, board.transform, arena).size());
+			}));
+		}
+
+		// 球をドラッグしている間の1フレーム（60 fps で 120 Hz のティックを2回）を、ロジックを描画と同じスレッドで進めた場合と別スレッドで進めた場合で計測
+		// 描画の代わりに描画する状態の球を一度ずつ読む（インスタンスの書き込みと同じく球の数に比例する）。1操作はメインスレッドの時間
+		void MeasurePipeline(const Board& board, SmallRNG& rng, FrameArena& arena, Array<BenchmarkResult>& results)
+		{
+			const BasicCamera3D camera{ SceneSize, 45_deg, Vec3{ 10, 0, 0 } };
+
+			GameState state;
+			state.gridPositions = board.gridPositions;
+			state.spheres = board.spheres;
+			state.pickIndex = *board.pickIndex;
+
+			// 黄色の球を掴んだ状態から始める
+			FrameInput press;
+			press.deltaTime = (1.0 / Config::LogicTickRate);
+			press.eyePosition = camera.getEyePosition();
+			for (size_t attempt = 0; attempt < 1000; ++attempt)
+			{
+				const Vec2 pos{ Random(0.0, static_cast<double>(SceneSize.x), rng), Random(0.0, static_cast<double>(SceneSize.y), rng) };
+				const auto index = GameLogic::CheckSphereClick(pos, state.spheres, state.pickIndex, camera, Mat4x4::Identity(), arena);
+				arena.reset();
+				if (index && state.spheres.isYellow(*index))
+				{
+					press.mouseLDown = press.mouseLPressed = true;
+					press.cursorPos = press.mouseLDownPos = pos;
+					break;
+				}
+			}
+			GameLogic::UpdateGameState(state, press, camera, arena);
+
+			// カーソルを円を描くように動かし続ける
+			const auto makeTicks = [&](uint64 frame)
+			{
+				std::array<FrameInput, 2> ticks;
+				for (size_t k = 0; k < ticks.size(); ++k)
+				{
+					const double t = ((frame * ticks.size() + k) * 0.05);
+					FrameInput& tick = ticks[k];
+					tick.deltaTime = press.deltaTime;
+					tick.eyePosition = press.eyePosition;
+					tick.mouseLPressed = press.mouseLPressed;
+					tick.cursorPos = (press.cursorPos + Vec2{ Math::Cos(t), Math::Sin(t) } * 40.0);
+				}
+				return ticks;
+			};
+
+			Array<uint8> renderBytes;
+			results.push_back(Measure(U"Frame (serial, dragging)", board, static_cast<double>(board.spheres.size()), [&](uint64 i)
+			{
+				for (const FrameInput& tick : makeTicks(i))
+				{
+					arena.reset();
+					GameLogic::UpdateGameState(state, tick, camera, arena);
+				}
+				BoardSnapshotUtils::Encode(state.spheres, state.rotationAngle, renderBytes);
+				Consume(renderBytes.size());
+			}));
+
+			const auto pipeline = std::make_unique<SimulationPipeline>();
+			SimulationPipelineUtils::Start(*pipeline, state, camera);
+			results.push_back(Measure(U"Frame (pipelined, dragging)", board, static_cast<double>(board.spheres.size()), [&](uint64 i)
+			{
+				const SceneSnapshot& snapshot = SimulationPipelineUtils::AcquireSnapshot(*pipeline);
+				for (const FrameInput& tick : makeTicks(i))
+				{
+					SimulationPipelineUtils::Submit(*pipeline, tick);
+				}
+				BoardSnapshotUtils::Encode(snapshot.spheres, snapshot.rotationAngle, renderBytes);
+				Consume(renderBytes.size());
+			}));
+			SimulationPipelineUtils::Stop(*pipeline);
+
+			// ロジックのスレッドで毎回行う複製（球が変わったときと、回転だけのとき）
+			SceneSnapshot snapshot;
+			const TickInterpolation previousTick = FixedTimestepUtils::CaptureTickState(state);
+			results.push_back(Measure(U"CopySnapshot (spheres changed)", board, static_cast<double>(board.spheres.size()), [&](uint64 i)
+			{
+				++state.spheres.revision;
+				SimulationPipelineUtils::CopySnapshot(snapshot, state, previousTick, i);
+				Consume(snapshot.spheres.size());
+			}));
+
+			results.push_back(Measure(U"CopySnapshot (rotation only)", board, static_cast<double>(board.spheres.size()), [&](uint64 i)
+			{
+				state.rotationAngle += 0.01;
+				SimulationPipelineUtils::CopySnapshot(snapshot, state, previousTick, i);
+				Consume(snapshot.rotationAngle);
+			}));
+		}
+	}
+
+	Array<BenchmarkResult> RunAll()
+	{
+		Array<BenchmarkResult> results;
+		SmallRNG rng{ 12345 };
+		FrameArena arena{ Config::FrameArenaSize };
+
+		for (const size_t sphereCount : SphereCounts)
+		{
+			for (size_t ratioIndex = 0; ratioIndex < BoardRatios.size(); ++ratioIndex)
+			{
+				const auto [detachedRatio, grayRatio] = BoardRatios[ratioIndex];
+				const Board board = MakeBoard(sphereCount, detachedRatio, grayRatio, rng);
+
+				if (ratioIndex == 0)
+				{
+					MeasureGeometry(board, rng, results);
+					MeasurePipeline(board, rng, arena, results);
+				}
+
+				MeasureLogic(board, rng, arena, results);
+			}
+		}
+
+		return results;
+	}
+
+	String ToJSONLine(const BenchmarkResult& result)
+	{
+		const double opsPerSec = (1e9 / result.meanNs);
+		return U"{{\"benchmark\":\"{}\",\"spheres\":{},\"detached_ratio\":{},\"gray_ratio\":{},\"ops\":{},"
+			U"\"ns_per_op\":{:.2f},\"p50_ns\":{:.2f},\"p90_ns\":{:.2f},\"p99_ns\":{:.2f},\"min_ns\":{:.2f},\"max_ns\":{:.2f},"
+			U"\"ops_per_sec\":{:.1f},\"items_per_sec\":{:.1f}}}"_fmt(
+				result.name, result.sphereCount, result.detachedRatio, result.grayRatio, result.operationCount,
+				result.meanNs, result.p50Ns, result.p90Ns, result.p99Ns, result.minNs, result.maxNs,
+				opsPerSec, (opsPerSec * result.itemsPerOperation));
+	}
+
+	bool Save(const FilePath& path, const Array<BenchmarkResult>& results)
+	{
+		TextWriter writer{ path };
+		if (not writer)
+		{
+			return false;
+		}
+
+		for (const BenchmarkResult& result : results)
+		{
+			writer.writeln(ToJSONLine(result));
+		}
+		return true;
+	}
+}
\ No newline at end of file
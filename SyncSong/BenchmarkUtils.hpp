@@ -0,0 +1,31 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 1つのベンチマークの結果（1操作あたりの時間の分布）
+struct BenchmarkResult
+{
+	String name;
+	size_t sphereCount = 0;
+	double detachedRatio = 0.0; // 取り付けられた球に対する取り外された球の割合
+	double grayRatio = 0.0;     // 取り付けられた球のうち灰色の割合
+	uint64 operationCount = 0;  // 計測した操作の総数
+	double meanNs = 0.0;
+	double p50Ns = 0.0;
+	double p90Ns = 0.0;
+	double p99Ns = 0.0;
+	double minNs = 0.0;
+	double maxNs = 0.0;
+	double itemsPerOperation = 1.0; // スループット計算用（1操作で処理する点・球の数）
+};
+
+namespace BenchmarkUtils
+{
+	// 20×8 の既定の格子から 100 万球まで、取り外し・灰色の割合を変えた盤面で各処理を計測
+	Array<BenchmarkResult> RunAll();
+
+	// 結果を1行1件の JSON（JSON Lines）にする
+	String ToJSONLine(const BenchmarkResult& result);
+
+	// すべての結果を JSON Lines でファイルに書き出す
+	bool Save(const FilePath& path, const Array<BenchmarkResult>& results);
+}
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "BoardSnapshot.hpp"
+#include "Config.hpp"
+
+namespace BoardSnapshotUtils
+{
+	namespace
+	{
+		// ファイルの内容をそのまま参照するので、ビッグエンディアンの環境には対応しない
+		static_assert(std::endian::native == std::endian::little);
+
+		constexpr std::array<uint8, 4> Magic{ 'S', 'S', 'B', 'S' };
+		constexpr uint32 Version = 1;
+
+		// 配列の境界（キャッシュラインと SIMD のロードに合わせる）
+		constexpr size_t SectionAlignment = 64;
+
+		constexpr uint64 FNVOffsetBasis = 14695981039346656037ull;
+		constexpr uint64 FNVPrime = 1099511628211ull;
+
+		size_t AlignUp(size_t value)
+		{
+			return ((value + SectionAlignment - 1) / SectionAlignment * SectionAlignment);
+		}
+
+		size_t GetWordCount(size_t sphereCount)
+		{
+			return ((sphereCount + 63) / 64);
+		}
+
+		// 8 バイトずつ FNV-1a（100 万球でも数ミリ秒で終わるように）
+		uint64 HashPayload(std::span<const uint8> payload)
+		{
+			uint64 hash = FNVOffsetBasis;
+			for (size_t i = 0; (i + sizeof(uint64)) <= payload.size(); i += sizeof(uint64))
+			{
+				uint64 word;
+				std::memcpy(&word, (payload.data() + i), sizeof(word));
+				hash = ((hash ^ word) * FNVPrime);
+			}
+			return hash;
+		}
+
+		// 配列の範囲がファイルに収まり、境界がそろっているか
+		template <class T>
+		Optional<std::span<const T>> GetSection(const uint8* data, size_t size, uint64 offset, size_t count)
+		{
+			if (((offset % SectionAlignment) != 0) || (size < offset) || (((size - offset) / sizeof(T)) < count))
+			{
+				return none;
+			}
+			return std::span<const T>{ reinterpret_cast<const T*>(data + offset), count };
+		}
+
+		// 配列を書き込み、次の 64 バイト境界までの隙間を 0 で埋める
+		template <class T>
+		void WriteSection(Array<uint8>& bytes, uint64 offset, const Array<T>& values)
+		{
+			const size_t byteCount = (values.size() * sizeof(T));
+			std::memcpy((bytes.data() + offset), values.data(), byteCount);
+			std::memset((bytes.data() + offset + byteCount), 0, (AlignUp(offset + byteCount) - (offset + byteCount)));
+		}
+	}
+
+	void Encode(const SphereStore& spheres, double rotationAngle, Array<uint8>& bytes)
+	{
+		const size_t sphereCount = spheres.size();
+		const size_t wordCount = GetWordCount(sphereCount);
+
+		BoardSnapshotHeader header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.headerSize = sizeof(BoardSnapshotHeader);
+		header.sphereCount = sphereCount;
+		header.rotationAngle = rotationAngle;
+		header.cylinderRadius = Config::CylinderRadius;
+		header.cylinderHeight = Config::CylinderHeight;
+		header.gridMargin = Config::GridMargin;
+		header.gridUDiv = Config::GridUDiv;
+		header.gridVDiv = Config::GridVDiv;
+
+		// 配列をヘッダの後ろに 64 バイト境界で並べる
+		size_t offset = AlignUp(sizeof(BoardSnapshotHeader));
+		const auto place = [&](size_t byteCount)
+		{
+			const size_t sectionOffset = offset;
+			offset = AlignUp(offset + byteCount);
+			return sectionOffset;
+		};
+		header.xOffset = place(sphereCount * sizeof(float));
+		header.yOffset = place(sphereCount * sizeof(float));
+		header.zOffset = place(sphereCount * sizeof(float));
+		header.attachedBitsOffset = place(wordCount * sizeof(uint64));
+		header.yellowBitsOffset = place(wordCount * sizeof(uint64));
+		header.originalIndexOffset = place(sphereCount * sizeof(int32));
+		header.fileSize = offset;
+
+		// 使い回す bytes は前の内容が残るので、境界合わせの隙間は WriteSection で 0 にする（ハッシュを決定的にするため）
+		bytes.resize(header.fileSize);
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		WriteSection(bytes, header.xOffset, spheres.x);
+		WriteSection(bytes, header.yOffset, spheres.y);
+		WriteSection(bytes, header.zOffset, spheres.z);
+		WriteSection(bytes, header.attachedBitsOffset, spheres.attachedBits);
+		WriteSection(bytes, header.yellowBitsOffset, spheres.yellowBits);
+		WriteSection(bytes, header.originalIndexOffset, spheres.originalIndex);
+	}
+
+	void Seal(Array<uint8>& bytes)
+	{
+		BoardSnapshotHeader header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		header.payloadHash = HashPayload(std::span<const uint8>{ (bytes.data() + header.headerSize), (bytes.size() - header.headerSize) });
+		std::memcpy(bytes.data(), &header, sizeof(header));
+	}
+
+	bool Save(const FilePath& path, Array<uint8>& bytes)
+	{
+		Seal(bytes);
+
+		BinaryWriter writer{ path };
+		if (not writer)
+		{
+			return false;
+		}
+
+		return (writer.write(bytes.data(), bytes.size()) == static_cast<int64>(bytes.size()));
+	}
+
+	Optional<BoardSnapshotView> MakeView(const uint8* data, size_t size)
+	{
+		// ヘッダはファイル先頭に置くので、マップしたメモリの境界のまま参照できる
+		if ((data == nullptr) || (size < sizeof(BoardSnapshotHeader))
+			|| ((reinterpret_cast<uintptr_t>(data) % alignof(BoardSnapshotHeader)) != 0))
+		{
+			return none;
+		}
+
+		const BoardSnapshotHeader* header = reinterpret_cast<const BoardSnapshotHeader*>(data);
+		if ((header->magic != Magic) || (header->version != Version)
+			|| (header->headerSize != sizeof(BoardSnapshotHeader)) || (header->fileSize != size))
+		{
+			return none;
+		}
+
+		const size_t sphereCount = static_cast<size_t>(header->sphereCount);
+		const size_t wordCount = GetWordCount(sphereCount);
+
+		const auto x = GetSection<float>(data, size, header->xOffset, sphereCount);
+		const auto y = GetSection<float>(data, size, header->yOffset, sphereCount);
+		const auto z = GetSection<float>(data, size, header->zOffset, sphereCount);
+		const auto attachedBits = GetSection<uint64>(data, size, header->attachedBitsOffset, wordCount);
+		const auto yellowBits = GetSection<uint64>(data, size, header->yellowBitsOffset, wordCount);
+		const auto originalIndex = GetSection<int32>(data, size, header->originalIndexOffset, sphereCount);
+
+		if ((not x) || (not y) || (not z) || (not attachedBits) || (not yellowBits) || (not originalIndex))
+		{
+			return none;
+		}
+
+		return BoardSnapshotView{ header, *x, *y, *z, *attachedBits, *yellowBits, *originalIndex,
+			std::span<const uint8>{ (data + header->headerSize), (size - header->headerSize) } };
+	}
+
+	bool Open(BoardSnapshotFile& snapshot, const FilePath& path)
+	{
+		snapshot.view = BoardSnapshotView{};
+
+		if (not snapshot.file.open(path))
+		{
+			return false;
+		}
+
+		const MemoryMappedFileView::MappedMemory memory = snapshot.file.mapAll();
+		if (const auto view = MakeView(reinterpret_cast<const uint8*>(memory.data), memory.size))
+		{
+			snapshot.view = *view;
+			return true;
+		}
+
+		snapshot.file.close();
+		return false;
+	}
+
+	Array<String> Validate(const BoardSnapshotView& view)
+	{
+		Array<String> problems;
+		const BoardSnapshotHeader& header = *view.header;
+
+		if (const uint64 hash = HashPayload(view.payload); hash != header.payloadHash)
+		{
+			problems.push_back(U"payload hash mismatch (header {:016X}, actual {:016X})"_fmt(header.payloadHash, hash));
+		}
+
+		// 球の数を超えるビットは 0
+		if (const size_t remaining = (header.sphereCount % 64); (remaining != 0) && (not view.attachedBits.empty()))
+		{
+			const uint64 unusedMask = ~((uint64{ 1 } << remaining) - 1);
+			if ((view.attachedBits.back() & unusedMask) || (view.yellowBits.back() & unusedMask))
+			{
+				problems.push_back(U"flag bits are set beyond the sphere count");
+			}
+		}
+
+		if ((header.gridUDiv <= 0) || (header.gridVDiv <= 1))
+		{
+			problems.push_back(U"invalid grid divisions {}x{}"_fmt(header.gridUDiv, header.gridVDiv));
+			return problems;
+		}
+
+		// 取り付けられている球は格子スロットを1つずつ占める
+		const size_t slotCount = (static_cast<size_t>(header.gridUDiv) * header.gridVDiv);
+		Array<uint8> occupied(slotCount, 0);
+		size_t outOfRangeCount = 0;
+		size_t duplicateCount = 0;
+
+		for (size_t i = 0; i < header.sphereCount; ++i)
+		{
+			if (((view.attachedBits[i / 64] >> (i % 64)) & 1) == 0)
+			{
+				continue;
+			}
+
+			const int32 slot = view.originalIndex[i];
+			if ((slot < 0) || (slotCount <= static_cast<size_t>(slot)))
+			{
+				++outOfRangeCount;
+			}
+			else if (occupied[slot]++)
+			{
+				++duplicateCount;
+			}
+		}
+
+		if (outOfRangeCount)
+		{
+			problems.push_back(U"{} attached spheres have a grid slot out of range"_fmt(outOfRangeCount));
+		}
+
+		if (duplicateCount)
+		{
+			problems.push_back(U"{} attached spheres share a grid slot"_fmt(duplicateCount));
+		}
+
+		return problems;
+	}
+
+	void CopySpheres(const BoardSnapshotView& view, SphereStore& spheres)
+	{
+		// 取り付けた状態で作り直してから配列を上書き（ハンドルはインデックスの順に振り直される）
+		spheres.assignAttached(view.header->sphereCount, false);
+		std::memcpy(spheres.x.data(), view.x.data(), view.x.size_bytes());
+		std::memcpy(spheres.y.data(), view.y.data(), view.y.size_bytes());
+		std::memcpy(spheres.z.data(), view.z.data(), view.z.size_bytes());
+		std::memcpy(spheres.attachedBits.data(), view.attachedBits.data(), view.attachedBits.size_bytes());
+		std::memcpy(spheres.yellowBits.data(), view.yellowBits.data(), view.yellowBits.size_bytes());
+		std::memcpy(spheres.originalIndex.data(), view.originalIndex.data(), view.originalIndex.size_bytes());
+	}
+
+	bool Restore(GameState& state, const BoardSnapshotView& view)
+	{
+		const BoardSnapshotHeader& header = *view.header;
+
+		// 格子はコンパイル時に作っているので、違う設定の盤面は読めない
+		if ((header.cylinderRadius != Config::CylinderRadius) || (header.cylinderHeight != Config::CylinderHeight)
+			|| (header.gridMargin != Config::GridMargin) || (header.gridUDiv != Config::GridUDiv) || (header.gridVDiv != Config::GridVDiv))
+		{
+			return false;
+		}
+
+		// 格子スロットが壊れているとピッキング用インデックスを作れない
+		if (not Validate(view).isEmpty())
+		{
+			return false;
+		}
+
+		CopySpheres(view, state.spheres);
+		GameLogic::RebuildPickIndex(state.spheres, state.pickIndex);
+		state.dragState = DragState{};
+		state.rotationAngle = header.rotationAngle;
+		EditHistoryUtils::Clear(state.history);
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <Siv3D.hpp>
+#include "SphereStore.hpp"
+#include "GameLogic.hpp"
+
+// 盤面スナップショットのファイル先頭のヘッダ（リトルエンディアン、ファイルの内容をそのまま参照する）
+// ヘッダの後ろに球の配列を 64 バイト境界に並べて置くので、マップしたファイルを解析せずにそのまま使える
+struct BoardSnapshotHeader
+{
+	std::array<uint8, 4> magic;
+	uint32 version;
+	uint32 headerSize;
+	uint32 reserved;
+	uint64 sphereCount;
+	uint64 fileSize;
+	uint64 payloadHash; // ヘッダより後ろの 8 バイトごとの FNV-1a
+
+	double rotationAngle;
+	double cylinderRadius;
+	double cylinderHeight;
+	double gridMargin;
+	int32 gridUDiv;
+	int32 gridVDiv;
+
+	// 配列の位置（ファイル先頭からのバイト数）
+	uint64 xOffset;             // float × sphereCount
+	uint64 yOffset;             // float × sphereCount
+	uint64 zOffset;             // float × sphereCount
+	uint64 attachedBitsOffset;  // uint64 × (sphereCount + 63) / 64
+	uint64 yellowBitsOffset;    // uint64 × (sphereCount + 63) / 64
+	uint64 originalIndexOffset; // int32 × sphereCount
+};
+static_assert(sizeof(BoardSnapshotHeader) == 128);
+static_assert(std::is_trivially_copyable_v<BoardSnapshotHeader>);
+
+// メモリ上の盤面スナップショット（マップしたファイルなど）を参照する（元のメモリが有効な間だけ使える）
+struct BoardSnapshotView
+{
+	const BoardSnapshotHeader* header = nullptr;
+	std::span<const float> x;
+	std::span<const float> y;
+	std::span<const float> z;
+	std::span<const uint64> attachedBits;
+	std::span<const uint64> yellowBits;
+	std::span<const int32> originalIndex;
+	std::span<const uint8> payload; // ヘッダより後ろ（ハッシュの対象）
+};
+
+// マップした盤面スナップショットのファイル（閉じるまで view が有効）
+struct BoardSnapshotFile
+{
+	MemoryMappedFileView file;
+	BoardSnapshotView view;
+};
+
+namespace BoardSnapshotUtils
+{
+	// 球の状態と回転角をファイルの内容にして bytes に書き込む（格子の設定は Config のもの）
+	// 配列を複製するだけなので、bytes を使い回せば 100 万球でも数ミリ秒。ハッシュは Seal で書き込む
+	void Encode(const SphereStore& spheres, double rotationAngle, Array<uint8>& bytes);
+
+	// Encode した内容のハッシュを計算してヘッダに書き込む
+	void Seal(Array<uint8>& bytes);
+
+	// Encode した内容を Seal してファイルに書き出す（描画と並行して別スレッドで呼べる）
+	bool Save(const FilePath& path, Array<uint8>& bytes);
+
+	// ヘッダと配列の範囲・境界だけを確かめて参照を作る（内容は読まないので球の数によらず一定時間）
+	Optional<BoardSnapshotView> MakeView(const uint8* data, size_t size);
+
+	// ファイルをマップして参照を作る（形式が違えば false）
+	bool Open(BoardSnapshotFile& snapshot, const FilePath& path);
+
+	// 内容まで検証し、見つかった問題を返す（ハッシュ、フラグの余りのビット、格子スロットの範囲と重複）
+	Array<String> Validate(const BoardSnapshotView& view);
+
+	// 球の状態を view の内容で置き換える（ハンドルは振り直す）
+	void CopySpheres(const BoardSnapshotView& view, SphereStore& spheres);
+
+	// ゲーム状態を view の内容で置き換える（格子の設定が Config と違うか、Validate で問題が見つかれば何もせず false）
+	bool Restore(GameState& state, const BoardSnapshotView& view);
+}
\ No newline at end of file
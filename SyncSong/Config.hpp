@@ -3,32 +3,106 @@
 
 namespace Config
 {
-	// EBhEݒ
+	// ウィンドウ設定
 	constexpr Size WindowSize{ 800, 600 };
 	const ColorF BackgroundColor{ 0.8, 0.9, 1.0 };
 
-	// ~ݒ
+	// 円筒設定
 	constexpr double CylinderRadius = 2.0;
 	constexpr double CylinderHeight = 6.0;
+	constexpr int32 CylinderMeshQuality = 24; // 円筒のメッシュの分割数（カリングでも遮蔽物の大きさに使う）
 
-	// Of[Vݒ
+	// グラデーション設定
 	constexpr int32 GradientHeight = 256;
 	const ColorF TopColor{ 0.4, 0.2, 0.8 };
 	const ColorF BottomColor{ 0.8, 0.4, 0.6 };
 
-	// ]ݒ
+	// 回転設定
 	constexpr double RotationSpeedDeg = 15.0;
 	constexpr double MouseRotationFactor = -0.3;
 
-	// Obhݒ
+	// 音楽同期設定（[M] または --music <path> で音楽の再生位置から回転を進める）
+	const FilePath MusicPath = U"example/test.mp3";
+	constexpr double AudioOutputLatencySec = 0.02;   // 再生位置から実際に聞こえるまでの遅延（--audio-latency <ms> で変更）
+	constexpr int32 AudioClockPollIntervalUs = 250;  // 再生位置を読み取る間隔
+	constexpr double AudioClockCorrectionGain = 0.1; // 報告との差を1回の報告で補正する割合
+	constexpr double AudioResyncThresholdSec = 0.1;  // 報告との差がこれ以上なら（ループ・シーク）合わせ直す
+	constexpr size_t AudioSyncLogCapacity = (1 << 16); // 記録する同期誤差の最大件数
+	const FilePath AudioSyncLogPath = U"audio_sync.csv";
+
+	// 拍の解析設定（曲のオンセットから灰色・黄色の初期配置を決める。結果は曲の内容のハッシュごとにキャッシュ）
+	constexpr size_t BeatFFTSize = 1024;                // 2 の累乗
+	constexpr size_t BeatHopSize = 512;
+	constexpr size_t BeatDecodeChunkFrames = (1 << 16); // 1 回にデコードするサンプル数
+	constexpr size_t BeatHashChunkSize = (1 << 20);     // 内容のハッシュを求めるときに 1 回に読むバイト数（8 の倍数）
+	constexpr double BeatLogCompression = 1.0;          // 振幅を log(1 + c|X|) で圧縮
+	constexpr size_t BeatThresholdWindow = 8;           // 適応しきい値に使う前後のホップ数
+	constexpr double BeatThresholdScale = 1.5;          // 前後の平均のこの倍を超えた極大をオンセットにする
+	constexpr double BeatThresholdOffset = 0.01;        // 無音に近い区間で小さな揺れを拾わないための下駄
+	constexpr double BeatMinIntervalSec = 0.1;          // オンセットの最小間隔
+	const FilePath BeatMapCacheDirectory = U"beatmap_cache/";
+
+	// グリッド設定
 	constexpr int32 GridUDiv = 20;
 	constexpr int32 GridVDiv = 8;
 	constexpr double GridMargin = 1.0;
+	constexpr size_t GridParallelThreshold = (1 << 16); // 格子点がこれ以上なら行ごとに並列に生成
+
+	// ロジックのティック設定（描画のフレームレートによらず固定間隔でロジックを進め、描画はティックの間を補間する）
+	constexpr double LogicTickRate = 120.0;     // 1秒あたりのティック数（--tick-rate <hz> で変更）
+	constexpr size_t MaxLogicTicksPerFrame = 8; // 1フレームで進めるティックの上限（追いつけない分の時間は捨てる）
 
-	// ̐ݒ
+	// 球の設定
 	constexpr double SphereRadius = 0.1;
 	constexpr double SnapDistance = 0.2;
+	constexpr double SnapRecomputeEpsilon = 1e-4; // ドラッグ中、直線と回転がこれ以上変化したらスナップ候補を再計算
 
-	// hbOݒ
+	// ドラッグ設定
 	constexpr double DragPlaneX = 3.0;
+
+	// 元に戻す・やり直し設定（[Ctrl+Z] / [Ctrl+Y]。ドラッグ&ドロップ1回分の差分を1ステップとして記録する）
+	constexpr size_t EditHistoryByteBudget = (1 << 20); // 履歴に使うバイト数（--undo-budget <KiB> で変更。超えたら古いステップから捨てる）
+
+	// 入力設定（マウスの左ボタンをフレームの間も読み取り、押した・離した瞬間の位置と時刻で判定する。--no-input-sampler で無効）
+	constexpr int32 InputPollIntervalUs = 500;       // ボタンとカーソルを読み取る間隔（Windows のみ）
+	constexpr size_t ClickLatencyLogCapacity = 4096; // 記録するクリックから強調表示までの遅延の最大件数
+
+	// 描画設定
+	constexpr int32 SphereBatchChunkSize = 1024; // 球のバッチ描画で1ドローコールにまとめる球の数
+	constexpr int32 SphereBatchAngleBuckets = 256; // バッチ内の位置を円筒上の角度順に並べるときの区切りの数
+	constexpr uint32 SphereMeshQuality = 12;
+	constexpr std::array<uint32, 4> SphereLodQualities{ SphereMeshQuality, 8, 5, 3 }; // LOD ごとの球のメッシュの分割数（[0] が最も細かい）
+	constexpr std::array<double, 3> SphereLodMinRadiusPixels{ 12.0, 6.0, 3.0 }; // 画面上の半径がこれ以上なら LOD [i] を使う
+	constexpr double SphereLodHysteresis = 0.15; // LOD を切り替える閾値の幅（ちらつき防止）
+
+	// 動的解像度設定（--dynamic-resolution または [R] で有効）
+	constexpr std::array<double, 4> DynamicResolutionScales{ 1.0, 0.85, 0.7, 0.5 }; // 描画先の倍率（[0] は等倍）
+	constexpr double DynamicResolutionTargetFPS = 60.0;
+	constexpr double DynamicResolutionDownscaleMargin = 0.1; // フレーム時間が目標のこの割合を超えて長ければ解像度を下げる
+	constexpr double DynamicResolutionUpscaleHeadroom = 0.6; // CPU 処理時間が目標のこの割合未満なら解像度を上げる
+	constexpr double DynamicResolutionSmoothing = 0.1;       // フレーム時間の指数移動平均の係数
+	constexpr int32 DynamicResolutionCooldownFrames = 30;    // 倍率を切り替えてから次に切り替えるまでのフレーム数
+	constexpr TextureFilter DynamicResolutionUpscaleFilter = TextureFilter::Linear;
+	constexpr uint32 MSAASampleCount = 4; // 1: MSAA なし、4: 4x MSAA（Siv3D の MSRenderTexture は 4x 固定）
+
+	// メモリ設定
+	constexpr size_t FrameArenaSize = (64 * 1024); // フレームごとの一時データ用アリーナの初期容量（バイト）
+
+	// プロファイラ設定
+	constexpr size_t ProfilerFrameCount = 1024; // 処理段階ごとの時間を保持するフレーム数
+	constexpr size_t ProfilerHistogramBinCount = 40;
+	constexpr double ProfilerHistogramMaxMs = 40.0; // ヒストグラムの上限（これ以上は最後のビンに入れる）
+	const FilePath ProfilerCSVPath = U"frame_profile.csv";
+	constexpr double SaveMessageDurationSec = 3.0; // ファイルの書き出しなどの結果を表示する時間（[P] のオーバーレイ表示中は常に表示）
+
+	// トレース設定（SYNCSONG_ENABLE_TRACING を定義したビルドのみ）
+	constexpr size_t TraceEventCapacity = (1 << 20); // 1回の記録で保持する区間の最大数
+	constexpr uint64 TraceFrameCount = 120; // [T] で記録するフレーム数
+	const FilePath TraceOutputPath = U"trace.json";
+
+	// 盤面スナップショット設定（[F5] で書き出し、[F6] で読み込み）
+	const FilePath BoardSnapshotPath = U"board.ssbs";
+
+	// ピッキング設定
+	constexpr double BVHFatMargin = 0.1; // 取り外された球のBVHで葉のAABBを広げる量
 }
\ No newline at end of file
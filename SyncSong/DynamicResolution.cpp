@@ -0,0 +1,119 @@
+#include "DynamicResolution.hpp"
+#include "Config.hpp"
+#include "FrameProfiler.hpp"
+#include "FrameTracer.hpp"
+
+namespace DynamicResolutionUtils
+{
+	DynamicResolution Create(const Size& baseSize, uint32 sampleCount)
+	{
+		DynamicResolution resolution;
+		resolution.sampleCount = ((1 < sampleCount) ? 4 : 1);
+
+		for (const double scale : Config::DynamicResolutionScales)
+		{
+			const Size size = Size{ Max(static_cast<int32>(baseSize.x * scale), 1), Max(static_cast<int32>(baseSize.y * scale), 1) };
+			resolution.scales.push_back(scale);
+
+			if (1 < resolution.sampleCount)
+			{
+				resolution.msTargets.emplace_back(size, TextureFormat::R8G8B8A8_Unorm_SRGB, HasDepth::Yes);
+			}
+			else
+			{
+				resolution.targets.emplace_back(size, TextureFormat::R8G8B8A8_Unorm_SRGB, HasDepth::Yes);
+			}
+		}
+
+		return resolution;
+	}
+
+	void SetEnabled(DynamicResolution& resolution, bool enabled)
+	{
+		resolution.enabled = enabled;
+		resolution.scaleIndex = 0;
+		resolution.framesSinceChange = 0;
+	}
+
+	void Update(DynamicResolution& resolution, double frameTimeSec, double workTimeSec)
+	{
+		const double frameMs = (frameTimeSec * 1000.0);
+		const double workMs = (workTimeSec * 1000.0);
+
+		if (resolution.averageFrameMs == 0.0)
+		{
+			resolution.averageFrameMs = frameMs;
+			resolution.averageWorkMs = workMs;
+		}
+		else
+		{
+			resolution.averageFrameMs += ((frameMs - resolution.averageFrameMs) * Config::DynamicResolutionSmoothing);
+			resolution.averageWorkMs += ((workMs - resolution.averageWorkMs) * Config::DynamicResolutionSmoothing);
+		}
+
+		++resolution.framesSinceChange;
+
+		// 切り替えた直後は平均が追いつくまで待つ
+		if ((not resolution.enabled) || (resolution.framesSinceChange < Config::DynamicResolutionCooldownFrames))
+		{
+			return;
+		}
+
+		const double targetMs = (1000.0 / Config::DynamicResolutionTargetFPS);
+
+		if ((targetMs * (1.0 + Config::DynamicResolutionDownscaleMargin) < resolution.averageFrameMs)
+			&& (resolution.scaleIndex + 1 < resolution.scales.size()))
+		{
+			// 目標のフレーム時間を超えているので解像度を下げる
+			++resolution.scaleIndex;
+			resolution.framesSinceChange = 0;
+		}
+		else if ((resolution.averageFrameMs <= targetMs * (1.0 + Config::DynamicResolutionDownscaleMargin))
+			&& (resolution.averageWorkMs < targetMs * Config::DynamicResolutionUpscaleHeadroom)
+			&& (0 < resolution.scaleIndex))
+		{
+			// 垂直同期でフレーム時間は目標より短くならないので、CPU 処理時間に余裕があれば上げる
+			--resolution.scaleIndex;
+			resolution.framesSinceChange = 0;
+		}
+	}
+
+	const RenderTexture& GetRenderTarget(const DynamicResolution& resolution)
+	{
+		if (1 < resolution.sampleCount)
+		{
+			return resolution.msTargets[resolution.scaleIndex];
+		}
+		return resolution.targets[resolution.scaleIndex];
+	}
+
+	double GetScale(const DynamicResolution& resolution)
+	{
+		return resolution.scales[resolution.scaleIndex];
+	}
+
+	void Present(const DynamicResolution& resolution)
+	{
+		if (1 < resolution.sampleCount)
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::Resolve };
+			SYNCSONG_TRACE_SCOPE("MSRenderTexture::resolve");
+			resolution.msTargets[resolution.scaleIndex].resolve();
+		}
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::LinearToScreen };
+			SYNCSONG_TRACE_SCOPE("Shader::LinearToScreen");
+
+			const RenderTexture& renderTarget = GetRenderTarget(resolution);
+			if (resolution.scaleIndex == 0)
+			{
+				Shader::LinearToScreen(renderTarget);
+			}
+			else
+			{
+				// 縮小した描画先はバイリニアで画面全体に拡大
+				Shader::LinearToScreen(renderTarget, RectF{ Vec2{ 0, 0 }, Vec2{ Scene::Size() } }, Config::DynamicResolutionUpscaleFilter);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 動的解像度（描画負荷に応じて縮小した描画先に 3D シーンを描き、画面に拡大して描く）
+// 描画先は倍率ごとに最初に確保しておき、切り替えで再確保しない
+struct DynamicResolution
+{
+	Array<double> scales; // 描画先の倍率（[0] が等倍、後ろほど小さい）
+	Array<MSRenderTexture> msTargets; // sampleCount が 1 より大きいとき使う
+	Array<RenderTexture> targets;     // MSAA を使わないとき使う
+	uint32 sampleCount = 1;
+	size_t scaleIndex = 0;
+	bool enabled = false;
+
+	double averageFrameMs = 0.0; // フレーム時間の指数移動平均（GPU 待ちを含む）
+	double averageWorkMs = 0.0;  // フレーム内の CPU 処理時間の指数移動平均
+	int32 framesSinceChange = 0;
+};
+
+namespace DynamicResolutionUtils
+{
+	// baseSize に Config::DynamicResolutionScales の各倍率を掛けた描画先を確保
+	// sampleCount は 1（MSAA なし）か 4（Siv3D の MSRenderTexture は 4x 固定）
+	DynamicResolution Create(const Size& baseSize, uint32 sampleCount);
+
+	// 無効にすると等倍に戻す
+	void SetEnabled(DynamicResolution& resolution, bool enabled);
+
+	// 前のフレームの時間から次に使う倍率を選ぶ（目標のフレーム時間を超えたら下げ、余裕があれば上げる）
+	void Update(DynamicResolution& resolution, double frameTimeSec, double workTimeSec);
+
+	// 現在の描画先
+	const RenderTexture& GetRenderTarget(const DynamicResolution& resolution);
+
+	double GetScale(const DynamicResolution& resolution);
+
+	// MSAA を使う場合は resolve し、描画先を画面全体に拡大して描く
+	void Present(const DynamicResolution& resolution);
+}
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "EditHistory.hpp"
+
+namespace EditHistoryUtils
+{
+	namespace
+	{
+		// ステップ: [バイト数 uint32][差分の数 uint32][差分...][バイト数 uint32]
+		// 差分: [種類 uint8][index int32] + Detach / Move: [from Float3][to Float3]、Erase: [位置 Float3][フラグ uint8][originalIndex int32]
+		constexpr size_t StepHeaderSize = (sizeof(uint32) * 2);
+		constexpr size_t StepFooterSize = sizeof(uint32);
+
+		enum EraseFlags : uint8
+		{
+			AttachedFlag = (1 << 0),
+			YellowFlag = (1 << 1),
+		};
+
+		template <class T>
+		void AppendValue(Array<uint8>& bytes, const T& value)
+		{
+			const size_t offset = bytes.size();
+			bytes.resize(offset + sizeof(T));
+			std::memcpy((bytes.data() + offset), &value, sizeof(T));
+		}
+
+		template <class T>
+		T ReadValue(const uint8*& p)
+		{
+			T value;
+			std::memcpy(&value, p, sizeof(T));
+			p += sizeof(T);
+			return value;
+		}
+
+		// 通算のバイト位置 offset から書き込む（バッファの終わりで先頭に折り返す）
+		void WriteRing(EditHistory& history, uint64 offset, const uint8* data, size_t size)
+		{
+			const size_t capacity = history.buffer.size();
+			const size_t begin = static_cast<size_t>(offset % capacity);
+			const size_t firstSize = Min(size, (capacity - begin));
+			std::memcpy((history.buffer.data() + begin), data, firstSize);
+			std::memcpy(history.buffer.data(), (data + firstSize), (size - firstSize));
+		}
+
+		void ReadRing(const EditHistory& history, uint64 offset, uint8* data, size_t size)
+		{
+			const size_t capacity = history.buffer.size();
+			const size_t begin = static_cast<size_t>(offset % capacity);
+			const size_t firstSize = Min(size, (capacity - begin));
+			std::memcpy(data, (history.buffer.data() + begin), firstSize);
+			std::memcpy((data + firstSize), history.buffer.data(), (size - firstSize));
+		}
+
+		uint32 ReadRingUInt32(const EditHistory& history, uint64 offset)
+		{
+			uint32 value;
+			ReadRing(history, offset, reinterpret_cast<uint8*>(&value), sizeof(value));
+			return value;
+		}
+
+		void AddRecord(EditHistory& history, EditOp op, int32 index)
+		{
+			AppendValue(history.pendingStep, static_cast<uint8>(op));
+			AppendValue(history.pendingStep, index);
+			++history.pendingRecordCount;
+		}
+
+		// stepOffset から始まるステップの差分を arena に取り出す
+		std::span<const EditRecord> DecodeStep(const EditHistory& history, uint64 stepOffset, FrameArena& arena)
+		{
+			const uint32 stepSize = ReadRingUInt32(history, stepOffset);
+			const uint32 recordCount = ReadRingUInt32(history, (stepOffset + sizeof(uint32)));
+
+			// 折り返しをなくしてから読む
+			const size_t payloadSize = (stepSize - StepHeaderSize - StepFooterSize);
+			const std::span<uint8> payload = arena.allocateArray<uint8>(payloadSize);
+			ReadRing(history, (stepOffset + StepHeaderSize), payload.data(), payloadSize);
+
+			const std::span<EditRecord> records = arena.allocateArray<EditRecord>(recordCount);
+			const uint8* p = payload.data();
+
+			for (EditRecord& record : records)
+			{
+				record.op = static_cast<EditOp>(ReadValue<uint8>(p));
+				record.index = ReadValue<int32>(p);
+
+				switch (record.op)
+				{
+				case EditOp::Detach:
+				case EditOp::Move:
+					record.from = ReadValue<Float3>(p);
+					record.to = ReadValue<Float3>(p);
+					break;
+				case EditOp::Snap:
+					break;
+				case EditOp::Erase:
+				{
+					record.from = ReadValue<Float3>(p);
+					const uint8 flags = ReadValue<uint8>(p);
+					record.isAttached = (flags & AttachedFlag);
+					record.isYellow = (flags & YellowFlag);
+					record.originalIndex = ReadValue<int32>(p);
+					break;
+				}
+				}
+			}
+
+			return records;
+		}
+	}
+
+	void SetByteBudget(EditHistory& history, size_t byteBudget)
+	{
+		history.byteBudget = Max(byteBudget, (StepHeaderSize + StepFooterSize));
+		history.buffer.clear();
+		history.buffer.shrink_to_fit();
+		Clear(history);
+	}
+
+	void Clear(EditHistory& history)
+	{
+		history.beginOffset = 0;
+		history.cursorOffset = 0;
+		history.endOffset = 0;
+		history.undoStepCount = 0;
+		history.redoStepCount = 0;
+		history.discardedStepCount = 0;
+		history.pendingStep.clear();
+		history.pendingRecordCount = 0;
+		history.isRecording = false;
+	}
+
+	void BeginStep(EditHistory& history)
+	{
+		history.pendingStep.clear();
+		history.pendingRecordCount = 0;
+		history.isRecording = true;
+	}
+
+	void AddDetach(EditHistory& history, int32 index, const Vec3& from, const Vec3& to)
+	{
+		if (not history.isRecording)
+		{
+			return;
+		}
+
+		AddRecord(history, EditOp::Detach, index);
+		AppendValue(history.pendingStep, Float3{ from });
+		AppendValue(history.pendingStep, Float3{ to });
+	}
+
+	void AddMove(EditHistory& history, int32 index, const Vec3& from, const Vec3& to)
+	{
+		if (not history.isRecording)
+		{
+			return;
+		}
+
+		AddRecord(history, EditOp::Move, index);
+		AppendValue(history.pendingStep, Float3{ from });
+		AppendValue(history.pendingStep, Float3{ to });
+	}
+
+	void AddSnap(EditHistory& history, int32 index)
+	{
+		if (not history.isRecording)
+		{
+			return;
+		}
+
+		AddRecord(history, EditOp::Snap, index);
+	}
+
+	void AddErase(EditHistory& history, int32 index, const SphereState& sphere)
+	{
+		if (not history.isRecording)
+		{
+			return;
+		}
+
+		AddRecord(history, EditOp::Erase, index);
+		AppendValue(history.pendingStep, Float3{ sphere.position });
+		AppendValue(history.pendingStep, static_cast<uint8>((sphere.isAttached ? AttachedFlag : 0) | (sphere.isYellow ? YellowFlag : 0)));
+		AppendValue(history.pendingStep, sphere.originalIndex);
+	}
+
+	void EndStep(EditHistory& history)
+	{
+		if (not history.isRecording)
+		{
+			return;
+		}
+
+		history.isRecording = false;
+		if (history.pendingRecordCount == 0)
+		{
+			return;
+		}
+
+		// 新しいステップを記録したらやり直せるステップは捨てる
+		history.endOffset = history.cursorOffset;
+		history.redoStepCount = 0;
+
+		const size_t stepSize = (StepHeaderSize + history.pendingStep.size() + StepFooterSize);
+		if (history.byteBudget < stepSize)
+		{
+			history.discardedStepCount += (history.undoStepCount + 1);
+			history.beginOffset = history.endOffset;
+			history.undoStepCount = 0;
+			return;
+		}
+
+		// 容量は SetByteBudget で変えたときだけ空の状態から確保し直す
+		if (history.buffer.size() != history.byteBudget)
+		{
+			history.buffer.resize(history.byteBudget);
+		}
+
+		// 古いステップから捨てて空きを作る
+		while (history.byteBudget < (history.endOffset - history.beginOffset + stepSize))
+		{
+			history.beginOffset += ReadRingUInt32(history, history.beginOffset);
+			--history.undoStepCount;
+			++history.discardedStepCount;
+		}
+
+		uint64 offset = history.endOffset;
+		const auto write = [&](const void* data, size_t size)
+		{
+			WriteRing(history, offset, static_cast<const uint8*>(data), size);
+			offset += size;
+		};
+
+		const uint32 stepSize32 = static_cast<uint32>(stepSize);
+		write(&stepSize32, sizeof(uint32));
+		write(&history.pendingRecordCount, sizeof(uint32));
+		write(history.pendingStep.data(), history.pendingStep.size());
+		write(&stepSize32, sizeof(uint32));
+
+		history.endOffset += stepSize;
+		history.cursorOffset = history.endOffset;
+		++history.undoStepCount;
+
+		history.pendingStep.clear();
+		history.pendingRecordCount = 0;
+	}
+
+	std::span<const EditRecord> PopUndoStep(EditHistory& history, FrameArena& arena)
+	{
+		if (history.isRecording || (history.undoStepCount == 0))
+		{
+			return{};
+		}
+
+		// 後ろに置いたバイト数からステップの先頭を求める
+		const uint64 stepOffset = (history.cursorOffset - ReadRingUInt32(history, (history.cursorOffset - StepFooterSize)));
+		const std::span<const EditRecord> records = DecodeStep(history, stepOffset, arena);
+
+		history.cursorOffset = stepOffset;
+		--history.undoStepCount;
+		++history.redoStepCount;
+		return records;
+	}
+
+	std::span<const EditRecord> PopRedoStep(EditHistory& history, FrameArena& arena)
+	{
+		if (history.isRecording || (history.redoStepCount == 0))
+		{
+			return{};
+		}
+
+		const std::span<const EditRecord> records = DecodeStep(history, history.cursorOffset, arena);
+
+		history.cursorOffset += ReadRingUInt32(history, history.cursorOffset);
+		++history.undoStepCount;
+		--history.redoStepCount;
+		return records;
+	}
+
+	EditHistoryStats GetStats(const EditHistory& history)
+	{
+		return{ history.undoStepCount, history.redoStepCount, static_cast<size_t>(history.endOffset - history.beginOffset),
+			history.byteBudget, history.discardedStepCount };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include <Siv3D.hpp>
+#include "Config.hpp"
+#include "GameTypes.hpp"
+#include "FrameArena.hpp"
+
+// 編集の差分の種類（元に戻すときは記録と逆の順に逆の操作を適用する）
+enum class EditOp : uint8
+{
+	Detach, // 取り付けられている球 index を from（回転変換前）から to に移して取り外し、末尾に灰色の球を作る
+	Move,   // 取り外された球 index を from から to に動かす
+	Snap,   // 灰色の球 index を黄色にする
+	Erase,  // 球 index を削除する（末尾の球が index に移動する）
+};
+
+// 編集の差分1件
+// 位置は球の配列と同じ float で前後の両方を持つので、移動量を足し引きするのと違い元に戻しても丸め誤差が残らない
+struct EditRecord
+{
+	EditOp op = EditOp::Move;
+	int32 index = 0;
+	Float3 from{ 0, 0, 0 };    // Erase では削除した球の位置
+	Float3 to{ 0, 0, 0 };
+	bool isAttached = false;   // 以下は Erase のみ（削除した球の状態）
+	bool isYellow = false;
+	int32 originalIndex = -1;
+};
+
+// 履歴の集計（オーバーレイ表示用）
+struct EditHistoryStats
+{
+	size_t undoStepCount = 0;
+	size_t redoStepCount = 0;
+	size_t usedBytes = 0;
+	size_t byteBudget = 0;
+	uint64 discardedStepCount = 0;
+};
+
+// 元に戻す・やり直しの履歴
+// ドラッグ&ドロップ1回分の差分を1ステップとしてバイト列のリングバッファに詰め、容量を超えたら古いステップから捨てる
+// ステップの前後にバイト数を置くので、元に戻す・やり直しは履歴の長さによらずそのステップの差分だけを読む
+struct EditHistory
+{
+	Array<uint8> buffer;            // リングバッファ（最初のステップを確定するときに byteBudget だけ確保）
+	size_t byteBudget = Config::EditHistoryByteBudget;
+	uint64 beginOffset = 0;         // 最も古いステップの先頭（記録を始めてからの通算のバイト位置）
+	uint64 cursorOffset = 0;        // 元に戻せるステップの終わり（ここから endOffset まではやり直せるステップ）
+	uint64 endOffset = 0;
+	size_t undoStepCount = 0;
+	size_t redoStepCount = 0;
+	uint64 discardedStepCount = 0;  // 容量を超えて捨てたステップの数
+
+	Array<uint8> pendingStep;       // 記録中のステップの差分（EndStep でリングバッファに移す。使い回す）
+	uint32 pendingRecordCount = 0;
+	bool isRecording = false;
+};
+
+namespace EditHistoryUtils
+{
+	// 容量（バイト）を設定し、履歴を消す
+	void SetByteBudget(EditHistory& history, size_t byteBudget);
+
+	// 履歴を消す（盤面を置き換えたとき）
+	void Clear(EditHistory& history);
+
+	// ステップの記録を始める
+	void BeginStep(EditHistory& history);
+
+	// 記録中のステップに差分を追加（BeginStep の後のみ、それ以外は何もしない）
+	void AddDetach(EditHistory& history, int32 index, const Vec3& from, const Vec3& to);
+	void AddMove(EditHistory& history, int32 index, const Vec3& from, const Vec3& to);
+	void AddSnap(EditHistory& history, int32 index);
+	void AddErase(EditHistory& history, int32 index, const SphereState& sphere);
+
+	// 記録中のステップを確定してやり直せるステップを捨てる（差分が無ければ何もしない）
+	// 1ステップだけで容量を超える場合は、それより前に戻せなくなるので履歴をすべて捨てる
+	void EndStep(EditHistory& history);
+
+	// 元に戻すステップの差分を記録した順に arena に取り出し、1ステップ戻る（戻せなければ空）
+	std::span<const EditRecord> PopUndoStep(EditHistory& history, FrameArena& arena);
+
+	// やり直すステップの差分を記録した順に arena に取り出し、1ステップ進む（進めなければ空）
+	std::span<const EditRecord> PopRedoStep(EditHistory& history, FrameArena& arena);
+
+	EditHistoryStats GetStats(const EditHistory& history);
+}
\ No newline at end of file
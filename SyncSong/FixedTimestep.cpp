@@ -0,0 +1,221 @@
+#include "FixedTimestep.hpp"
+#include "InputTraceUtils.hpp"
+
+namespace FixedTimestepUtils
+{
+	namespace
+	{
+		// フレームの間のカーソルの軌跡（フレームの始まり・押した瞬間・離した瞬間・フレームの終わりを直線で結ぶ）
+		struct CursorPath
+		{
+			std::array<std::pair<double, Vec2>, 4> points;
+			size_t count = 0;
+
+			void add(double timeSec, const Vec2& pos)
+			{
+				// 時刻の順に挿入
+				size_t i = count++;
+				for (; (0 < i) && (timeSec < points[i - 1].first); --i)
+				{
+					points[i] = points[i - 1];
+				}
+				points[i] = { timeSec, pos };
+			}
+
+			Vec2 at(double timeSec) const
+			{
+				if (timeSec <= points[0].first)
+				{
+					return points[0].second;
+				}
+
+				for (size_t i = 1; i < count; ++i)
+				{
+					if (timeSec <= points[i].first)
+					{
+						const auto& [t0, p0] = points[i - 1];
+						const auto& [t1, p1] = points[i];
+						return ((t0 < t1) ? p0.lerp(p1, ((timeSec - t0) / (t1 - t0))) : p1);
+					}
+				}
+
+				return points[count - 1].second;
+			}
+		};
+	}
+
+	void SetTickRate(FixedTimestep& timestep, double tickRate)
+	{
+		timestep.tickSec = static_cast<float>(1.0 / Max(tickRate, 1.0));
+		timestep.accumulatorSec = Min(timestep.accumulatorSec, timestep.tickSec);
+	}
+
+	void Advance(FixedTimestep& timestep, const FrameInput& frameInput, Array<FrameInput>& ticks)
+	{
+		ticks.clear();
+
+		const double tickSec = timestep.tickSec;
+		FrameInput& pending = timestep.pending;
+
+		if (not timestep.hasCursor)
+		{
+			timestep.tickCursorPos = timestep.frameCursorPos = (frameInput.cursorPos - frameInput.cursorDelta);
+			timestep.hasCursor = true;
+		}
+
+		// このフレームは次のティックの始まりから frameBeginSec ～ frameEndSec 秒の区間
+		const double frameBeginSec = timestep.accumulatorSec;
+		double frameEndSec = (timestep.accumulatorSec + Max(frameInput.deltaTime, 0.0));
+
+		// 押した・離した瞬間の位置もカーソルの軌跡に含める
+		CursorPath cursorPath;
+		cursorPath.add(frameBeginSec, timestep.frameCursorPos);
+		if (frameInput.mouseLDown)
+		{
+			cursorPath.add((frameBeginSec + frameInput.mouseLDownTime), frameInput.mouseLDownPos);
+		}
+		if (frameInput.mouseLUp)
+		{
+			cursorPath.add((frameBeginSec + frameInput.mouseLUpTime), frameInput.mouseLUpPos);
+		}
+		cursorPath.add(frameEndSec, frameInput.cursorPos);
+
+		// 押した瞬間は最初のもの、離した瞬間は最後のものを残す（Collect と同じ）
+		if (frameInput.mouseLDown && (not pending.mouseLDown))
+		{
+			pending.mouseLDown = true;
+			pending.mouseLDownPos = frameInput.mouseLDownPos;
+			pending.mouseLDownTime = (frameBeginSec + frameInput.mouseLDownTime);
+		}
+
+		if (frameInput.mouseLUp)
+		{
+			pending.mouseLUp = true;
+			pending.mouseLUpPos = frameInput.mouseLUpPos;
+			pending.mouseLUpTime = (frameBeginSec + frameInput.mouseLUpTime);
+		}
+
+		pending.eyePosition = frameInput.eyePosition;
+		pending.focusPosition = frameInput.focusPosition;
+		pending.upDirection = frameInput.upDirection;
+		pending.isAutoRotationEnabled = frameInput.isAutoRotationEnabled;
+		pending.isMusicSyncEnabled = frameInput.isMusicSyncEnabled;
+		pending.isSelectModifierPressed = frameInput.isSelectModifierPressed;
+		pending.isUndoRequested = (pending.isUndoRequested || frameInput.isUndoRequested);
+		pending.isRedoRequested = (pending.isRedoRequested || frameInput.isRedoRequested);
+		timestep.pendingMusicSec += frameInput.musicDeltaTime;
+
+		double elapsedSec = 0.0; // このフレームで進めたティックの時間
+
+		while ((tickSec <= frameEndSec) && (ticks.size() < Config::MaxLogicTicksPerFrame))
+		{
+			FrameInput tick;
+			tick.deltaTime = tickSec;
+			tick.eyePosition = pending.eyePosition;
+			tick.focusPosition = pending.focusPosition;
+			tick.upDirection = pending.upDirection;
+			tick.isAutoRotationEnabled = pending.isAutoRotationEnabled;
+			tick.isMusicSyncEnabled = pending.isMusicSyncEnabled;
+			tick.isSelectModifierPressed = pending.isSelectModifierPressed;
+
+			// 元に戻す・やり直しは次のティックに1回だけ渡す
+			tick.isUndoRequested = pending.isUndoRequested;
+			tick.isRedoRequested = pending.isRedoRequested;
+			pending.isUndoRequested = false;
+			pending.isRedoRequested = false;
+
+			// ティックの終わりのカーソル位置
+			const Vec2 tickBeginCursorPos = timestep.tickCursorPos;
+			tick.cursorPos = cursorPath.at(elapsedSec + tickSec);
+			tick.cursorDelta = (tick.cursorPos - tickBeginCursorPos);
+			timestep.tickCursorPos = tick.cursorPos;
+
+			// このティックの間に押した・離した瞬間
+			if (pending.mouseLDown && (pending.mouseLDownTime <= tickSec))
+			{
+				tick.mouseLDown = true;
+				tick.mouseLDownPos = pending.mouseLDownPos;
+				tick.mouseLDownTime = pending.mouseLDownTime;
+				pending.mouseLDown = false;
+			}
+
+			if (pending.mouseLUp && (pending.mouseLUpTime <= tickSec))
+			{
+				tick.mouseLUp = true;
+				tick.mouseLUpPos = pending.mouseLUpPos;
+				tick.mouseLUpTime = pending.mouseLUpTime;
+				pending.mouseLUp = false;
+			}
+
+			if (tick.mouseLDown && tick.mouseLUp)
+			{
+				timestep.isPressed = (tick.mouseLUpTime < tick.mouseLDownTime);
+			}
+			else if (tick.mouseLDown || tick.mouseLUp)
+			{
+				timestep.isPressed = tick.mouseLDown;
+			}
+			tick.mouseLPressed = timestep.isPressed;
+
+			// マウスによる回転は押した・離した瞬間の位置で区切った移動量で進める
+			// 補間したティックの終わりの位置は合計で打ち消し合うので、回転はフレームレートによらない
+			tick.pressedCursorDelta = InputTraceUtils::GetPressedCursorDelta(tick, tickBeginCursorPos);
+
+			// 音楽の再生位置の進みは、まだティックに渡していない時間に均等に割り振る
+			tick.musicDeltaTime = (timestep.pendingMusicSec * (tickSec / frameEndSec));
+			timestep.pendingMusicSec -= tick.musicDeltaTime;
+
+			InputTraceUtils::QuantizeFrameInput(tick);
+			ticks.push_back(tick);
+
+			// 次のティックの始まりを 0 にする
+			elapsedSec += tickSec;
+			frameEndSec -= tickSec;
+			pending.mouseLDownTime -= tickSec;
+			pending.mouseLUpTime -= tickSec;
+		}
+
+		// 追いつけない分の時間は捨てる（残った押した・離した瞬間は次のティックの始まりに寄せる）
+		if (tickSec <= frameEndSec)
+		{
+			const double droppedTicks = Math::Floor(frameEndSec / tickSec);
+			timestep.droppedTickCount += static_cast<uint64>(droppedTicks);
+			frameEndSec -= (droppedTicks * tickSec);
+			pending.mouseLDownTime = Max((pending.mouseLDownTime - droppedTicks * tickSec), 0.0);
+			pending.mouseLUpTime = Max((pending.mouseLUpTime - droppedTicks * tickSec), 0.0);
+		}
+
+		// すべてのイベントを渡したらボタンの状態をフレームの入力に合わせる
+		if ((not pending.mouseLDown) && (not pending.mouseLUp))
+		{
+			timestep.isPressed = frameInput.mouseLPressed;
+		}
+
+		timestep.accumulatorSec = frameEndSec;
+		timestep.frameCursorPos = frameInput.cursorPos;
+		timestep.tickCount += ticks.size();
+		timestep.lastFrameTickCount = ticks.size();
+	}
+
+	double GetInterpolationAlpha(const FixedTimestep& timestep)
+	{
+		return Clamp((timestep.accumulatorSec / timestep.tickSec), 0.0, 1.0);
+	}
+
+	TickInterpolation CaptureTickState(const GameState& state)
+	{
+		TickInterpolation interpolation;
+		interpolation.previousRotationAngle = state.rotationAngle;
+
+		if (state.dragState.isDragging)
+		{
+			if (const auto index = state.spheres.indexOf(state.dragState.draggedSphere))
+			{
+				interpolation.previousDraggedSphere = state.dragState.draggedSphere;
+				interpolation.previousDraggedPosition = state.spheres.position(*index);
+			}
+		}
+
+		return interpolation;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <Siv3D.hpp>
+#include "Config.hpp"
+#include "GameTypes.hpp"
+#include "GameLogic.hpp"
+
+// 描画のフレームごとの入力を固定間隔のティックの入力に分け、ロジックを描画のフレームレートによらない間隔で進める
+// 押した・離した瞬間はその時刻を含むティックに渡し、カーソルはフレームの間を直線で補間したティックの終わりの位置を渡す
+// マウスによる回転は押した・離した瞬間の位置で区切った移動量で進めるので、クリック・スナップの結果はフレームレートによらない
+// （回転角と取り外した球の位置は、フレームごとに float に丸めた時刻と移動量の分だけ最下位の桁がずれうる。音楽の再生位置の進みはフレームごとにしか分からない）
+struct FixedTimestep
+{
+	double tickSec = static_cast<float>(1.0 / Config::LogicTickRate); // 記録と同じ精度に丸めたティックの間隔
+	double accumulatorSec = 0.0; // 最後のティックの終わりから最後のフレームまでの時間（0 ～ tickSec）
+
+	// まだティックに渡していない入力（時刻は次のティックの始まりから）
+	FrameInput pending;
+	double pendingMusicSec = 0.0;
+
+	bool isPressed = false;      // 最後のティックの終わりで左ボタンを押していたか
+	Vec2 tickCursorPos{ 0, 0 };  // 最後のティックの終わりのカーソル位置
+	Vec2 frameCursorPos{ 0, 0 }; // 最後のフレームのカーソル位置（accumulatorSec の時点）
+	bool hasCursor = false;
+
+	uint64 tickCount = 0;
+	uint64 droppedTickCount = 0; // 1フレームの上限を超えて捨てたティックの数
+	size_t lastFrameTickCount = 0;
+};
+
+namespace FixedTimestepUtils
+{
+	// 1秒あたりのティック数を設定
+	void SetTickRate(FixedTimestep& timestep, double tickRate);
+
+	// 1フレーム分の入力を加え、このフレームで進めるティックの入力を ticks に書き出す（最大 Config::MaxLogicTicksPerFrame 個）
+	// ティックの入力は記録と同じ精度に丸めるので、そのまま入力トレースに記録すれば再生で同じ結果になる
+	void Advance(FixedTimestep& timestep, const FrameInput& frameInput, Array<FrameInput>& ticks);
+
+	// 最後のティックから次のティックまでのうち、描画する時点の割合（0 ～ 1）
+	double GetInterpolationAlpha(const FixedTimestep& timestep);
+
+	// ティックを進める前の状態を補間用に記録（alpha は 1）
+	TickInterpolation CaptureTickState(const GameState& state);
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "FrameArena.hpp"
+
+FrameArena::FrameArena(size_t capacity)
+	: buffer(capacity)
+{
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	const uintptr_t base = reinterpret_cast<uintptr_t>(buffer.data());
+	const uintptr_t aligned = ((base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+	const size_t end = (static_cast<size_t>(aligned - base) + size);
+
+	if (end <= buffer.size())
+	{
+		offset = end;
+		highWaterMark = Max(highWaterMark, offset);
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	// 容量不足: このフレームだけヒープから確保
+	Array<uint8>& block = overflowBlocks.emplace_back(size + alignment);
+	overflowBytes += (size + alignment);
+	highWaterMark = Max(highWaterMark, (offset + overflowBytes));
+
+	const uintptr_t blockBase = reinterpret_cast<uintptr_t>(block.data());
+	return reinterpret_cast<void*>((blockBase + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+}
+
+void FrameArena::reset()
+{
+	// 前のフレームで溢れた場合は、溢れた分も収まるように広げる
+	if (overflowBytes)
+	{
+		buffer.resize(buffer.size() + overflowBytes);
+		overflowBlocks.clear();
+		overflowBytes = 0;
+	}
+
+	offset = 0;
+}
+
+size_t FrameArena::capacity() const
+{
+	return buffer.size();
+}
\ No newline at end of file
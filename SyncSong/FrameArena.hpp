@@ -0,0 +1,34 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// フレームごとに使い捨てる一時データ用のバンプアロケータ（毎フレーム先頭で reset する）
+// 容量を超えた分はヒープから確保し、次の reset で容量を広げて以降のフレームでは確保しない
+struct FrameArena
+{
+	Array<uint8> buffer;
+	size_t offset = 0;
+	size_t highWaterMark = 0;             // 1フレームで使った最大バイト数
+	Array<Array<uint8>> overflowBlocks;   // 容量を超えたときに確保したブロック
+	size_t overflowBytes = 0;
+
+	explicit FrameArena(size_t capacity);
+
+	// アライメントを揃えた領域を確保（フレームの終わりまで有効）
+	void* allocate(size_t size, size_t alignment);
+
+	// 値初期化した T の配列を確保（T はデストラクタを呼ばなくてよい型のみ）
+	template <class T>
+	std::span<T> allocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>);
+
+		T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		std::uninitialized_value_construct_n(data, count);
+		return{ data, count };
+	}
+
+	// 確保した領域をすべて解放し、先頭に戻す
+	void reset();
+
+	size_t capacity() const;
+};
\ No newline at end of file
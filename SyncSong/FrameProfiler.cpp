@@ -0,0 +1,219 @@
+#include "FrameProfiler.hpp"
+#include "Config.hpp"
+
+namespace FrameProfiler
+{
+	namespace
+	{
+		constexpr std::array<StringView, PhaseCount> PhaseNames{
+			U"camera_update",
+			U"rotation",
+			U"drag_and_drop",
+			U"render_3d_scene",
+			U"flush",
+			U"resolve",
+			U"linear_to_screen",
+		};
+
+		constexpr std::array<StringView, CounterCount> CounterNames{
+			U"ray_tests",
+			U"spheres_drawn",
+			U"spheres_frustum_culled",
+			U"spheres_occluded",
+			U"render_mode",
+			U"logic_pipelined",
+			U"main_thread_us",
+		};
+
+		// 計測中のフレーム
+		std::array<std::atomic<uint64>, PhaseCount> CurrentPhaseNs{};
+		std::array<std::atomic<uint64>, CounterCount> CurrentCounters{};
+		Stopwatch FrameStopwatch;
+		uint64 FrameIndex = 0;
+
+		// リングバッファ（書き込みは BeginFrame を呼ぶスレッドのみ）
+		// WriteBegin は書き込み開始前、WriteEnd は書き込み完了後に進める
+		std::array<FrameSample, Config::ProfilerFrameCount> Ring{};
+		std::atomic<uint64> WriteBegin{ 0 };
+		std::atomic<uint64> WriteEnd{ 0 };
+
+		double ToMilliseconds(uint64 ns)
+		{
+			return (ns * 1e-6);
+		}
+
+		Percentiles GetPercentiles(Array<double>& values)
+		{
+			if (not values)
+			{
+				return{};
+			}
+
+			const auto percentile = [&](double p)
+			{
+				const size_t n = Min(static_cast<size_t>(p * values.size()), (values.size() - 1));
+				std::nth_element(values.begin(), (values.begin() + n), values.end());
+				return values[n];
+			};
+
+			return{ percentile(0.50), percentile(0.95), percentile(0.99) };
+		}
+	}
+
+	StringView GetPhaseName(Phase phase)
+	{
+		return PhaseNames[static_cast<size_t>(phase)];
+	}
+
+	StringView GetCounterName(Counter counter)
+	{
+		return CounterNames[static_cast<size_t>(counter)];
+	}
+
+	ScopedTimer::ScopedTimer(Phase _phase)
+		: phase{ _phase } {}
+
+	ScopedTimer::~ScopedTimer()
+	{
+		CurrentPhaseNs[static_cast<size_t>(phase)].fetch_add(static_cast<uint64>(stopwatch.ns()), std::memory_order_relaxed);
+	}
+
+	void AddCount(Counter counter, uint64 count)
+	{
+		CurrentCounters[static_cast<size_t>(counter)].fetch_add(count, std::memory_order_relaxed);
+	}
+
+	void BeginFrame()
+	{
+		FrameSample sample;
+		sample.frameIndex = FrameIndex++;
+		sample.frameNs = static_cast<uint64>(FrameStopwatch.ns());
+		FrameStopwatch.restart();
+
+		for (size_t i = 0; i < PhaseCount; ++i)
+		{
+			sample.phaseNs[i] = CurrentPhaseNs[i].exchange(0, std::memory_order_relaxed);
+		}
+
+		for (size_t i = 0; i < CounterCount; ++i)
+		{
+			sample.counters[i] = CurrentCounters[i].exchange(0, std::memory_order_relaxed);
+		}
+
+		// 最初の呼び出しは前のフレームがないので書き込まない
+		if (sample.frameIndex == 0)
+		{
+			return;
+		}
+
+		const uint64 writeIndex = WriteEnd.load(std::memory_order_relaxed);
+		WriteBegin.store((writeIndex + 1), std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Ring[writeIndex % Ring.size()] = sample;
+
+		WriteEnd.store((writeIndex + 1), std::memory_order_release);
+	}
+
+	Array<FrameSample> GetSamples()
+	{
+		const uint64 end = WriteEnd.load(std::memory_order_acquire);
+		const uint64 begin = ((Ring.size() < end) ? (end - Ring.size()) : 0);
+
+		Array<FrameSample> samples(static_cast<size_t>(end - begin));
+		for (uint64 i = begin; i < end; ++i)
+		{
+			samples[static_cast<size_t>(i - begin)] = Ring[i % Ring.size()];
+		}
+
+		// 読み出し中に上書きされた（されている途中の）フレームを捨てる
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64 written = WriteBegin.load(std::memory_order_relaxed);
+		if (const uint64 validBegin = ((Ring.size() < written) ? (written - Ring.size()) : 0); begin < validBegin)
+		{
+			samples.erase(samples.begin(), (samples.begin() + static_cast<size_t>(Min(validBegin, end) - begin)));
+		}
+
+		return samples;
+	}
+
+	Percentiles GetFramePercentiles(const Array<FrameSample>& samples)
+	{
+		Array<double> values(samples.size());
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			values[i] = ToMilliseconds(samples[i].frameNs);
+		}
+
+		return GetPercentiles(values);
+	}
+
+	Percentiles GetPhasePercentiles(const Array<FrameSample>& samples, Phase phase)
+	{
+		Array<double> values(samples.size());
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			values[i] = ToMilliseconds(samples[i].phaseNs[static_cast<size_t>(phase)]);
+		}
+
+		return GetPercentiles(values);
+	}
+
+	uint64 GetLastCount(const Array<FrameSample>& samples, Counter counter)
+	{
+		return (samples ? samples.back().counters[static_cast<size_t>(counter)] : 0);
+	}
+
+	Array<uint32> GetFrameTimeHistogram(const Array<FrameSample>& samples, size_t binCount, double maxMs)
+	{
+		Array<uint32> histogram(binCount, 0);
+		if (binCount == 0)
+		{
+			return histogram;
+		}
+
+		for (const FrameSample& sample : samples)
+		{
+			const double bin = (ToMilliseconds(sample.frameNs) / maxMs * binCount);
+			++histogram[Min(static_cast<size_t>(Max(bin, 0.0)), (binCount - 1))];
+		}
+
+		return histogram;
+	}
+
+	bool SaveCSV(const FilePath& path, const Array<FrameSample>& samples)
+	{
+		TextWriter writer{ path };
+		if (not writer)
+		{
+			return false;
+		}
+
+		String header = U"frame,frame_ms";
+		for (size_t i = 0; i < PhaseCount; ++i)
+		{
+			header += U",{}_ms"_fmt(PhaseNames[i]);
+		}
+		for (size_t i = 0; i < CounterCount; ++i)
+		{
+			header += U",{}"_fmt(CounterNames[i]);
+		}
+		writer.writeln(header);
+
+		for (const FrameSample& sample : samples)
+		{
+			String line = U"{},{:.4f}"_fmt(sample.frameIndex, ToMilliseconds(sample.frameNs));
+			for (size_t i = 0; i < PhaseCount; ++i)
+			{
+				line += U",{:.4f}"_fmt(ToMilliseconds(sample.phaseNs[i]));
+			}
+			for (size_t i = 0; i < CounterCount; ++i)
+			{
+				line += U",{}"_fmt(sample.counters[i]);
+			}
+			writer.writeln(line);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// メインループの処理段階ごとの時間とカウンタをフレーム単位で記録する
+// 記録はロックを使わないリングバッファに書き込み、読み出し側は書き込み中に上書きされたフレームを捨てる
+namespace FrameProfiler
+{
+	enum class Phase : uint8
+	{
+		CameraUpdate,
+		Rotation,
+		DragAndDrop,
+		Render3DScene,
+		Flush,
+		Resolve,
+		LinearToScreen,
+		Count,
+	};
+
+	enum class Counter : uint8
+	{
+		RayTests,             // レイと球の交差判定の回数
+		SpheresDrawn,         // 描画した球の数
+		SpheresFrustumCulled, // 視錐台の外で描画しなかった球の数
+		SpheresOccluded,      // 円筒に隠れて描画しなかった球の数
+		RenderMode,           // 球の描画方式（SphereRenderMode の値）
+		LogicPipelined,       // ロジックを別スレッドで進めたか（1 / 0）
+		MainThreadUs,         // メインスレッドでロジックと描画にかかった時間（マイクロ秒）
+		Count,
+	};
+
+	constexpr size_t PhaseCount = static_cast<size_t>(Phase::Count);
+	constexpr size_t CounterCount = static_cast<size_t>(Counter::Count);
+
+	// 1フレーム分の記録
+	struct FrameSample
+	{
+		uint64 frameIndex = 0;
+		uint64 frameNs = 0; // 前回の BeginFrame からの経過時間
+		std::array<uint64, PhaseCount> phaseNs{};
+		std::array<uint64, CounterCount> counters{};
+	};
+
+	// 時間の分布（ミリ秒）
+	struct Percentiles
+	{
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+	};
+
+	// 処理段階の表示名（CSV の列名にも使う）
+	StringView GetPhaseName(Phase phase);
+
+	StringView GetCounterName(Counter counter);
+
+	// スコープ内の経過時間を処理段階に加算する
+	struct ScopedTimer
+	{
+		Phase phase;
+		Stopwatch stopwatch{ StartImmediately::Yes };
+
+		explicit ScopedTimer(Phase phase);
+
+		~ScopedTimer();
+
+		ScopedTimer(const ScopedTimer&) = delete;
+
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	};
+
+	// カウンタに加算
+	void AddCount(Counter counter, uint64 count);
+
+	// フレームの区切り: これまでの計測結果を1フレーム分としてリングバッファに書き込み、計測を 0 に戻す
+	void BeginFrame();
+
+	// リングバッファに残っているフレームを古い順に取得
+	Array<FrameSample> GetSamples();
+
+	// フレーム時間の分布
+	Percentiles GetFramePercentiles(const Array<FrameSample>& samples);
+
+	// 処理段階の時間の分布
+	Percentiles GetPhasePercentiles(const Array<FrameSample>& samples, Phase phase);
+
+	// 前フレームのカウンタの値
+	uint64 GetLastCount(const Array<FrameSample>& samples, Counter counter);
+
+	// フレーム時間のヒストグラム（0 から maxMs までを binCount 等分、maxMs 以上は最後のビンに入れる）
+	Array<uint32> GetFrameTimeHistogram(const Array<FrameSample>& samples, size_t binCount, double maxMs);
+
+	// フレームごとの記録を CSV で書き出す
+	bool SaveCSV(const FilePath& path, const Array<FrameSample>& samples);
+}
\ No newline at end of file
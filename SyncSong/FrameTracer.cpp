@@ -0,0 +1,206 @@
+#include "FrameTracer.hpp"
+#include "Config.hpp"
+
+namespace FrameTracer
+{
+	namespace
+	{
+		// 区間のバッファ（最初の RequestCapture で確保し、以後は解放しない）
+		// 記録を始めるときの Recording の release ストアで、区間を記録するスレッドに公開する
+		Array<TraceEvent> Events;
+		std::atomic<size_t> EventCount{ 0 };
+
+		// スレッドの番号（最初に区間を記録したときに割り当てる）
+		std::atomic<uint32> NextThreadID{ 1 };
+		thread_local uint32 CurrentThreadID = 0;
+
+		std::mutex ThreadNameMutex;
+		Array<std::pair<uint32, const char32*>> ThreadNames;
+
+		// 記録するフレーム範囲 [CaptureFirst, CaptureEnd)
+		uint64 FrameIndex = 0;
+		uint64 FrameBeginNs = 0;
+		uint64 CaptureFirst = 0;
+		uint64 CaptureEnd = 0;
+		bool CaptureRequested = false;
+		bool CaptureFinished = false;
+
+		uint32 GetCurrentThreadID()
+		{
+			if (CurrentThreadID == 0)
+			{
+				CurrentThreadID = NextThreadID.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			return CurrentThreadID;
+		}
+
+		// 記録中に始まった区間がすべて終わるまで待つ（Recording が false になった後に呼ぶ）
+		void WaitForActiveScopes()
+		{
+			while (ActiveScopeCount.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		String ToJSONString(const char32* s)
+		{
+			String result;
+			for (; *s; ++s)
+			{
+				if ((*s == U'"') || (*s == U'\\'))
+				{
+					result.push_back(U'\\');
+				}
+				result.push_back(*s);
+			}
+			return result;
+		}
+	}
+
+	uint64 GetTimestampNs()
+	{
+		return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void AddEvent(const char32* name, uint64 beginNs, uint64 endNs)
+	{
+		const size_t index = EventCount.fetch_add(1, std::memory_order_relaxed);
+		if (index < Events.size())
+		{
+			Events[index] = TraceEvent{ name, beginNs, endNs, GetCurrentThreadID() };
+		}
+	}
+
+	void SetCurrentThreadName(const char32* name)
+	{
+		const uint32 threadID = GetCurrentThreadID();
+
+		const std::lock_guard lock{ ThreadNameMutex };
+		for (auto& threadName : ThreadNames)
+		{
+			if (threadName.first == threadID)
+			{
+				threadName.second = name;
+				return;
+			}
+		}
+		ThreadNames.emplace_back(threadID, name);
+	}
+
+	void RequestCapture(uint64 firstFrame, uint64 frameCount)
+	{
+		if constexpr (not IsEnabled())
+		{
+			return;
+		}
+
+		if (Recording.load(std::memory_order_relaxed) || (frameCount == 0))
+		{
+			return;
+		}
+
+		WaitForActiveScopes();
+		Events.resize(Config::TraceEventCapacity);
+		EventCount.store(0, std::memory_order_relaxed);
+		CaptureFirst = Max(firstFrame, FrameIndex);
+		CaptureEnd = (CaptureFirst + frameCount);
+		CaptureRequested = true;
+		CaptureFinished = false;
+	}
+
+	void RequestCaptureNextFrames(uint64 frameCount)
+	{
+		RequestCapture(FrameIndex, frameCount);
+	}
+
+	void BeginFrame()
+	{
+		// 記録中は前のフレーム全体も1区間として残す
+		const uint64 now = GetTimestampNs();
+		if (Recording.load(std::memory_order_relaxed))
+		{
+			AddEvent(U"frame", FrameBeginNs, now);
+		}
+		FrameBeginNs = now;
+
+		const uint64 frame = FrameIndex++;
+		if (not CaptureRequested)
+		{
+			return;
+		}
+
+		if (frame == CaptureEnd)
+		{
+			Recording.store(false, std::memory_order_seq_cst);
+			CaptureRequested = false;
+			CaptureFinished = true;
+		}
+		else if (frame == CaptureFirst)
+		{
+			Recording.store(true, std::memory_order_release);
+		}
+	}
+
+	bool IsCaptureFinished()
+	{
+		return CaptureFinished;
+	}
+
+	bool SaveJSON(const FilePath& path)
+	{
+		CaptureFinished = false;
+
+		// 他のスレッドで記録中に始まった区間（ロジックスレッドの UpdateGameState など）が書き終わるのを待つ
+		WaitForActiveScopes();
+		const size_t count = Min(EventCount.load(std::memory_order_relaxed), Events.size());
+
+		TextWriter writer{ path };
+		if (not writer)
+		{
+			return false;
+		}
+
+		// 時刻は最初の区間の開始を 0 とするマイクロ秒
+		uint64 originNs = UINT64_MAX;
+		for (size_t i = 0; i < count; ++i)
+		{
+			originNs = Min(originNs, Events[i].beginNs);
+		}
+
+		writer.writeln(U"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+		bool isFirst = true;
+		const auto writeEvent = [&](const String& event)
+		{
+			if (not isFirst)
+			{
+				writer.write(U",");
+			}
+			writer.writeln(event);
+			isFirst = false;
+		};
+
+		{
+			const std::lock_guard lock{ ThreadNameMutex };
+			for (const auto& [threadID, name] : ThreadNames)
+			{
+				writeEvent(U"{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}"_fmt(threadID, ToJSONString(name)));
+			}
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const TraceEvent& event = Events[i];
+			writeEvent(U"{{\"name\":\"{}\",\"cat\":\"syncsong\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}"_fmt(
+				ToJSONString(event.name), ((event.beginNs - originNs) * 1e-3), ((event.endNs - event.beginNs) * 1e-3), event.threadID));
+		}
+
+		writer.writeln(U"]}");
+
+		EventCount.store(0, std::memory_order_relaxed);
+		return true;
+	}
+}
\ No newline at end of file
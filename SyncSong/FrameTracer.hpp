@@ -0,0 +1,105 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 区間ごとの開始・終了時刻をスレッドごとに記録し、chrome://tracing / Perfetto で読める JSON に書き出す
+// SYNCSONG_ENABLE_TRACING を定義してビルドしたときだけ SYNCSONG_TRACE_SCOPE が計測コードになる
+// （定義しない場合は何も生成しない。定義した場合も記録していない間は分岐1つだけ）
+namespace FrameTracer
+{
+	// 記録した区間
+	struct TraceEvent
+	{
+		const char32* name = nullptr; // 文字列リテラル
+		uint64 beginNs = 0;
+		uint64 endNs = 0;
+		uint32 threadID = 0;
+	};
+
+	// 計測が有効なビルドか
+	constexpr bool IsEnabled()
+	{
+	#ifdef SYNCSONG_ENABLE_TRACING
+		return true;
+	#else
+		return false;
+	#endif
+	}
+
+	// 記録中か（SYNCSONG_TRACE_SCOPE の分岐で参照する）
+	inline std::atomic<bool> Recording{ false };
+
+	// 記録中に始まって、まだ終わっていない区間の数（0 になるまでバッファを読み書きしない）
+	inline std::atomic<uint32> ActiveScopeCount{ 0 };
+
+	// 計測用の時刻（ナノ秒）
+	uint64 GetTimestampNs();
+
+	// 区間を記録（バッファがいっぱいなら捨てる）
+	void AddEvent(const char32* name, uint64 beginNs, uint64 endNs);
+
+	// 現在のスレッドの表示名を設定（JSON のスレッド名になる）
+	void SetCurrentThreadName(const char32* name);
+
+	// スコープの開始から終了までを1区間として記録する
+	struct ScopedEvent
+	{
+		const char32* name;
+		uint64 beginNs = 0;
+
+		explicit ScopedEvent(const char32* _name)
+			: name{ _name }
+		{
+			if (not Recording.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			// 先に数えてから記録中かを確かめ直す（停止と入れ違った区間は記録しない）
+			ActiveScopeCount.fetch_add(1, std::memory_order_seq_cst);
+			if (Recording.load(std::memory_order_seq_cst))
+			{
+				beginNs = GetTimestampNs();
+			}
+			else
+			{
+				ActiveScopeCount.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		~ScopedEvent()
+		{
+			if (beginNs)
+			{
+				AddEvent(name, beginNs, GetTimestampNs());
+				ActiveScopeCount.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		ScopedEvent(const ScopedEvent&) = delete;
+
+		ScopedEvent& operator=(const ScopedEvent&) = delete;
+	};
+
+	// 記録するフレーム範囲を指定（firstFrame は BeginFrame を呼んだ回数で数える）
+	void RequestCapture(uint64 firstFrame, uint64 frameCount);
+
+	// 次のフレームから frameCount フレームを記録
+	void RequestCaptureNextFrames(uint64 frameCount);
+
+	// フレームの区切り: 指定範囲に入ったら記録を開始し、範囲を過ぎたら停止する
+	void BeginFrame();
+
+	// 記録が終わり、まだ書き出していないか
+	bool IsCaptureFinished();
+
+	// 記録した区間を JSON（Trace Event Format）で書き出す（記録中に始まった区間が終わるのを待ってから読む）
+	bool SaveJSON(const FilePath& path);
+}
+
+#ifdef SYNCSONG_ENABLE_TRACING
+# define SYNCSONG_TRACE_CONCAT_IMPL(a, b) a##b
+# define SYNCSONG_TRACE_CONCAT(a, b) SYNCSONG_TRACE_CONCAT_IMPL(a, b)
+# define SYNCSONG_TRACE_SCOPE(name) const FrameTracer::ScopedEvent SYNCSONG_TRACE_CONCAT(traceEvent, __LINE__){ U##name }
+#else
+# define SYNCSONG_TRACE_SCOPE(name) ((void)0)
+#endif
\ No newline at end of file
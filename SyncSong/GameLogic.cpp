@@ -1,224 +1,985 @@
 #include "GameLogic.hpp"
 #include "Config.hpp"
 #include "GeometryUtils.hpp"
+#include "BVHUtils.hpp"
+#include "FrameProfiler.hpp"
+#include "FrameTracer.hpp"
 
 namespace GameLogic
 {
-	Optional<int32> CheckSphereClick(const Vec2& mousePos, const Array<SphereState>& spheres,
-		const DebugCamera3D& camera, const Mat4x4& transform)
+	namespace
 	{
+		// 既定の設定の格子（コンパイル時に生成してバイナリに埋め込む）
+		constexpr auto DefaultGridPositions = GeometryUtils::MakeCylinderGridTable<Config::GridUDiv, Config::GridVDiv>(
+			Config::CylinderRadius,
+			Config::CylinderHeight,
+			Config::GridMargin
+		);
+
+		// Z軸を中心とする円筒殻（innerRadius～outerRadius）をレイ（円筒ローカル座標）が手前側で通過する区間の近くの格子スロットにある球を列挙
+		// 区間を格子の座標で margin ぶん広げて調べる。fn(球のインデックス, 区間の終わりのレイのパラメータ)
+		template <class Fn>
+		void ForEachSlotSphereNearRay(const SpherePickIndex& pickIndex, const Vec3& localOrigin, const Vec3& localDirection,
+			double innerRadius, double outerRadius, double margin, Fn&& fn)
+		{
+			const auto interval = GeometryUtils::GetRayCylinderShellInterval(localOrigin, localDirection, innerRadius, outerRadius);
+			if (not interval)
+			{
+				return;
+			}
+
+			double t0 = interval->x;
+			double t1 = interval->y;
+
+			// 格子の高さ範囲（margin ぶん広げる）に区間を制限
+			const double effectiveHeight = pickIndex.height - (pickIndex.margin * 2.0);
+			const double halfSpan = (effectiveHeight * 0.5 + margin);
+			if (Math::Abs(localDirection.z) > 1e-12)
+			{
+				const double tz0 = (-halfSpan - localOrigin.z) / localDirection.z;
+				const double tz1 = (halfSpan - localOrigin.z) / localDirection.z;
+				t0 = Max(t0, Min(tz0, tz1));
+				t1 = Min(t1, Max(tz0, tz1));
+			}
+			else if (halfSpan < Math::Abs(localOrigin.z))
+			{
+				return;
+			}
+
+			if (t1 < t0)
+			{
+				return;
+			}
+
+			const Vec2 uv0 = GeometryUtils::GetCylinderGridCoordinates(localOrigin + localDirection * t0,
+				pickIndex.height, pickIndex.uDiv, pickIndex.vDiv, pickIndex.margin);
+			const Vec2 uv1 = GeometryUtils::GetCylinderGridCoordinates(localOrigin + localDirection * t1,
+				pickIndex.height, pickIndex.uDiv, pickIndex.vDiv, pickIndex.margin);
+
+			// u は周回するので短い方の弧を取る
+			double du = (uv1.x - uv0.x);
+			if (du > pickIndex.uDiv * 0.5)
+			{
+				du -= pickIndex.uDiv;
+			}
+			else if (du < -pickIndex.uDiv * 0.5)
+			{
+				du += pickIndex.uDiv;
+			}
+
+			// margin ぶんのセル数だけ範囲を広げる
+			const double uMargin = Math::Asin(Min(margin / pickIndex.radius, 1.0)) / Math::TwoPi * pickIndex.uDiv;
+			const double vMargin = margin / effectiveHeight * (pickIndex.vDiv - 1);
+
+			const int32 uBegin = static_cast<int32>(Math::Floor(Min(uv0.x, uv0.x + du) - uMargin));
+			const int32 uEnd = Min(static_cast<int32>(Math::Ceil(Max(uv0.x, uv0.x + du) + uMargin)), uBegin + pickIndex.uDiv - 1);
+			const int32 vBegin = Max(static_cast<int32>(Math::Floor(Min(uv0.y, uv1.y) - vMargin)), 0);
+			const int32 vEnd = Min(static_cast<int32>(Math::Ceil(Max(uv0.y, uv1.y) + vMargin)), pickIndex.vDiv - 1);
+
+			for (int32 v = vBegin; v <= vEnd; ++v)
+			{
+				for (int32 u = uBegin; u <= uEnd; ++u)
+				{
+					const int32 wrappedU = ((u % pickIndex.uDiv) + pickIndex.uDiv) % pickIndex.uDiv;
+					const int32 sphereIndex = pickIndex.slotSpheres[v * pickIndex.uDiv + wrappedU];
+
+					if (sphereIndex >= 0)
+					{
+						fn(sphereIndex, interval->y);
+					}
+				}
+			}
+		}
+	}
+
+	void InitializeGameState(GameState& state)
+	{
+		state.gridPositions.assign(DefaultGridPositions.begin(), DefaultGridPositions.end());
+
+		state.spheres.reserve(state.gridPositions.size() * 2);
+		state.spheres.assignAttached(state.gridPositions.size(), true);
+		for (size_t i = 0; i < state.gridPositions.size(); ++i)
+		{
+			state.spheres.setPosition(i, state.gridPositions[i]);
+		}
+
+		RebuildPickIndex(state.spheres, state.pickIndex);
+		state.dragState = DragState{};
+		state.rotationAngle = 0.0;
+		EditHistoryUtils::Clear(state.history);
+	}
+
+	void ApplySlotColors(GameState& state, std::span<const uint64> yellowSlotBits)
+	{
+		SphereStore& spheres = state.spheres;
+		spheres.forEachAttached([&](int32 i)
+		{
+			const size_t slot = static_cast<size_t>(spheres.originalIndex[i]);
+			if ((slot / 64) < yellowSlotBits.size())
+			{
+				spheres.setYellow(i, ((yellowSlotBits[slot / 64] >> (slot % 64)) & 1));
+			}
+		});
+	}
+
+	Array<uint64> GetSlotColors(const GameState& state)
+	{
+		const SphereStore& spheres = state.spheres;
+		Array<uint64> yellowSlotBits(((state.gridPositions.size() + 63) / 64), 0);
+		spheres.forEachAttachedYellow([&](int32 i)
+		{
+			const size_t slot = static_cast<size_t>(spheres.originalIndex[i]);
+			if ((slot / 64) < yellowSlotBits.size())
+			{
+				yellowSlotBits[slot / 64] |= (uint64{ 1 } << (slot % 64));
+			}
+		});
+		return yellowSlotBits;
+	}
+
+	void UpdateGameState(GameState& state, const FrameInput& input, const BasicCamera3D& camera, FrameArena& arena)
+	{
+		SYNCSONG_TRACE_SCOPE("UpdateGameState");
+
+		// 元に戻す・やり直し（ドラッグ中・範囲選択中は受け付けない）
+		if (not state.dragState.isInteracting())
+		{
+			if (input.isUndoRequested)
+			{
+				UndoEdit(state, arena);
+			}
+
+			if (input.isRedoRequested)
+			{
+				RedoEdit(state, arena);
+			}
+		}
+
+		// ドラッグ中・範囲選択中は回転しないので、押した・離した時刻でフレームを区切って回転を進める
+		// クリックとドロップはその時刻の回転角で判定するので、フレームレートによらず同じ結果になる
+		const bool wasInteracting = state.dragState.isInteracting();
+		const double pressTime = (((not wasInteracting) && input.mouseLDown) ? input.mouseLDownTime : input.deltaTime);
+
+		if (not wasInteracting)
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::Rotation };
+			ProcessRotation(state.rotationAngle, input, 0.0, pressTime, false);
+		}
+
+		// ドラッグ&ドロップ処理
+		bool startedInteraction;
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::DragAndDrop };
+			const Mat4x4 transform = Mat4x4::RotateZ(state.rotationAngle);
+			startedInteraction = ProcessDragAndDrop(state.spheres, state.dragState, state.pickIndex, state.history, camera, transform, state.gridPositions, arena, input);
+		}
+
+		// 残りの時間の回転（離した時刻から。クリックが当たらなかったときは押した時刻から）
+		if (not state.dragState.isInteracting())
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::Rotation };
+			const double resumeTime = ((wasInteracting || startedInteraction) ? (input.mouseLUp ? input.mouseLUpTime : 0.0) : pressTime);
+			ProcessRotation(state.rotationAngle, input, resumeTime, input.deltaTime, ((not wasInteracting) && (not startedInteraction)));
+		}
+	}
+
+	void RebuildPickIndex(const SphereStore& spheres, SpherePickIndex& pickIndex)
+	{
+		SYNCSONG_TRACE_SCOPE("RebuildPickIndex");
+		pickIndex.slotSpheres.assign(static_cast<size_t>(pickIndex.uDiv) * pickIndex.vDiv, -1);
+		BVHUtils::Clear(pickIndex.detachedSpheres);
+
+		spheres.forEachAttached([&](int32 i)
+		{
+			// 取り付けられている球は originalIndex の格子スロットに置かれている
+			if (InRange(spheres.originalIndex[i], 0, static_cast<int32>(pickIndex.slotSpheres.size()) - 1))
+			{
+				pickIndex.slotSpheres[spheres.originalIndex[i]] = i;
+			}
+		});
+
+		spheres.forEachDetached([&](int32 i)
+		{
+			BVHUtils::InsertSphere(pickIndex.detachedSpheres, i, spheres.position(i), Config::SphereRadius);
+		});
+	}
+
+	Optional<int32> CheckSphereClick(const Vec2& mousePos, const SphereStore& spheres, const SpherePickIndex& pickIndex,
+		const BasicCamera3D& camera, const Mat4x4& transform, FrameArena& arena)
+	{
+		SYNCSONG_TRACE_SCOPE("CheckSphereClick");
 		const Ray ray = camera.screenToRay(mousePos);
 
-		for (int32 i = 0; i < spheres.size(); ++i)
+		Optional<int32> nearestIndex;
+		double nearestDistance = Math::Inf;
+
+		const auto testSphere = [&](int32 index, const Vec3& worldPos, double maxDistance)
 		{
-			Vec3 worldPos;
+			// x < 0 の球は相互作用しない
+			if (worldPos.x < 0)
+			{
+				return;
+			}
+
+			// レイと球の交差判定（最も手前の球を採用）
+			FrameProfiler::AddCount(FrameProfiler::Counter::RayTests, 1);
+			const auto intersection = ray.intersects(Sphere{ worldPos, Config::SphereRadius });
+			if (intersection && (*intersection < nearestDistance) && (*intersection <= maxDistance))
+			{
+				nearestDistance = *intersection;
+				nearestIndex = index;
+			}
+		};
+
+		// 取り付けられている球: レイを円筒ローカル座標に戻し、円筒の手前側で通過する格子セルの近傍だけを調べる
+		const Mat4x4 inverseTransform = transform.inverse();
+		const Vec3 rayOrigin = ray.getOrigin();
+		const Vec3 rayDirection = ray.getDirection();
+		const Vec3 localOrigin = inverseTransform.transformPoint(rayOrigin);
+		const Vec3 localDirection = inverseTransform.transformPoint(rayOrigin + rayDirection) - localOrigin;
+
+		ForEachSlotSphereNearRay(pickIndex, localOrigin, localDirection, pickIndex.radius, (pickIndex.radius + Config::SphereRadius), Config::SphereRadius,
+			[&](int32 sphereIndex, double maxDistance)
+			{
+				// 円筒（不透明）に入った先での交差は隠れているので除外
+				testSphere(sphereIndex, transform.transformPoint(spheres.position(sphereIndex)), maxDistance);
+			});
+
+		// 取り外された球は回転変換を適用せずにBVHで判定（格子側の最短距離より手前のみ）
+		if (const auto detachedIndex = BVHUtils::RayCastNearest(pickIndex.detachedSpheres, spheres, ray, Config::SphereRadius, nearestDistance, arena))
+		{
+			nearestIndex = detachedIndex;
+		}
+
+		return nearestIndex;
+	}
+
+	namespace
+	{
+		// スナップ判定に使う直線と半空間（円筒ローカル座標）
+		struct SnapQuery
+		{
+			Vec3 localLineStart;
+			Vec3 localLineEnd;
+			Vec4 filterPlane;
+		};
+
+		SnapQuery MakeSnapQuery(const Vec3& draggedPos, const Vec3& playerPos, const Mat4x4& transform)
+		{
+			// 距離は回転で変わらないので、球ではなく直線を円筒ローカル座標に戻す
+			const Mat4x4 inverseTransform = transform.inverse();
+
+			// 世界座標の x >= 0 をローカル座標の半空間として表す
+			const Vec3 origin = transform.transformPoint(Vec3{ 0, 0, 0 });
+			const Vec4 filterPlane{
+				(transform.transformPoint(Vec3{ 1, 0, 0 }).x - origin.x),
+				(transform.transformPoint(Vec3{ 0, 1, 0 }).x - origin.x),
+				(transform.transformPoint(Vec3{ 0, 0, 1 }).x - origin.x),
+				origin.x };
+
+			return{ inverseTransform.transformPoint(playerPos), inverseTransform.transformPoint(draggedPos), filterPlane };
+		}
+
+		// スナップ可能な球をビットマスクで求める（取り付けられている灰色の球のうち、x >= 0 でプレイヤー-ドラッグ球の直線に近いもの）
+		void ComputeSnapMask(const SnapQuery& query, const SphereStore& spheres, int32 excludeIndex, std::span<uint64> mask)
+		{
+			GeometryUtils::CalculatePointToLineDistanceMask(spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.size(),
+				query.localLineStart, query.localLineEnd, Config::SnapDistance, query.filterPlane, mask);
+
+			for (size_t word = 0; word < mask.size(); ++word)
+			{
+				mask[word] &= (spheres.attachedBits[word] & ~spheres.yellowBits[word]);
+			}
 
-			// tĂ鋅͉]ϊKpAOꂽ͂̂܂
-			if (spheres[i].isAttached)
+			if (InRange(excludeIndex, 0, static_cast<int32>(spheres.size()) - 1))
 			{
-				worldPos = transform.transformPoint(spheres[i].position);
+				mask[excludeIndex / 64] &= ~(uint64{ 1 } << (excludeIndex % 64));
+			}
+		}
+
+		// 格子スロットの参照を付け替える（originalIndex のスロットが fromIndex を指している場合のみ）
+		void ReplaceSlotSphere(SpherePickIndex& pickIndex, int32 slotIndex, int32 fromIndex, int32 toIndex)
+		{
+			if (InRange(slotIndex, 0, static_cast<int32>(pickIndex.slotSpheres.size()) - 1)
+				&& (pickIndex.slotSpheres[slotIndex] == fromIndex))
+			{
+				pickIndex.slotSpheres[slotIndex] = toIndex;
+			}
+		}
+
+		// 球を O(1) で削除し、末尾から移動した球に合わせてピッキング用インデックスを更新
+		void RemoveSphere(SphereStore& spheres, SpherePickIndex& pickIndex, int32 index)
+		{
+			SYNCSONG_TRACE_SCOPE("RemoveSphere");
+
+			const int32 last = static_cast<int32>(spheres.size() - 1);
+
+			if (spheres.isAttached(index))
+			{
+				ReplaceSlotSphere(pickIndex, spheres.originalIndex[index], index, -1);
 			}
 			else
 			{
-				worldPos = spheres[i].position;
+				BVHUtils::RemoveSphere(pickIndex.detachedSpheres, index);
 			}
 
-			// x < 0 ̋͑ݍpȂ
-			if (worldPos.x < 0)
+			if (index != last)
 			{
-				continue;
+				if (spheres.isAttached(last))
+				{
+					ReplaceSlotSphere(pickIndex, spheres.originalIndex[last], last, index);
+				}
+				else
+				{
+					BVHUtils::RenameSphere(pickIndex.detachedSpheres, last, index);
+				}
 			}
 
-			const Sphere sphere{ worldPos, Config::SphereRadius };
+			spheres.erase(index);
+		}
 
-			// CƋ̌
-			const auto intersection = ray.intersects(sphere);
-			if (intersection)
+		// RemoveSphere の逆: index に球を戻し、index にあった球を末尾に移してピッキング用インデックスを更新
+		void RestoreSphere(SphereStore& spheres, SpherePickIndex& pickIndex, int32 index, const SphereState& sphere)
+		{
+			spheres.insert(index, sphere);
+			const int32 last = static_cast<int32>(spheres.size() - 1);
+
+			if (index != last)
+			{
+				if (spheres.isAttached(last))
+				{
+					ReplaceSlotSphere(pickIndex, spheres.originalIndex[last], index, last);
+				}
+				else
+				{
+					BVHUtils::RenameSphere(pickIndex.detachedSpheres, index, last);
+				}
+			}
+
+			if (sphere.isAttached)
+			{
+				ReplaceSlotSphere(pickIndex, sphere.originalIndex, -1, index);
+			}
+			else
+			{
+				BVHUtils::InsertSphere(pickIndex.detachedSpheres, index, sphere.position, Config::SphereRadius);
+			}
+		}
+
+		// 取り付けられている球を今の位置のまま取り外し、元の位置（回転変換前）に灰色の球を作成して格子スロットを付け替える
+		void DetachSphere(SphereStore& spheres, SpherePickIndex& pickIndex, const Array<Vec3>& gridPositions, int32 index)
+		{
+			SYNCSONG_TRACE_SCOPE("DetachSphere");
+			spheres.setAttached(index, false);
+			BVHUtils::InsertSphere(pickIndex.detachedSpheres, index, spheres.position(index), Config::SphereRadius);
+
+			const int32 slotIndex = spheres.originalIndex[index];
+			spheres.push_back(SphereState{ gridPositions[slotIndex], true, false, slotIndex });
+			ReplaceSlotSphere(pickIndex, slotIndex, index, static_cast<int32>(spheres.size() - 1));
+		}
+
+		// DetachSphere の逆: 末尾の灰色の球を削除し、index の球を from（回転変換前）に取り付け直す
+		void ReattachSphere(SphereStore& spheres, SpherePickIndex& pickIndex, int32 index, const Vec3& from)
+		{
+			RemoveSphere(spheres, pickIndex, static_cast<int32>(spheres.size() - 1));
+
+			BVHUtils::RemoveSphere(pickIndex.detachedSpheres, index);
+			spheres.setAttached(index, true);
+			spheres.setPosition(index, from);
+			ReplaceSlotSphere(pickIndex, spheres.originalIndex[index], -1, index);
+		}
+
+		// 取り外された球を動かし、BVHに挿入し直す
+		void MoveDetachedSphere(SphereStore& spheres, SpherePickIndex& pickIndex, int32 index, const Vec3& position)
+		{
+			spheres.setPosition(index, position);
+			BVHUtils::ReinsertSphere(pickIndex.detachedSpheres, index, position, Config::SphereRadius);
+		}
+
+		// 記録した差分を適用（やり直し）
+		void ApplyEdit(GameState& state, const EditRecord& record)
+		{
+			switch (record.op)
 			{
-				return i;
+			case EditOp::Detach:
+				state.spheres.setPosition(record.index, Vec3{ record.to });
+				DetachSphere(state.spheres, state.pickIndex, state.gridPositions, record.index);
+				break;
+			case EditOp::Move:
+				MoveDetachedSphere(state.spheres, state.pickIndex, record.index, Vec3{ record.to });
+				break;
+			case EditOp::Snap:
+				state.spheres.setYellow(record.index, true);
+				break;
+			case EditOp::Erase:
+				RemoveSphere(state.spheres, state.pickIndex, record.index);
+				break;
 			}
 		}
-		return none;
+
+		// 記録した差分の逆を適用（元に戻す。ステップの差分は記録と逆の順に戻す）
+		void RevertEdit(GameState& state, const EditRecord& record)
+		{
+			switch (record.op)
+			{
+			case EditOp::Detach:
+				ReattachSphere(state.spheres, state.pickIndex, record.index, Vec3{ record.from });
+				break;
+			case EditOp::Move:
+				MoveDetachedSphere(state.spheres, state.pickIndex, record.index, Vec3{ record.from });
+				break;
+			case EditOp::Snap:
+				state.spheres.setYellow(record.index, false);
+				break;
+			case EditOp::Erase:
+				RestoreSphere(state.spheres, state.pickIndex, record.index,
+					SphereState{ Vec3{ record.from }, record.isAttached, record.isYellow, record.originalIndex });
+				break;
+			}
+		}
+
+		Optional<int32> GetFirstSetBit(std::span<const uint64> mask)
+		{
+			for (size_t word = 0; word < mask.size(); ++word)
+			{
+				if (mask[word])
+				{
+					return static_cast<int32>(word * 64 + std::countr_zero(mask[word]));
+				}
+			}
+			return none;
+		}
+
+		// まとめてドロップしたときのスナップ候補の組（落とした球の番号と灰色の球のインデックス）
+		struct GroupSnapPair
+		{
+			double distance;
+			int32 dropped;
+			int32 target;
+		};
+	}
+
+	bool UndoEdit(GameState& state, FrameArena& arena)
+	{
+		SYNCSONG_TRACE_SCOPE("UndoEdit");
+
+		const std::span<const EditRecord> records = EditHistoryUtils::PopUndoStep(state.history, arena);
+		if (records.empty())
+		{
+			return false;
+		}
+
+		for (auto it = records.rbegin(); it != records.rend(); ++it)
+		{
+			RevertEdit(state, *it);
+		}
+
+		state.dragState.selectedSpheres.clear();
+		return true;
+	}
+
+	bool RedoEdit(GameState& state, FrameArena& arena)
+	{
+		SYNCSONG_TRACE_SCOPE("RedoEdit");
+
+		const std::span<const EditRecord> records = EditHistoryUtils::PopRedoStep(state.history, arena);
+		if (records.empty())
+		{
+			return false;
+		}
+
+		for (const EditRecord& record : records)
+		{
+			ApplyEdit(state, record);
+		}
+
+		state.dragState.selectedSpheres.clear();
+		return true;
 	}
 
-	Optional<int32> FindSnapTarget(const Vec3& draggedPos, const Array<SphereState>& spheres, int32 excludeIndex,
+	Optional<int32> FindSnapTarget(const Vec3& draggedPos, const SphereStore& spheres, int32 excludeIndex,
 		const Vec3& playerPos, const Mat4x4& transform)
 	{
-		for (int32 i = 0; i < spheres.size(); ++i)
+		SYNCSONG_TRACE_SCOPE("FindSnapTarget");
+
+		Array<uint64> mask((spheres.size() + 63) / 64);
+		ComputeSnapMask(MakeSnapQuery(draggedPos, playerPos, transform), spheres, excludeIndex, mask);
+
+		// 最もインデックスの小さい候補を採用
+		return GetFirstSetBit(mask);
+	}
+
+	// スナップ可能な球のインデックスを取得（デバッグ表示用）
+	std::span<const int32> GetSnapCandidates(const Vec3& draggedPos, const SphereStore& spheres, int32 excludeIndex,
+		const Vec3& playerPos, const Mat4x4& transform, FrameArena& arena)
+	{
+		SYNCSONG_TRACE_SCOPE("GetSnapCandidates");
+
+		const size_t wordCount = ((spheres.size() + 63) / 64);
+		const std::span<uint64> mask = arena.allocateArray<uint64>(wordCount);
+		ComputeSnapMask(MakeSnapQuery(draggedPos, playerPos, transform), spheres, excludeIndex, mask);
+
+		size_t candidateCount = 0;
+		for (const uint64 word : mask)
 		{
-			if (i == excludeIndex || !spheres[i].isAttached || spheres[i].isYellow)
-				continue;
+			candidateCount += std::popcount(word);
+		}
+
+		const std::span<int32> candidates = arena.allocateArray<int32>(candidateCount);
+		size_t candidateIndex = 0;
+		
+		for (size_t word = 0; word < mask.size(); ++word)
+		{
+			for (uint64 bits = mask[word]; bits; bits &= (bits - 1))
+			{
+				candidates[candidateIndex++] = static_cast<int32>(word * 64 + std::countr_zero(bits));
+			}
+		}
+		return candidates;
+	}
+
+	std::span<const int32> ResolveGroupSnapTargets(std::span<const int32> droppedIndices, const SphereStore& spheres, const SpherePickIndex& pickIndex,
+		const Vec3& playerPos, const Mat4x4& transform, FrameArena& arena)
+	{
+		SYNCSONG_TRACE_SCOPE("ResolveGroupSnapTargets");
 
-			// ]ϊꂽ~̋̐EW擾
-			Vec3 sphereWorldPos = transform.transformPoint(spheres[i].position);
+		const std::span<int32> targets = arena.allocateArray<int32>(droppedIndices.size());
+		std::fill(targets.begin(), targets.end(), -1);
 
-			// x < 0 ̋̓XibvȂ
-			if (sphereWorldPos.x < 0)
+		// 落とした球 k のスナップ候補（FindSnapTarget と同じ条件）を列挙: fn(灰色の球のインデックス, 直線までの距離)
+		// 全部の球を調べる代わりに、直線が円筒を横切る2か所の近くの格子スロットだけを調べる
+		const double reach = (playerPos.length() + pickIndex.radius + pickIndex.height + Config::SnapDistance);
+		const auto forEachCandidate = [&](size_t k, auto&& fn)
+		{
+			const SnapQuery query = MakeSnapQuery(spheres.position(droppedIndices[k]), playerPos, transform);
+			const Vec3 lineVec = (query.localLineEnd - query.localLineStart);
+			if (lineVec.lengthSq() < 1e-12)
 			{
-				continue;
+				return;
 			}
+			const Vec3 direction = lineVec.normalized();
 
-			// vC[-hbO̒~̋ւ̋vZ
-			const double lineDistance = GeometryUtils::CalculatePointToLineDistance(sphereWorldPos, playerPos, draggedPos);
-			
-			if (lineDistance < Config::SnapDistance)
+			// 直線の両端の十分遠くから向かい合うレイを飛ばし、入る側と出る側の殻をそれぞれ調べる
+			for (const double sign : { 1.0, -1.0 })
 			{
-				return i;
+				const Vec3 origin = (query.localLineStart - direction * (sign * reach));
+				ForEachSlotSphereNearRay(pickIndex, origin, (direction * sign),
+					(pickIndex.radius - Config::SnapDistance), (pickIndex.radius + Config::SnapDistance), Config::SnapDistance,
+					[&](int32 sphereIndex, double)
+					{
+						if (spheres.isYellow(sphereIndex))
+						{
+							return;
+						}
+
+						const Vec3 localPos = spheres.position(sphereIndex);
+						if ((query.filterPlane.xyz().dot(localPos) + query.filterPlane.w) < 0)
+						{
+							return;
+						}
+
+						const double distance = GeometryUtils::CalculatePointToLineDistance(localPos, query.localLineStart, query.localLineEnd);
+						if (distance < Config::SnapDistance)
+						{
+							fn(sphereIndex, distance);
+						}
+					});
 			}
+		};
+
+		// 候補の組を数えてから確保
+		size_t pairCount = 0;
+		for (size_t k = 0; k < droppedIndices.size(); ++k)
+		{
+			forEachCandidate(k, [&](int32, double) { ++pairCount; });
+		}
+
+		const std::span<GroupSnapPair> pairs = arena.allocateArray<GroupSnapPair>(pairCount);
+		size_t pairIndex = 0;
+		for (size_t k = 0; k < droppedIndices.size(); ++k)
+		{
+			forEachCandidate(k, [&](int32 target, double distance)
+			{
+				pairs[pairIndex++] = GroupSnapPair{ distance, static_cast<int32>(k), target };
+			});
 		}
-		return none;
+
+		// 直線に近い組から順に、落とした球も灰色の球もまだ使っていなければ割り当てる（同じ灰色の球に2つはスナップしない）
+		std::sort(pairs.begin(), pairs.end(), [](const GroupSnapPair& a, const GroupSnapPair& b)
+		{
+			return (std::tie(a.distance, a.dropped, a.target) < std::tie(b.distance, b.dropped, b.target));
+		});
+
+		const std::span<uint64> usedTargets = arena.allocateArray<uint64>((spheres.size() + 63) / 64);
+		std::fill(usedTargets.begin(), usedTargets.end(), 0);
+
+		for (const GroupSnapPair& pair : pairs)
+		{
+			const uint64 bit = (uint64{ 1 } << (pair.target % 64));
+			if ((targets[pair.dropped] < 0) && (not (usedTargets[pair.target / 64] & bit)))
+			{
+				targets[pair.dropped] = pair.target;
+				usedTargets[pair.target / 64] |= bit;
+			}
+		}
+
+		return targets;
 	}
 
-	// Xibv\ȋ̃CfbNX擾ifobO\pj
-	Array<int32> GetSnapCandidates(const Vec3& draggedPos, const Array<SphereState>& spheres, int32 excludeIndex,
-		const Vec3& playerPos, const Mat4x4& transform)
+	void SelectSpheresInRect(Array<SphereHandle>& selectedSpheres, const Vec2& corner0, const Vec2& corner1, const SphereStore& spheres,
+		const BasicCamera3D& camera, const Mat4x4& transform)
 	{
-		Array<int32> candidates;
-		
-		for (int32 i = 0; i < spheres.size(); ++i)
+		SYNCSONG_TRACE_SCOPE("SelectSpheresInRect");
+
+		selectedSpheres.clear();
+
+		const Vec2 rectMin{ Min(corner0.x, corner1.x), Min(corner0.y, corner1.y) };
+		const Vec2 rectMax{ Max(corner0.x, corner1.x), Max(corner0.y, corner1.y) };
+		const Vec3 eyePosition = camera.getEyePosition();
+		const Vec3 viewDirection = (camera.getFocusPosition() - eyePosition);
+
+		for (size_t i = 0; i < spheres.size(); ++i)
 		{
-			if (i == excludeIndex || !spheres[i].isAttached || spheres[i].isYellow)
+			if (not spheres.isYellow(i))
+			{
 				continue;
+			}
 
-			Vec3 sphereWorldPos = transform.transformPoint(spheres[i].position);
-
-			if (sphereWorldPos.x < 0)
+			// x < 0 の球とカメラの後ろの球は選ばない
+			const Vec3 worldPos = (spheres.isAttached(i) ? transform.transformPoint(spheres.position(i)) : spheres.position(i));
+			if ((worldPos.x < 0) || ((worldPos - eyePosition).dot(viewDirection) <= 0))
 			{
 				continue;
 			}
 
-			const double lineDistance = GeometryUtils::CalculatePointToLineDistance(sphereWorldPos, playerPos, draggedPos);
-			
-			if (lineDistance < Config::SnapDistance)
+			const Vec3 screenPos{ camera.worldToScreenPoint(Float3{ worldPos }) };
+			if (InRange(screenPos.x, rectMin.x, rectMax.x) && InRange(screenPos.y, rectMin.y, rectMax.y))
 			{
-				candidates.push_back(i);
+				selectedSpheres.push_back(spheres.handleAt(i));
 			}
 		}
-		return candidates;
 	}
 
-	void ProcessDragAndDrop(Array<SphereState>& spheres, DragState& dragState, 
-		const DebugCamera3D& camera, const Mat4x4& transform, const Array<Vec3>& gridPositions)
+	void UpdateSnapTracker(SnapTracker& tracker, const Vec3& draggedPos, const SphereStore& spheres, int32 excludeIndex,
+		const Vec3& playerPos, const Mat4x4& transform)
 	{
-		const Vec2 mousePos = Cursor::Pos();
+		SYNCSONG_TRACE_SCOPE("UpdateSnapTracker");
+
+		const SnapQuery query = MakeSnapQuery(draggedPos, playerPos, transform);
+		constexpr double EpsilonSq = (Config::SnapRecomputeEpsilon * Config::SnapRecomputeEpsilon);
+
+		// ドラッグ位置・視点・回転角のいずれかが動いたか、球の数が変わったときだけ再計算
+		const bool isUnchanged = (tracker.isValid
+			&& (tracker.excludeIndex == excludeIndex)
+			&& (tracker.highlightBits.size() == ((spheres.size() + 63) / 64))
+			&& (tracker.localLineStart.distanceFromSq(query.localLineStart) <= EpsilonSq)
+			&& (tracker.localLineEnd.distanceFromSq(query.localLineEnd) <= EpsilonSq)
+			&& ((tracker.filterPlane - query.filterPlane).lengthSq() <= EpsilonSq));
+
+		if (isUnchanged)
+		{
+			return;
+		}
+
+		// 球の数が前回以下なら確保済みの領域を使い回す
+		tracker.highlightBits.resize((spheres.size() + 63) / 64);
+		ComputeSnapMask(query, spheres, excludeIndex, tracker.highlightBits);
+		tracker.localLineStart = query.localLineStart;
+		tracker.localLineEnd = query.localLineEnd;
+		tracker.filterPlane = query.filterPlane;
+		tracker.excludeIndex = excludeIndex;
+		tracker.isValid = true;
+	}
+
+	bool ProcessDragAndDrop(SphereStore& spheres, DragState& dragState, SpherePickIndex& pickIndex, EditHistory& history,
+		const BasicCamera3D& camera, const Mat4x4& transform, const Array<Vec3>& gridPositions, FrameArena& arena, const FrameInput& input)
+	{
+		SYNCSONG_TRACE_SCOPE("ProcessDragAndDrop");
+
+		const Vec2 mousePos = input.cursorPos;
 		const Vec3 playerPos = camera.getEyePosition();
+		const bool wasDragging = dragState.isDragging;
+		const bool wasSelecting = dragState.isSelecting;
+		bool startedInteraction = false;
 
-		// ̃hbO&hbv
-		if (MouseL.down())
+		// 球をプレイヤーと結ぶ直線とx=3平面の交点に移し、取り付けられていれば取り外す（元の位置に灰色の球を作成）
+		const auto beginDragSphere = [&](int32 index)
 		{
-			if (!dragState.isDragging)
+			const Vec3 fromPos = spheres.position(index);
+
+			// 元の球の位置（変換後）を取得
+			Vec3 originalSpherePos;
+			if (spheres.isAttached(index))
 			{
-				// NbN`FbN
-				const auto clickedSphere = CheckSphereClick(mousePos, spheres, camera, transform);
-				if (clickedSphere && spheres[*clickedSphere].isYellow)
-				{
-					dragState.isDragging = true;
-					dragState.draggedSphereIndex = *clickedSphere;
+				originalSpherePos = transform.transformPoint(spheres.position(index));
+			}
+			else
+			{
+				originalSpherePos = spheres.position(index);
+			}
 
-					// ̋̈ʒuiϊj擾
-					Vec3 originalSpherePos;
-					if (spheres[*clickedSphere].isAttached)
-					{
-						originalSpherePos = transform.transformPoint(spheres[*clickedSphere].position);
-					}
-					else
+			// プレイヤーと球を結ぶ直線とx=3平面の交点を計算
+			const auto intersection = GeometryUtils::GetLinePlaneIntersection(playerPos, originalSpherePos, Config::DragPlaneX);
+			if (intersection)
+			{
+				spheres.setPosition(index, *intersection);
+			}
+			else
+			{
+				// 交点が計算できない場合は既存の方法を使用
+				const Vec3 pos = spheres.position(index);
+				spheres.setPosition(index, Vec3{ Config::DragPlaneX, pos.y, pos.z });
+			}
+
+			// 取り外し: 元の位置に灰色の球を作成
+			if (spheres.isAttached(index))
+			{
+				DetachSphere(spheres, pickIndex, gridPositions, index);
+				EditHistoryUtils::AddDetach(history, index, fromPos, spheres.position(index));
+			}
+			else
+			{
+				EditHistoryUtils::AddMove(history, index, fromPos, spheres.position(index));
+			}
+
+			return spheres.position(index);
+		};
+
+		// ドラッグ中の球を、押した瞬間からのカーソルの移動量だけ動かす（x座標は固定。まとめてドラッグ中は選択した球をすべて同じだけ動かす）
+		// 途中のフレーム数によらず同じ位置になるよう、移動量は積み上げずに押した瞬間の位置との差から求める
+		const auto moveDraggedSpheres = [&](const Vec2& cursorPos)
+		{
+			const Vec3 delta = GeometryUtils::GetMouseWorldPosition(cursorPos, camera, 5.0, true) - dragState.dragStartMouseWorldPos;
+
+			const auto moveSphere = [&](int32 index, const Vec3& initialPosition)
+			{
+				const Vec3 spherePos{ Config::DragPlaneX, (initialPosition.y + delta.y), (initialPosition.z + delta.z) };
+				spheres.setPosition(index, spherePos);
+
+				// 取り外された球のBVHを差分更新
+				BVHUtils::RefitSphere(pickIndex.detachedSpheres, index, spherePos, Config::SphereRadius);
+			};
+
+			if (dragState.groupInitialPositions)
+			{
+				for (size_t k = 0; k < dragState.selectedSpheres.size(); ++k)
+				{
+					if (const auto index = spheres.indexOf(dragState.selectedSpheres[k]))
 					{
-						originalSpherePos = spheres[*clickedSphere].position;
+						moveSphere(static_cast<int32>(*index), dragState.groupInitialPositions[k]);
 					}
+				}
+			}
+			else if (const auto index = spheres.indexOf(dragState.draggedSphere))
+			{
+				moveSphere(static_cast<int32>(*index), dragState.initialDragPosition);
+			}
+		};
+
+		// 球のドラッグ&ドロップ処理
+		if (input.mouseLDown && (not dragState.isInteracting()))
+		{
+			if (input.isSelectModifierPressed)
+			{
+				// 範囲選択を開始
+				dragState.isSelecting = true;
+				dragState.selectionStart = input.mouseLDownPos;
+				dragState.selectionEnd = input.mouseLDownPos;
+				startedInteraction = true;
+			}
+			else
+			{
+				// 押した瞬間の位置で球をクリックしたかチェック
+				const auto clickedSphere = CheckSphereClick(input.mouseLDownPos, spheres, pickIndex, camera, transform, arena);
+				if (clickedSphere && spheres.isYellow(*clickedSphere))
+				{
+					const SphereHandle clickedHandle = spheres.handleAt(*clickedSphere);
+					dragState.isDragging = true;
+					dragState.draggedSphere = clickedHandle;
+					startedInteraction = true;
+					dragState.snapTracker.isValid = false;
+					EditHistoryUtils::BeginStep(history);
 
-					// vC[ƋԒx=3ʂ̌_vZ
-					const auto intersection = GeometryUtils::GetLinePlaneIntersection(playerPos, originalSpherePos, Config::DragPlaneX);
-					if (intersection)
+					// 選択した球をクリックしたら選択した球をまとめて、それ以外は選択を解除してクリックした球だけをドラッグ
+					dragState.groupInitialPositions.clear();
+					if ((2 <= dragState.selectedSpheres.size()) && dragState.selectedSpheres.includes(clickedHandle))
 					{
-						spheres[*clickedSphere].position = *intersection;
+						SYNCSONG_TRACE_SCOPE("BeginGroupDrag");
+						dragState.selectedSpheres.remove_if([&](const SphereHandle& handle) { return (not spheres.indexOf(handle)); });
+						for (const SphereHandle& handle : dragState.selectedSpheres)
+						{
+							dragState.groupInitialPositions.push_back(beginDragSphere(static_cast<int32>(*spheres.indexOf(handle))));
+						}
 					}
 					else
 					{
-						// _vZłȂꍇ͊̕@gp
-						spheres[*clickedSphere].position.x = Config::DragPlaneX;
+						dragState.selectedSpheres.clear();
+						beginDragSphere(*clickedSphere);
 					}
 
-					dragState.initialDragPosition = spheres[*clickedSphere].position;
-					dragState.lastMouseWorldPos = GeometryUtils::GetMouseWorldPosition(mousePos, camera, 5.0, true);
-
-					// O: ̈ʒuɊDF̋쐬
-					if (spheres[*clickedSphere].isAttached)
-					{
-						spheres[*clickedSphere].isAttached = false;
-						// VDF̋̈ʒui]ϊOjɒǉ
-						spheres.emplace_back(gridPositions[*clickedSphere], true, false, *clickedSphere);
-					}
+					dragState.initialDragPosition = spheres.position(*spheres.indexOf(clickedHandle));
+					dragState.dragStartMouseWorldPos = GeometryUtils::GetMouseWorldPosition(input.mouseLDownPos, camera, 5.0, true);
+				}
+				else
+				{
+					// 球のない所をクリックしたら選択を解除
+					dragState.selectedSpheres.clear();
 				}
 			}
 		}
 
-		// hbȌ
-		if (dragState.isDragging && MouseL.pressed())
+		// 範囲選択中は矩形を広げ、離したら矩形の中の黄色の球を選択（このフレームで押した場合は、押した後に離したときだけ）
+		if (dragState.isSelecting)
 		{
-			const Vec3 currentMouseWorldPos = GeometryUtils::GetMouseWorldPosition(mousePos, camera, 5.0, true);
-			const Vec3 delta = currentMouseWorldPos - dragState.lastMouseWorldPos;
+			dragState.selectionEnd = mousePos;
 
-			// hbŐ̈ʒuXVixW͌Œj
-			Vec3& spherePos = spheres[dragState.draggedSphereIndex].position;
-			spherePos.y += delta.y;
-			spherePos.z += delta.z;
-			spherePos.x = Config::DragPlaneX; // xWŒ
+			if (input.mouseLUp && (wasSelecting || (input.mouseLDownTime <= input.mouseLUpTime)))
+			{
+				dragState.selectionEnd = input.mouseLUpPos;
+				SelectSpheresInRect(dragState.selectedSpheres, dragState.selectionStart, dragState.selectionEnd, spheres, camera, transform);
+				dragState.isSelecting = false;
+			}
+		}
 
-			dragState.lastMouseWorldPos = currentMouseWorldPos;
+		// ドラッグ中の球のハンドルが無効になっていたらドラッグを終了
+		const auto draggedIndex = spheres.indexOf(dragState.draggedSphere);
+		if (dragState.isDragging && (not draggedIndex))
+		{
+			EditHistoryUtils::EndStep(history);
+			dragState.isDragging = false;
+			dragState.draggedSphere = SphereHandle{};
+			dragState.selectedSpheres.clear();
+			dragState.groupInitialPositions.clear();
 		}
 
-		// hbv
-		if (dragState.isDragging && MouseL.up())
+		// ドラッグ中の処理
+		if (dragState.isDragging && input.mouseLPressed)
 		{
-			// Xibv^[Qbg
-			const auto snapTarget = FindSnapTarget(
-				spheres[dragState.draggedSphereIndex].position,
-				spheres,
-				dragState.draggedSphereIndex,
-				playerPos,
-				transform
-			);
+			moveDraggedSpheres(mousePos);
+		}
+
+		// ドロップ処理（このフレームで押した場合は、押した後に離したときだけ）
+		if (dragState.isDragging && input.mouseLUp && (wasDragging || (input.mouseLDownTime <= input.mouseLUpTime)))
+		{
+			// 離した瞬間の位置に動かしてから、スナップターゲットを検索
+			// 前のフレームの候補を使い回すと結果がフレームレートで変わりうるので、必ず計算し直す
+			moveDraggedSpheres(input.mouseLUpPos);
+
+			if (dragState.groupInitialPositions)
+			{
+				SYNCSONG_TRACE_SCOPE("DropGroup");
+
+				const std::span<int32> droppedIndices = arena.allocateArray<int32>(dragState.selectedSpheres.size());
+				size_t droppedCount = 0;
+				for (size_t k = 0; k < dragState.selectedSpheres.size(); ++k)
+				{
+					if (const auto index = spheres.indexOf(dragState.selectedSpheres[k]))
+					{
+						droppedIndices[droppedCount++] = static_cast<int32>(*index);
+						EditHistoryUtils::AddMove(history, static_cast<int32>(*index), dragState.groupInitialPositions[k], spheres.position(*index));
+					}
+				}
+
+				// 落とした球ごとに、ほかの球と重ならない最も近い灰色の球を一括で割り当てる
+				const std::span<const int32> dropped = droppedIndices.first(droppedCount);
+				const std::span<const int32> targets = ResolveGroupSnapTargets(dropped, spheres, pickIndex, playerPos, transform, arena);
+
+				// 灰色の球を黄色にしてから、スナップした球を削除（削除でインデックスが変わるのでハンドルで指す）
+				const std::span<SphereHandle> snappedSpheres = arena.allocateArray<SphereHandle>(droppedCount);
+				size_t snappedCount = 0;
+				for (size_t k = 0; k < droppedCount; ++k)
+				{
+					if (0 <= targets[k])
+					{
+						spheres.setYellow(targets[k], true);
+						EditHistoryUtils::AddSnap(history, targets[k]);
+						snappedSpheres[snappedCount++] = spheres.handleAt(dropped[k]);
+					}
+					else
+					{
+						// ドラッグ中の差分更新で崩れた木を挿入し直す
+						BVHUtils::ReinsertSphere(pickIndex.detachedSpheres, dropped[k], spheres.position(dropped[k]), Config::SphereRadius);
+					}
+				}
 
-			if (snapTarget)
+				for (const SphereHandle& handle : snappedSpheres.first(snappedCount))
+				{
+					const int32 index = static_cast<int32>(*spheres.indexOf(handle));
+					EditHistoryUtils::AddErase(history, index, spheres.get(index));
+					RemoveSphere(spheres, pickIndex, index);
+				}
+
+				dragState.selectedSpheres.clear();
+				dragState.groupInitialPositions.clear();
+			}
+			else
 			{
-				// Xibv: DF̋FɕύXAhbOĂ폜
-				spheres[*snapTarget].isYellow = true;
-				spheres.erase(spheres.begin() + dragState.draggedSphereIndex);
+				// 最もインデックスの小さい候補にスナップ
+				const int32 index = static_cast<int32>(*draggedIndex);
+				EditHistoryUtils::AddMove(history, index, dragState.initialDragPosition, spheres.position(index));
+				dragState.snapTracker.isValid = false;
+				UpdateSnapTracker(dragState.snapTracker, spheres.position(index), spheres, index, playerPos, transform);
+				const auto snapTarget = GetFirstSetBit(dragState.snapTracker.highlightBits);
+
+				if (snapTarget)
+				{
+					// スナップ: 灰色の球を黄色に変更し、ドラッグしていた球を削除
+					spheres.setYellow(*snapTarget, true);
+					EditHistoryUtils::AddSnap(history, *snapTarget);
+					EditHistoryUtils::AddErase(history, index, spheres.get(index));
+					RemoveSphere(spheres, pickIndex, index);
+				}
+				else
+				{
+					// ドラッグ中の差分更新で崩れた木を挿入し直す
+					BVHUtils::ReinsertSphere(pickIndex.detachedSpheres, index, spheres.position(index), Config::SphereRadius);
+				}
 			}
 
+			EditHistoryUtils::EndStep(history);
 			dragState.isDragging = false;
-			dragState.draggedSphereIndex = -1;
+			dragState.draggedSphere = SphereHandle{};
 		}
 
-		// fobOpFhbO̓XibvXV
+		// デバッグ用：ドラッグ中はスナップ候補を更新
 		if (dragState.isDragging)
 		{
-			dragState.snapCandidates = GetSnapCandidates(
-				spheres[dragState.draggedSphereIndex].position,
-				spheres,
-				dragState.draggedSphereIndex,
-				playerPos,
-				transform
-			);
+			const int32 index = static_cast<int32>(*draggedIndex);
+			UpdateSnapTracker(dragState.snapTracker, spheres.position(index), spheres, index, playerPos, transform);
 		}
 		else
 		{
-			dragState.snapCandidates.clear();
+			// バッファは次のドラッグで使い回す
+			dragState.snapTracker.highlightBits.clear();
+			dragState.snapTracker.isValid = false;
 		}
+
+		return startedInteraction;
 	}
 
-	void ProcessRotation(double& rotationAngle, bool isAutoRotationEnabled, bool isDragging)
+	void ProcessRotation(double& rotationAngle, const FrameInput& input, double beginTime, double endTime, bool applyMouseRotation)
 	{
-		// ]
-		if (isAutoRotationEnabled)
+		SYNCSONG_TRACE_SCOPE("ProcessRotation");
+		const double duration = Max((endTime - beginTime), 0.0);
+
+		// 音楽同期（フレーム時間ではなく再生位置の進みで回すので、音楽に対してずれが溜まらない）
+		if (input.isMusicSyncEnabled)
+		{
+			// 再生位置の進みをフレームの中で均等に割り振る
+			const double fraction = ((0.0 < input.deltaTime) ? Min((duration / input.deltaTime), 1.0) : 0.0);
+			rotationAngle += (input.musicDeltaTime * fraction * Math::ToRadians(Config::RotationSpeedDeg));
+		}
+		// 自動回転
+		else if (input.isAutoRotationEnabled)
 		{
-			rotationAngle += (Scene::DeltaTime() * Math::ToRadians(Config::RotationSpeedDeg));
+			rotationAngle += (duration * Math::ToRadians(Config::RotationSpeedDeg));
 		}
 
-		// }EXɂ]ihbOłȂꍇ̂݁j
-		if (MouseL.pressed() && !isDragging)
+		// マウスによる回転（ドラッグしていない場合のみ）
+		// 押していた間の移動量を使うので、押してから離すまでの回転はティックの区切り方によらない
+		if (applyMouseRotation)
 		{
-			rotationAngle += (Cursor::Delta().y * Config::MouseRotationFactor * Math::Pi / 180.0);
+			rotationAngle += (input.pressedCursorDelta.y * Config::MouseRotationFactor * Math::Pi / 180.0);
 		}
 	}
 }
\ No newline at end of file
@@ -1,25 +1,82 @@
 #pragma once
 #include <Siv3D.hpp>
+#include "Config.hpp"
 #include "GameTypes.hpp"
+#include "SphereStore.hpp"
+#include "FrameArena.hpp"
+#include "EditHistory.hpp"
+
+// ゲーム全体の状態（ロジックが更新するものすべて）
+struct GameState
+{
+	Array<Vec3> gridPositions; // 円筒上の格子（回転変換前）
+	SphereStore spheres;
+	SpherePickIndex pickIndex{
+		Config::CylinderRadius,
+		Config::CylinderHeight,
+		Config::GridUDiv,
+		Config::GridVDiv,
+		Config::GridMargin
+	};
+	DragState dragState;
+	double rotationAngle = 0.0;
+	EditHistory history; // 元に戻す・やり直しの履歴
+};
 
 namespace GameLogic
 {
-	// NbN`FbNi3DCLXggpj
-	Optional<int32> CheckSphereClick(const Vec2& mousePos, const Array<SphereState>& spheres,
-		const DebugCamera3D& camera, const Mat4x4& transform);
+	// 初期状態にする（すべて黄色で取り付けられた状態）
+	void InitializeGameState(GameState& state);
 
-	// Xibvł鋅
-	Optional<int32> FindSnapTarget(const Vec3& draggedPos, const Array<SphereState>& spheres, int32 excludeIndex,
-		const Vec3& playerPos, const Mat4x4& transform);
+	// 取り付けられている球の色を格子スロットごとのビット列（64 スロットずつ、1 が黄色）に合わせる
+	void ApplySlotColors(GameState& state, std::span<const uint64> yellowSlotBits);
+
+	// 取り付けられている球の色を格子スロットごとのビット列にする（ApplySlotColors の逆、外れている球のスロットは 0）
+	Array<uint64> GetSlotColors(const GameState& state);
+
+	// 1フレーム分ロジックを進める（camera は input の視点から作ったもの）
+	void UpdateGameState(GameState& state, const FrameInput& input, const BasicCamera3D& camera, FrameArena& arena);
+
+	// 最後のドラッグ&ドロップを元に戻す（戻せたら true。選択は解除する）
+	bool UndoEdit(GameState& state, FrameArena& arena);
+
+	// 元に戻したドラッグ&ドロップをやり直す（やり直せたら true。選択は解除する）
+	bool RedoEdit(GameState& state, FrameArena& arena);
 
-	// hbO&hbv
-	void ProcessDragAndDrop(Array<SphereState>& spheres, DragState& dragState, 
-		const DebugCamera3D& camera, const Mat4x4& transform, const Array<Vec3>& gridPositions);
+	// ピッキング用インデックスを球の状態から再構築
+	void RebuildPickIndex(const SphereStore& spheres, SpherePickIndex& pickIndex);
 
-	// ]
-	void ProcessRotation(double& rotationAngle, bool isAutoRotationEnabled, bool isDragging);
+	// 球をクリックしたかチェック（3Dレイキャストを使用、最も手前の球を返す）
+	Optional<int32> CheckSphereClick(const Vec2& mousePos, const SphereStore& spheres, const SpherePickIndex& pickIndex,
+		const BasicCamera3D& camera, const Mat4x4& transform, FrameArena& arena);
 
-	// fobOpFXibv擾
-	Array<int32> GetSnapCandidates(const Vec3& draggedPos, const Array<SphereState>& spheres, int32 excludeIndex,
+	// スナップできる球を検索
+	Optional<int32> FindSnapTarget(const Vec3& draggedPos, const SphereStore& spheres, int32 excludeIndex,
 		const Vec3& playerPos, const Mat4x4& transform);
+
+	// スナップ候補を更新（直線・回転の変化が小さければ前回の結果を使い回す）
+	void UpdateSnapTracker(SnapTracker& tracker, const Vec3& draggedPos, const SphereStore& spheres, int32 excludeIndex,
+		const Vec3& playerPos, const Mat4x4& transform);
+
+	// まとめてドロップした球（droppedIndices）のスナップ先を一括で決める（結果は arena に確保、-1 はスナップしない）
+	// 条件は FindSnapTarget と同じで、直線に近い組から順に、ほかの球が使っていない灰色の球を割り当てる
+	std::span<const int32> ResolveGroupSnapTargets(std::span<const int32> droppedIndices, const SphereStore& spheres, const SpherePickIndex& pickIndex,
+		const Vec3& playerPos, const Mat4x4& transform, FrameArena& arena);
+
+	// 画面上の矩形（corner0 ～ corner1）の中にある x >= 0 の黄色の球を選択
+	void SelectSpheresInRect(Array<SphereHandle>& selectedSpheres, const Vec2& corner0, const Vec2& corner1, const SphereStore& spheres,
+		const BasicCamera3D& camera, const Mat4x4& transform);
+
+	// ドラッグ&ドロップ処理（クリックは押した瞬間、ドロップは離した瞬間のカーソル位置で判定）
+	// Shift を押しながらドラッグすると範囲選択し、選択した球をドラッグするとまとめて動かす。このフレームでドラッグか範囲選択を始めたら true
+	// 押してから離すまでの取り外し・移動・スナップ・削除を history に1ステップとして記録する
+	bool ProcessDragAndDrop(SphereStore& spheres, DragState& dragState, SpherePickIndex& pickIndex, EditHistory& history,
+		const BasicCamera3D& camera, const Mat4x4& transform, const Array<Vec3>& gridPositions, FrameArena& arena, const FrameInput& input);
+
+	// 回転処理（フレームのうち beginTime ～ endTime 秒の分だけ自動回転・音楽同期で進める。applyMouseRotation ならマウスによる回転も加える）
+	void ProcessRotation(double& rotationAngle, const FrameInput& input, double beginTime, double endTime, bool applyMouseRotation);
+
+	// デバッグ用：スナップ候補を取得（結果は arena に確保）
+	std::span<const int32> GetSnapCandidates(const Vec3& draggedPos, const SphereStore& spheres, int32 excludeIndex,
+		const Vec3& playerPos, const Mat4x4& transform, FrameArena& arena);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 #include <Siv3D.hpp>
 
-// ̏ԂǗ\
+// 球の状態を管理する構造体
 struct SphereState
 {
 	Vec3 position;
@@ -15,13 +15,123 @@ struct SphereState
 	}
 };
 
-// hbOԂǗ\
+// 1フレーム分の入力（ゲームロジックはウィンドウではなくこれを参照する。記録・再生できる）
+struct FrameInput
+{
+	Vec2 cursorPos;
+	Vec2 cursorDelta;
+	Vec2 pressedCursorDelta; // 左ボタンを押していた間のカーソルの移動量（押した瞬間の位置から離した瞬間の位置まで。マウスによる回転に使う）
+	double deltaTime = 0.0;
+	Vec3 eyePosition;    // カメラ更新後の視点
+	Vec3 focusPosition;
+	Vec3 upDirection{ 0, 1, 0 };
+	bool mouseLDown = false;
+	bool mouseLPressed = false;
+	bool mouseLUp = false;
+	Vec2 mouseLDownPos;          // 押した瞬間のカーソル位置（mouseLDown のとき）
+	Vec2 mouseLUpPos;            // 離した瞬間のカーソル位置（mouseLUp のとき）
+	double mouseLDownTime = 0.0; // 押した時刻（前のフレームの入力からの秒、0 ～ deltaTime）
+	double mouseLUpTime = 0.0;   // 離した時刻
+	bool isSelectModifierPressed = false; // 押しながらドラッグすると範囲選択（Shift）
+	bool isUndoRequested = false;         // 最後のドラッグ&ドロップを元に戻す（Ctrl+Z）
+	bool isRedoRequested = false;         // 元に戻したドラッグ&ドロップをやり直す（Ctrl+Y、Ctrl+Shift+Z）
+	bool isAutoRotationEnabled = false;
+	bool isMusicSyncEnabled = false; // 自動回転の代わりに音楽の再生位置で回転する
+	double musicDeltaTime = 0.0;     // 前のフレームからの音楽の再生位置の進み（秒）
+};
+
+// 球を指す安定したハンドル（削除された球のハンドルは世代が一致しなくなる）
+struct SphereHandle
+{
+	uint32 slot = UINT32_MAX;
+	uint32 generation = 0;
+
+	bool operator==(const SphereHandle&) const = default;
+};
+
+// ドラッグ中のスナップ候補を差分更新するための状態（バッファは使い回す）
+struct SnapTracker
+{
+	Array<uint64> highlightBits; // 球ごとのスナップ候補ビット（64個ずつ）
+	Vec3 localLineStart;         // 前回計算したプレイヤー-ドラッグ球の直線（円筒ローカル座標）
+	Vec3 localLineEnd;
+	Vec4 filterPlane;            // 前回計算した x >= 0 の半空間（円筒ローカル座標、回転角で変わる）
+	int32 excludeIndex = -1;
+	bool isValid = false;
+
+	bool isHighlighted(size_t index) const
+	{
+		return (((index / 64) < highlightBits.size()) && ((highlightBits[index / 64] >> (index % 64)) & 1));
+	}
+};
+
+// ドラッグ状態を管理する構造体
 struct DragState
 {
 	bool isDragging = false;
-	int32 draggedSphereIndex = -1;
+	SphereHandle draggedSphere;  // ドラッグ中の球
 	Vec3 dragOffset;
-	Vec3 lastMouseWorldPos;
+	Vec3 dragStartMouseWorldPos; // 押した瞬間のカーソルの x=DragPlaneX 平面上の位置
 	Vec3 initialDragPosition;
-	Array<int32> snapCandidates; // XibṽCfbNXifobO\pj
+	SnapTracker snapTracker;     // スナップ候補（デバッグ表示用）
+
+	// 範囲選択（選択した球のどれかをドラッグすると、選択したすべての球をまとめてドラッグする）
+	Array<SphereHandle> selectedSpheres; // 選択した黄色の球（まとめてドラッグ中はドラッグしている球すべて、draggedSphere を含む）
+	Array<Vec3> groupInitialPositions;   // まとめてドラッグを始めたときの selectedSpheres の位置（単独のドラッグでは空）
+	bool isSelecting = false;
+	Vec2 selectionStart;                 // 範囲選択の矩形の対角（画面座標）
+	Vec2 selectionEnd;
+
+	// ドラッグか範囲選択の途中か（その間は円筒を回転しない）
+	bool isInteracting() const
+	{
+		return (isDragging || isSelecting);
+	}
+};
+
+// 描画でロジックのティックの間を補間するための、最後のティックを進める前の状態
+struct TickInterpolation
+{
+	double previousRotationAngle = 0.0;
+	SphereHandle previousDraggedSphere; // ドラッグしていなければ無効なハンドル
+	Vec3 previousDraggedPosition{ 0, 0, 0 };
+	double alpha = 1.0; // 前の状態から最後のティックの状態までの割合（1 なら最後のティックの状態をそのまま描画）
+};
+
+// 取り外された球のBVHノード（left == -1 なら葉）
+struct SphereBVHNode
+{
+	Vec3 boundsMin;
+	Vec3 boundsMax;
+	int32 parent = -1;
+	int32 left = -1;
+	int32 right = -1;
+	int32 height = 0;
+	int32 sphereIndex = -1;
+};
+
+// 取り外された球の動的BVH（ワールド座標のAABB木）
+struct SphereBVH
+{
+	Array<SphereBVHNode> nodes;
+	Array<int32> freeNodes;
+	Array<int32> sphereLeaves; // 球のインデックス → 葉ノード（登録されていなければ -1）
+	int32 root = -1;
+};
+
+// 球のピッキング用インデックス（円筒格子のスロット → 球、取り外された球のBVH）
+struct SpherePickIndex
+{
+	double radius;
+	double height;
+	int32 uDiv;
+	int32 vDiv;
+	double margin;
+	Array<int32> slotSpheres;     // 格子スロットごとに取り付けられている球のインデックス（空きは -1）
+	SphereBVH detachedSpheres;    // 取り外された球
+
+	SpherePickIndex(double r, double h, int32 u, int32 v, double m)
+		: radius(r), height(h), uDiv(u), vDiv(v), margin(m)
+	{
+	}
 };
\ No newline at end of file
@@ -1,41 +1,181 @@
 #include "GeometryUtils.hpp"
 #include "Config.hpp"
 
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	include <immintrin.h>
+#	define SYNCSONG_USE_SSE 1
+#endif
+
 namespace GeometryUtils
 {
-	Array<Vec3> GenerateCylinderGridPositions(double radius, double height, int32 u_div, int32 v_div, double margin)
+	namespace
 	{
-		Array<Vec3> positions;
-		if (u_div == 0 || v_div == 0)
+		// 点と直線の距離判定の前計算（直線の始点と単位方向ベクトル）
+		struct PointLineKernel
 		{
-			return positions;
-		}
+			Float3 origin;
+			Float3 direction;
+			float maxDistanceSq;
+			Float4 filterPlane;
+			bool degenerate;
+		};
 
-		const double effectiveHeight = height - (margin * 2.0);
-		if (effectiveHeight <= 0)
+		// [begin, end) の点をスカラーで判定
+		void CalculatePointToLineDistanceMaskScalar(const float* xs, const float* ys, const float* zs, size_t begin, size_t end,
+			const PointLineKernel& kernel, uint64* mask)
 		{
-			return positions;
+			for (size_t i = begin; i < end; ++i)
+			{
+				const float side = (kernel.filterPlane.x * xs[i] + kernel.filterPlane.y * ys[i] + kernel.filterPlane.z * zs[i] + kernel.filterPlane.w);
+				if (side < 0.0f)
+				{
+					continue;
+				}
+
+				const Float3 v{ xs[i] - kernel.origin.x, ys[i] - kernel.origin.y, zs[i] - kernel.origin.z };
+				const float distanceSq = (kernel.degenerate ? v.lengthSq() : v.cross(kernel.direction).lengthSq());
+
+				if (distanceSq < kernel.maxDistanceSq)
+				{
+					mask[i / 64] |= (uint64{ 1 } << (i % 64));
+				}
+			}
 		}
 
-		for (int32 v = 0; v < v_div; ++v)
+		// 円筒の格子の前計算（cos / sin は u だけに依存するので u ごとに1回だけ求める）
+		struct CylinderGridRows
+		{
+			Array<double> xs; // radius * cos
+			Array<double> ys; // radius * sin
+			double effectiveHeight = 0.0;
+		};
+
+		Optional<CylinderGridRows> MakeCylinderGridRows(double radius, double height, int32 u_div, int32 v_div, double margin)
 		{
-			const double z = (static_cast<double>(v) / (v_div - 1) - 0.5) * effectiveHeight;
+			if (u_div <= 0 || v_div <= 0)
+			{
+				return none;
+			}
+
+			const double effectiveHeight = height - (margin * 2.0);
+			if (effectiveHeight <= 0)
+			{
+				return none;
+			}
+
+			CylinderGridRows rows{ Array<double>(u_div), Array<double>(u_div), effectiveHeight };
 			for (int32 u = 0; u < u_div; ++u)
 			{
 				const double angle = (static_cast<double>(u) / u_div) * Math::TwoPi;
-				const double x = radius * Math::Cos(angle);
-				const double y = radius * Math::Sin(angle);
-				positions.push_back({ x, y, z });
+				rows.xs[u] = radius * Math::Cos(angle);
+				rows.ys[u] = radius * Math::Sin(angle);
 			}
+			return rows;
 		}
+
+		double GetCylinderGridZ(const CylinderGridRows& rows, int32 v, int32 v_div)
+		{
+			return (static_cast<double>(v) / (v_div - 1) - 0.5) * rows.effectiveHeight;
+		}
+
+		// 行 [0, rowCount) を分割して fn(beginRow, endRow) を呼ぶ（格子点が多いときだけ複数スレッドで）
+		template <class Fn>
+		void ForEachRowRange(int32 rowCount, size_t rowSize, Fn fn)
+		{
+			const size_t hardwareThreads = Max<size_t>(std::thread::hardware_concurrency(), 1);
+			const size_t threadCount = (((static_cast<size_t>(rowCount) * rowSize) < Config::GridParallelThreshold)
+				? 1 : Min(hardwareThreads, static_cast<size_t>(rowCount)));
+
+			if (threadCount <= 1)
+			{
+				fn(0, rowCount);
+				return;
+			}
+
+			// 最後の範囲は呼び出したスレッドで処理
+			Array<std::thread> threads;
+			threads.reserve(threadCount - 1);
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				const int32 beginRow = static_cast<int32>(rowCount * i / threadCount);
+				const int32 endRow = static_cast<int32>(rowCount * (i + 1) / threadCount);
+
+				if ((i + 1) < threadCount)
+				{
+					threads.emplace_back(fn, beginRow, endRow);
+				}
+				else
+				{
+					fn(beginRow, endRow);
+				}
+			}
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+	}
+
+	Array<Vec3> GenerateCylinderGridPositions(double radius, double height, int32 u_div, int32 v_div, double margin)
+	{
+		const auto rows = MakeCylinderGridRows(radius, height, u_div, v_div, margin);
+		if (not rows)
+		{
+			return{};
+		}
+
+		Array<Vec3> positions(static_cast<size_t>(u_div) * v_div);
+		ForEachRowRange(v_div, u_div, [&](int32 beginRow, int32 endRow)
+		{
+			for (int32 v = beginRow; v < endRow; ++v)
+			{
+				const double z = GetCylinderGridZ(*rows, v, v_div);
+				Vec3* row = &positions[static_cast<size_t>(v) * u_div];
+				for (int32 u = 0; u < u_div; ++u)
+				{
+					row[u] = Vec3{ rows->xs[u], rows->ys[u], z };
+				}
+			}
+		});
 		return positions;
 	}
 
+	void GenerateCylinderGrid(double radius, double height, int32 u_div, int32 v_div, double margin,
+		std::span<float> xs, std::span<float> ys, std::span<float> zs)
+	{
+		const auto rows = MakeCylinderGridRows(radius, height, u_div, v_div, margin);
+		if (not rows)
+		{
+			return;
+		}
+
+		// 行ごとに x / y は同じ並びなので float に変換した1行を書き写す
+		Array<float> rowXs(u_div);
+		Array<float> rowYs(u_div);
+		for (int32 u = 0; u < u_div; ++u)
+		{
+			rowXs[u] = static_cast<float>(rows->xs[u]);
+			rowYs[u] = static_cast<float>(rows->ys[u]);
+		}
+
+		ForEachRowRange(v_div, u_div, [&](int32 beginRow, int32 endRow)
+		{
+			for (int32 v = beginRow; v < endRow; ++v)
+			{
+				const size_t offset = (static_cast<size_t>(v) * u_div);
+				std::copy(rowXs.begin(), rowXs.end(), (xs.begin() + offset));
+				std::copy(rowYs.begin(), rowYs.end(), (ys.begin() + offset));
+				std::fill_n((zs.begin() + offset), u_div, static_cast<float>(GetCylinderGridZ(*rows, v, v_div)));
+			}
+		});
+	}
+
 	Optional<Vec3> GetLinePlaneIntersection(const Vec3& lineStart, const Vec3& lineEnd, double planeX)
 	{
 		const Vec3 direction = lineEnd - lineStart;
 
-		// xɕsȏꍇ͌Ȃ
+		// 線がx軸に平行な場合は交差しない
 		if (Math::Abs(direction.x) < 1e-6)
 		{
 			return none;
@@ -44,7 +184,7 @@ namespace GeometryUtils
 		// t = (planeX - lineStart.x) / direction.x
 		const double t = (planeX - lineStart.x) / direction.x;
 
-		// _vZ
+		// 交点を計算
 		return lineStart + direction * t;
 	}
 
@@ -65,12 +205,88 @@ namespace GeometryUtils
 		return cross.length();
 	}
 
+	void CalculatePointToLineDistanceMask(const float* xs, const float* ys, const float* zs, size_t count,
+		const Vec3& lineStart, const Vec3& lineEnd, double maxDistance, const Vec4& filterPlane, std::span<uint64> mask)
+	{
+		std::fill(mask.begin(), mask.end(), 0);
+
+		// 直線は全点で共通なので長さと方向を一度だけ計算
+		const Vec3 lineVec = lineEnd - lineStart;
+		const double lineLength = lineVec.length();
+
+		PointLineKernel kernel;
+		kernel.origin = Float3{ lineStart };
+		kernel.degenerate = (lineLength < 1e-6);
+		kernel.direction = (kernel.degenerate ? Float3{ 0, 0, 0 } : Float3{ lineVec / lineLength });
+		kernel.maxDistanceSq = static_cast<float>(maxDistance * maxDistance);
+		kernel.filterPlane = Float4{ filterPlane };
+
+		size_t i = 0;
+
+#if SYNCSONG_USE_SSE
+		// 直線が点に潰れている場合はスカラーで判定
+		if (not kernel.degenerate)
+		{
+			// 4点（AVX2 では8点）ずつ外積の長さの2乗としきい値を比較し、結果を movemask でビットに詰める
+			// 1ブロックは64点の境界をまたがない
+			// FMA は使わず、スカラー版と同じ順に掛けて足す（ビルドによってスナップ判定が変わらないように）
+	#if defined(__AVX2__)
+			const __m256 ox = _mm256_set1_ps(kernel.origin.x), oy = _mm256_set1_ps(kernel.origin.y), oz = _mm256_set1_ps(kernel.origin.z);
+			const __m256 dx = _mm256_set1_ps(kernel.direction.x), dy = _mm256_set1_ps(kernel.direction.y), dz = _mm256_set1_ps(kernel.direction.z);
+			const __m256 fx = _mm256_set1_ps(kernel.filterPlane.x), fy = _mm256_set1_ps(kernel.filterPlane.y);
+			const __m256 fz = _mm256_set1_ps(kernel.filterPlane.z), fw = _mm256_set1_ps(kernel.filterPlane.w);
+			const __m256 maxDistanceSq = _mm256_set1_ps(kernel.maxDistanceSq);
+
+			for (; (i + 8) <= count; i += 8)
+			{
+				const __m256 px = _mm256_loadu_ps(xs + i), py = _mm256_loadu_ps(ys + i), pz = _mm256_loadu_ps(zs + i);
+				const __m256 vx = _mm256_sub_ps(px, ox), vy = _mm256_sub_ps(py, oy), vz = _mm256_sub_ps(pz, oz);
+
+				const __m256 cx = _mm256_sub_ps(_mm256_mul_ps(vy, dz), _mm256_mul_ps(vz, dy));
+				const __m256 cy = _mm256_sub_ps(_mm256_mul_ps(vz, dx), _mm256_mul_ps(vx, dz));
+				const __m256 cz = _mm256_sub_ps(_mm256_mul_ps(vx, dy), _mm256_mul_ps(vy, dx));
+				const __m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz));
+				const __m256 side = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fx, px), _mm256_mul_ps(fy, py)), _mm256_mul_ps(fz, pz)), fw);
+
+				const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(distanceSq, maxDistanceSq, _CMP_LT_OQ),
+					_mm256_cmp_ps(side, _mm256_setzero_ps(), _CMP_GE_OQ));
+				mask[i / 64] |= (static_cast<uint64>(_mm256_movemask_ps(hit)) << (i % 64));
+			}
+	#else
+			const __m128 ox = _mm_set1_ps(kernel.origin.x), oy = _mm_set1_ps(kernel.origin.y), oz = _mm_set1_ps(kernel.origin.z);
+			const __m128 dx = _mm_set1_ps(kernel.direction.x), dy = _mm_set1_ps(kernel.direction.y), dz = _mm_set1_ps(kernel.direction.z);
+			const __m128 fx = _mm_set1_ps(kernel.filterPlane.x), fy = _mm_set1_ps(kernel.filterPlane.y);
+			const __m128 fz = _mm_set1_ps(kernel.filterPlane.z), fw = _mm_set1_ps(kernel.filterPlane.w);
+			const __m128 maxDistanceSq = _mm_set1_ps(kernel.maxDistanceSq);
+
+			for (; (i + 4) <= count; i += 4)
+			{
+				const __m128 px = _mm_loadu_ps(xs + i), py = _mm_loadu_ps(ys + i), pz = _mm_loadu_ps(zs + i);
+				const __m128 vx = _mm_sub_ps(px, ox), vy = _mm_sub_ps(py, oy), vz = _mm_sub_ps(pz, oz);
+
+				const __m128 cx = _mm_sub_ps(_mm_mul_ps(vy, dz), _mm_mul_ps(vz, dy));
+				const __m128 cy = _mm_sub_ps(_mm_mul_ps(vz, dx), _mm_mul_ps(vx, dz));
+				const __m128 cz = _mm_sub_ps(_mm_mul_ps(vx, dy), _mm_mul_ps(vy, dx));
+				const __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz));
+				const __m128 side = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(fx, px), _mm_mul_ps(fy, py)), _mm_mul_ps(fz, pz)), fw);
+
+				const __m128 hit = _mm_and_ps(_mm_cmplt_ps(distanceSq, maxDistanceSq), _mm_cmpge_ps(side, _mm_setzero_ps()));
+				mask[i / 64] |= (static_cast<uint64>(_mm_movemask_ps(hit)) << (i % 64));
+			}
+	#endif
+		}
+#endif
+
+		// 残りの点（SIMD 非対応環境ではすべての点）
+		CalculatePointToLineDistanceMaskScalar(xs, ys, zs, i, count, kernel, mask.data());
+	}
+
 	Optional<Vec3> GetRayPlaneIntersection(const Ray& ray, double planeX)
 	{
 		const Vec3 origin = ray.getOrigin();
 		const Vec3 direction = ray.getDirection();
 
-		// C̕xɕsȏꍇ͌Ȃ
+		// レイの方向がx軸に平行な場合は交差しない
 		if (Math::Abs(direction.x) < 1e-6)
 		{
 			return none;
@@ -79,23 +295,165 @@ namespace GeometryUtils
 		// t = (planeX - origin.x) / direction.x
 		const double t = (planeX - origin.x) / direction.x;
 
-		// _Čɂꍇ͖
+		// 交点がレイの後方にある場合は無効
 		if (t < 0)
 		{
 			return none;
 		}
 
-		// _vZ
+		// 交点を計算
 		return origin + direction * t;
 	}
 
-	Vec3 GetMouseWorldPosition(const Vec2& mousePos, const DebugCamera3D& camera, double distance, bool constrainToPlane)
+	Optional<Vec2> GetRayCylinderShellInterval(const Vec3& origin, const Vec3& direction, double innerRadius, double outerRadius)
+	{
+		// XY平面に射影して円との交差を解く
+		const double a = (direction.x * direction.x + direction.y * direction.y);
+		const double b = 2.0 * (origin.x * direction.x + origin.y * direction.y);
+		const double originRadiusSq = (origin.x * origin.x + origin.y * origin.y);
+
+		// レイが円筒の軸に平行な場合は、始点が殻の中にあるときだけ交差する
+		if (a < 1e-12)
+		{
+			if ((innerRadius * innerRadius <= originRadiusSq) && (originRadiusSq <= outerRadius * outerRadius))
+			{
+				return Vec2{ 0.0, Math::Inf };
+			}
+			return none;
+		}
+
+		const double outerDisc = b * b - 4.0 * a * (originRadiusSq - outerRadius * outerRadius);
+		if (outerDisc < 0)
+		{
+			return none;
+		}
+
+		const double outerSqrt = Math::Sqrt(outerDisc);
+		const double outerExit = (-b + outerSqrt) / (2.0 * a);
+		if (outerExit < 0)
+		{
+			return none;
+		}
+
+		double t0 = Max((-b - outerSqrt) / (2.0 * a), 0.0);
+		double t1 = outerExit;
+
+		const double innerDisc = b * b - 4.0 * a * (originRadiusSq - innerRadius * innerRadius);
+		if (innerDisc >= 0)
+		{
+			const double innerSqrt = Math::Sqrt(innerDisc);
+			const double innerEnter = (-b - innerSqrt) / (2.0 * a);
+			const double innerExit = (-b + innerSqrt) / (2.0 * a);
+
+			if (originRadiusSq < innerRadius * innerRadius)
+			{
+				// 始点が内側の円筒内にある場合は、内側から出た地点から
+				t0 = innerExit;
+			}
+			else if (t0 <= innerEnter)
+			{
+				// 内側の円筒（不透明）に入るまでが手前側の区間
+				t1 = innerEnter;
+			}
+		}
+
+		return Vec2{ t0, t1 };
+	}
+
+	std::array<Vec4, 5> GetFrustumPlanes(const BasicCamera3D& camera)
+	{
+		const Vec3 eye = camera.getEyePosition();
+		const Vec3 forward = (camera.getFocusPosition() - eye).normalized();
+		const Vec3 right = camera.getUpDirection().cross(forward).normalized();
+		const Vec3 up = forward.cross(right);
+
+		const Size sceneSize = camera.getSceneSize();
+		const double tanHalfY = Math::Tan(camera.getVerticalFOV() * 0.5);
+		const double tanHalfX = (tanHalfY * sceneSize.x / sceneSize.y);
+
+		// 視点を通る平面（視線方向から画角の分だけ傾けた内向きの法線）
+		const auto makePlane = [&](const Vec3& normal)
+		{
+			const Vec3 n = normal.normalized();
+			return Vec4{ n, -n.dot(eye) };
+		};
+
+		return{
+			makePlane(forward * tanHalfX + right),
+			makePlane(forward * tanHalfX - right),
+			makePlane(forward * tanHalfY + up),
+			makePlane(forward * tanHalfY - up),
+			Vec4{ forward, -(forward.dot(eye) + camera.getNearClip()) },
+		};
+	}
+
+	bool IsSphereOutsideFrustum(const std::array<Vec4, 5>& frustumPlanes, const Vec3& center, double radius)
+	{
+		for (const Vec4& plane : frustumPlanes)
+		{
+			if ((plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w) < -radius)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool IsSphereOccludedByCylinder(const Vec3& eyePosition, const Vec3& center, double radius, double cylinderRadius, double cylinderHeight)
+	{
+		// 視点から球のどの点への線分も、円筒の高さの範囲内で側面を通ることを保証する
+		const double halfHeight = (cylinderHeight * 0.5);
+		if ((halfHeight < Math::Abs(eyePosition.z)) || (halfHeight < (Math::Abs(center.z) + radius)))
+		{
+			return false;
+		}
+
+		const Vec2 eye = eyePosition.xy();
+		const double eyeDistance = eye.length();
+		if (eyeDistance <= cylinderRadius)
+		{
+			return false;
+		}
+
+		// XY平面で、視点から円に引いた2本の接線の内側かつ接点を結ぶ弦より奥が円の影
+		const Vec2 toAxis = (eye / -eyeDistance);
+		const Vec2 toCenter = (center.xy() - eye);
+		const double along = toCenter.dot(toAxis);
+		const double across = Math::Abs(toCenter.x * toAxis.y - toCenter.y * toAxis.x);
+
+		const double chordDistance = (eyeDistance - (cylinderRadius * cylinderRadius / eyeDistance));
+		if ((along - radius) < chordDistance)
+		{
+			return false;
+		}
+
+		// 接線までの距離 = along * sinα - across * cosα（α は接線と視線の角度）
+		const double sinAlpha = (cylinderRadius / eyeDistance);
+		const double cosAlpha = Math::Sqrt(1.0 - sinAlpha * sinAlpha);
+		return (radius <= (along * sinAlpha - across * cosAlpha));
+	}
+
+	Vec2 GetCylinderGridCoordinates(const Vec3& localPos, double height, int32 u_div, int32 v_div, double margin)
+	{
+		double angle = Math::Atan2(localPos.y, localPos.x);
+		if (angle < 0)
+		{
+			angle += Math::TwoPi;
+		}
+
+		const double effectiveHeight = height - (margin * 2.0);
+		const double u = (angle / Math::TwoPi) * u_div;
+		const double v = (localPos.z / effectiveHeight + 0.5) * (v_div - 1);
+		return{ u, v };
+	}
+
+	Vec3 GetMouseWorldPosition(const Vec2& mousePos, const BasicCamera3D& camera, double distance, bool constrainToPlane)
 	{
 		const Ray ray = camera.screenToRay(mousePos);
 
 		if (constrainToPlane)
 		{
-			// x=3̕ʂƂ̌_vZ
+			// x=3の平面との交点を計算
 			const auto intersection = GetRayPlaneIntersection(ray, Config::DragPlaneX);
 			if (intersection)
 			{
@@ -103,7 +461,7 @@ namespace GeometryUtils
 			}
 		}
 
-		// ftHg̋x[X̌vZ
+		// デフォルトの距離ベースの計算
 		const Vec3 origin = ray.getOrigin();
 		const Vec3 direction = ray.getDirection();
 		return origin + direction * distance;
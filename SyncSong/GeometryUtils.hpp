@@ -3,18 +3,99 @@
 
 namespace GeometryUtils
 {
-	// ~̋ȖʏɃObh𐶐
+	// 円筒の曲面上にグリッドを生成（大きな格子は行ごとに並列に生成）
 	Array<Vec3> GenerateCylinderGridPositions(double radius, double height, int32 u_div, int32 v_div, double margin);
 
-	// 3Dƕ x=planeX ̌_vZ
+	// GenerateCylinderGridPositions と同じ格子を float の SoA に書き出す（xs/ys/zs は u_div * v_div 要素）
+	void GenerateCylinderGrid(double radius, double height, int32 u_div, int32 v_div, double margin,
+		std::span<float> xs, std::span<float> ys, std::span<float> zs);
+
+	// コンパイル時に使える (cos, sin)（格子の表を埋め込むため）
+	constexpr Vec2 ConstexprCosSin(double angle)
+	{
+		// [-π, π] に畳み込み、さらに [-π/2, π/2] に折り返してからテイラー展開
+		const double turns = (angle / Math::TwoPi);
+		angle -= (static_cast<int64>(turns + ((0.0 <= turns) ? 0.5 : -0.5)) * Math::TwoPi);
+
+		double cosSign = 1.0;
+		if (Math::HalfPi < angle)
+		{
+			angle = (Math::Pi - angle);
+			cosSign = -1.0;
+		}
+		else if (angle < -Math::HalfPi)
+		{
+			angle = (-Math::Pi - angle);
+			cosSign = -1.0;
+		}
+
+		const double angleSq = (angle * angle);
+		double c = 1.0;
+		double s = angle;
+		double cosTerm = 1.0;
+		double sinTerm = angle;
+		for (int32 n = 1; n <= 12; ++n)
+		{
+			cosTerm *= (-angleSq / ((2 * n - 1) * (2 * n)));
+			sinTerm *= (-angleSq / ((2 * n) * (2 * n + 1)));
+			c += cosTerm;
+			s += sinTerm;
+		}
+
+		return{ (c * cosSign), s };
+	}
+
+	// 円筒の曲面上のグリッドをコンパイル時に生成（GenerateCylinderGridPositions と同じ並び）
+	template <int32 UDiv, int32 VDiv>
+	constexpr std::array<Vec3, (UDiv * VDiv)> MakeCylinderGridTable(double radius, double height, double margin)
+	{
+		static_assert((0 < UDiv) && (1 < VDiv));
+
+		std::array<Vec3, (UDiv * VDiv)> positions{};
+		const double effectiveHeight = height - (margin * 2.0);
+
+		for (int32 v = 0; v < VDiv; ++v)
+		{
+			const double z = (static_cast<double>(v) / (VDiv - 1) - 0.5) * effectiveHeight;
+			for (int32 u = 0; u < UDiv; ++u)
+			{
+				const Vec2 cs = ConstexprCosSin((static_cast<double>(u) / UDiv) * Math::TwoPi);
+				positions[v * UDiv + u] = Vec3{ (radius * cs.x), (radius * cs.y), z };
+			}
+		}
+		return positions;
+	}
+
+	// 3D線と平面 x=planeX の交点を計算
 	Optional<Vec3> GetLinePlaneIntersection(const Vec3& lineStart, const Vec3& lineEnd, double planeX);
 
-	// _ƒ̋vZiŁj
+	// 点と直線の距離を計算（無限直線版）
 	double CalculatePointToLineDistance(const Vec3& point, const Vec3& lineStart, const Vec3& lineEnd);
 
-	// x=planeX ̕ʂƃČ_vZ
+	// SoA の点群と直線の距離が maxDistance 未満かを一括判定し、結果をビットマスク（64点ずつ、(count + 63) / 64 ワード）に書き出す
+	// filterPlane = (a, b, c, d) のとき a*x + b*y + c*z + d < 0 の点は除外（AVX2/SSE、非対応環境ではスカラー）
+	void CalculatePointToLineDistanceMask(const float* xs, const float* ys, const float* zs, size_t count,
+		const Vec3& lineStart, const Vec3& lineEnd, double maxDistance, const Vec4& filterPlane, std::span<uint64> mask);
+
+	// x=planeX の平面とレイの交点を計算
 	Optional<Vec3> GetRayPlaneIntersection(const Ray& ray, double planeX);
 
-	// }EXʒuɑΉ3Dʒu擾iJCgpj
-	Vec3 GetMouseWorldPosition(const Vec2& mousePos, const DebugCamera3D& camera, double distance = 5.0, bool constrainToPlane = false);
+	// Z軸を中心とする円筒殻（innerRadius～outerRadius）をレイが手前側で通過する区間 [t0, t1] を計算
+	Optional<Vec2> GetRayCylinderShellInterval(const Vec3& origin, const Vec3& direction, double innerRadius, double outerRadius);
+
+	// カメラの視錐台の左右上下と近クリップ面（(a, b, c, d) で a*x + b*y + c*z + d < 0 が外側、(a, b, c) は単位ベクトル。遠クリップ面は省略）
+	std::array<Vec4, 5> GetFrustumPlanes(const BasicCamera3D& camera);
+
+	// 球が視錐台の平面のいずれかの完全に外側にあるか
+	bool IsSphereOutsideFrustum(const std::array<Vec4, 5>& frustumPlanes, const Vec3& center, double radius);
+
+	// Z軸を中心とする原点中心の円筒（cylinderRadius、cylinderHeight）に視点から完全に隠れる球か
+	// 保守的な判定（視点と球がともに円筒の高さの範囲内にあるときだけ、XY平面で円の影に入るかを調べる）
+	bool IsSphereOccludedByCylinder(const Vec3& eyePosition, const Vec3& center, double radius, double cylinderRadius, double cylinderHeight);
+
+	// 円筒ローカル座標の点を GenerateCylinderGridPositions の格子座標 (u, v) に変換（連続値）
+	Vec2 GetCylinderGridCoordinates(const Vec3& localPos, double height, int32 u_div, int32 v_div, double margin);
+
+	// マウス位置に対応する3D位置を取得（カメラレイを使用）
+	Vec3 GetMouseWorldPosition(const Vec2& mousePos, const BasicCamera3D& camera, double distance = 5.0, bool constrainToPlane = false);
 }
\ No newline at end of file
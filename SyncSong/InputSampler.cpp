@@ -0,0 +1,198 @@
+#include "InputSampler.hpp"
+#include "Config.hpp"
+#include "FrameTracer.hpp"
+
+#if SIV3D_PLATFORM(WINDOWS)
+#	include <Siv3D/Windows/Windows.hpp>
+#endif
+
+namespace InputSamplerUtils
+{
+	namespace
+	{
+#if SIV3D_PLATFORM(WINDOWS)
+		// 左ボタン（左右を入れ替えている場合は物理的な右ボタン）が押されているか
+		bool IsLeftButtonDown()
+		{
+			const int virtualKey = (::GetSystemMetrics(SM_SWAPBUTTON) ? VK_RBUTTON : VK_LBUTTON);
+			return ((::GetAsyncKeyState(virtualKey) & 0x8000) != 0);
+		}
+
+		// ウィンドウが前面にあり、カーソルがクライアント領域の中にあるか
+		bool IsCursorOnWindow(HWND hWnd, const POINT& clientPos)
+		{
+			RECT rect;
+			return ((::GetForegroundWindow() == hWnd) && ::GetClientRect(hWnd, &rect) && ::PtInRect(&rect, clientPos));
+		}
+
+		// ボタンとカーソルを細かく読み取り、ボタンの状態が変化した時刻と位置を記録する
+		void RunPoller(InputSampler& sampler, HWND hWnd)
+		{
+			FrameTracer::SetCurrentThreadName(U"input sampler");
+
+			bool wasPressed = false;
+			while (not sampler.stopRequested.load(std::memory_order_relaxed))
+			{
+				POINT point;
+				::GetCursorPos(&point);
+				::ScreenToClient(hWnd, &point);
+				const double timeSec = sampler.stopwatch.sF();
+
+				// 押し始めはウィンドウの上でだけ受け付け、離すのはどこでも受け付ける
+				const bool pressed = (IsLeftButtonDown() && (wasPressed || IsCursorOnWindow(hWnd, point)));
+
+				if (pressed != wasPressed)
+				{
+					std::lock_guard lock{ sampler.mutex };
+					sampler.pendingEvents.push_back(MouseButtonEvent{ pressed, Vec2{ point.x, point.y }, timeSec });
+					sampler.isPressed = pressed;
+					wasPressed = pressed;
+				}
+
+				std::this_thread::sleep_for(std::chrono::microseconds{ Config::InputPollIntervalUs });
+			}
+		}
+#endif
+	}
+
+	bool Start(InputSampler& sampler)
+	{
+		Stop(sampler);
+
+#if SIV3D_PLATFORM(WINDOWS)
+		const HWND hWnd = static_cast<HWND>(Platform::Windows::Window::GetHWND());
+		if (not hWnd)
+		{
+			return false;
+		}
+
+		sampler.pendingEvents.clear();
+		sampler.isPressed = false;
+		sampler.lastCollectSec = sampler.stopwatch.sF();
+
+		sampler.stopRequested = false;
+		sampler.poller = std::thread{ RunPoller, std::ref(sampler), hWnd };
+		sampler.running = true;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void Stop(InputSampler& sampler)
+	{
+		if (not sampler.running)
+		{
+			return;
+		}
+
+		sampler.stopRequested = true;
+		sampler.poller.join();
+		sampler.running = false;
+	}
+
+	MouseButtonFrame Collect(InputSampler& sampler, double deltaTime)
+	{
+		const double nowSec = sampler.stopwatch.sF();
+		const double frameBeginSec = sampler.lastCollectSec;
+		sampler.lastCollectSec = nowSec;
+
+		MouseButtonFrame frame;
+
+		if (not sampler.running)
+		{
+			// フレームごとの入力（押した・離した瞬間はフレームの終わりとみなす）
+			frame.down = MouseL.down();
+			frame.pressed = MouseL.pressed();
+			frame.up = MouseL.up();
+			frame.downPos = frame.upPos = Cursor::PosF();
+			frame.downTime = frame.upTime = deltaTime;
+
+			if (frame.down)
+			{
+				sampler.pressSec = nowSec;
+			}
+			return frame;
+		}
+
+		{
+			std::lock_guard lock{ sampler.mutex };
+			std::swap(sampler.pendingEvents, sampler.frameEvents);
+			frame.pressed = sampler.isPressed;
+		}
+
+		// 読み取りの時刻をフレームの中の時刻（deltaTime の尺度）に直す
+		const double frameSec = (nowSec - frameBeginSec);
+		const auto toFrameTime = [&](double timeSec)
+		{
+			return ((0.0 < frameSec) ? Clamp(((timeSec - frameBeginSec) / frameSec * deltaTime), 0.0, deltaTime) : deltaTime);
+		};
+
+		for (const MouseButtonEvent& event : sampler.frameEvents)
+		{
+			if (event.isPress)
+			{
+				if (not frame.down)
+				{
+					frame.down = true;
+					frame.downPos = Scene::ClientToScene(event.clientPos);
+					frame.downTime = toFrameTime(event.timeSec);
+					sampler.pressSec = event.timeSec;
+				}
+			}
+			else
+			{
+				frame.up = true;
+				frame.upPos = Scene::ClientToScene(event.clientPos);
+				frame.upTime = toFrameTime(event.timeSec);
+			}
+		}
+
+		// バッファは次のフレームで読み取りスレッドと入れ替えて使い回す
+		sampler.frameEvents.clear();
+		return frame;
+	}
+
+	void EndFrame(InputSampler& sampler, bool isHighlighted)
+	{
+		if (isHighlighted && (not sampler.wasHighlighted) && sampler.pressSec)
+		{
+			const double latencyMs = ((sampler.stopwatch.sF() - *sampler.pressSec) * 1000.0);
+			if (sampler.clickLatenciesMs.size() < Config::ClickLatencyLogCapacity)
+			{
+				sampler.clickLatenciesMs.push_back(latencyMs);
+			}
+			else
+			{
+				sampler.clickLatenciesMs[sampler.nextClickLatency] = latencyMs;
+				sampler.nextClickLatency = ((sampler.nextClickLatency + 1) % Config::ClickLatencyLogCapacity);
+			}
+			sampler.pressSec.reset();
+		}
+
+		sampler.wasHighlighted = isHighlighted;
+	}
+
+	ClickLatencyStats GetClickLatencyStats(InputSampler& sampler)
+	{
+		ClickLatencyStats stats;
+		stats.sampleCount = sampler.clickLatenciesMs.size();
+		if (stats.sampleCount == 0)
+		{
+			return stats;
+		}
+
+		// 並べ替えずに p50 と p99 の位置だけを求める（p99 を先に求め、その前の範囲から p50 を選ぶ）
+		Array<double>& values = sampler.clickLatencyScratch;
+		values.assign(sampler.clickLatenciesMs.begin(), sampler.clickLatenciesMs.end());
+
+		const size_t p50Index = (values.size() / 2);
+		const size_t p99Index = Min(static_cast<size_t>(values.size() * 0.99), (values.size() - 1));
+		std::nth_element(values.begin(), (values.begin() + p99Index), values.end());
+		stats.p99Ms = values[p99Index];
+		std::nth_element(values.begin(), (values.begin() + p50Index), (values.begin() + p99Index));
+		stats.p50Ms = ((p50Index < p99Index) ? values[p50Index] : stats.p99Ms);
+		stats.maxMs = *std::max_element((values.begin() + p99Index), values.end());
+		return stats;
+	}
+}
\ No newline at end of file
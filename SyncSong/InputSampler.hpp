@@ -0,0 +1,74 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 時刻つきのマウスの左ボタンのイベント
+struct MouseButtonEvent
+{
+	bool isPress = false; // false なら離した
+	Vec2 clientPos;       // クライアント座標（シーン座標への変換はメインスレッドで行う）
+	double timeSec = 0.0; // InputSampler::stopwatch の時刻
+};
+
+// 1フレーム分の左ボタンの入力（1フレームに何度も押した場合は最初に押した瞬間と最後に離した瞬間）
+struct MouseButtonFrame
+{
+	bool down = false;
+	bool pressed = false;
+	bool up = false;
+	Vec2 downPos;
+	Vec2 upPos;
+	double downTime = 0.0; // 前のフレームの Collect からの秒（0 ～ deltaTime）
+	double upTime = 0.0;
+};
+
+// クリックから強調表示までの遅延の集計
+struct ClickLatencyStats
+{
+	size_t sampleCount = 0;
+	double p50Ms = 0.0;
+	double p99Ms = 0.0;
+	double maxMs = 0.0;
+};
+
+// マウスの左ボタンとカーソルをフレームの間も別スレッドで細かく読み取り、押した・離した瞬間の位置と時刻を集める
+// フレームごとの入力では押した・離した位置と時刻がフレームの境界に丸められ、フレームレートで判定の結果が変わるため
+// 読み取りは Windows のみ。開始していなければフレームごとの Siv3D の入力を使う
+struct InputSampler
+{
+	Stopwatch stopwatch{ StartImmediately::Yes }; // イベントの時刻
+
+	// 読み取りスレッドが書き、メインスレッドが取り出す（mutex で保護）
+	std::thread poller;
+	std::mutex mutex;
+	std::atomic<bool> stopRequested = false;
+	Array<MouseButtonEvent> pendingEvents;
+	bool isPressed = false; // 最後に読み取ったボタンの状態
+
+	// メインスレッドだけが触る
+	Array<MouseButtonEvent> frameEvents; // 取り出したイベント（pendingEvents と入れ替えて使い回す）
+	double lastCollectSec = 0.0;
+	Optional<double> pressSec;           // まだ強調表示していないクリックを押した時刻
+	bool wasHighlighted = false;
+	Array<double> clickLatenciesMs;      // 直近 Config::ClickLatencyLogCapacity 件（いっぱいになったら古いものから上書き）
+	size_t nextClickLatency = 0;         // 次に上書きする位置
+	Array<double> clickLatencyScratch;   // 集計用の作業領域（使い回す）
+	bool running = false;
+};
+
+namespace InputSamplerUtils
+{
+	// 読み取りを開始（Windows 以外では何もせず false）
+	bool Start(InputSampler& sampler);
+
+	// 読み取りを停止
+	void Stop(InputSampler& sampler);
+
+	// 前回からのイベントを取り出して1フレーム分の入力にする（System::Update の直後に毎フレーム呼ぶ）
+	MouseButtonFrame Collect(InputSampler& sampler, double deltaTime);
+
+	// 描画を終えた時点で呼ぶ。描画した状態で球がドラッグ中になったら、押した瞬間からの遅延を記録する
+	void EndFrame(InputSampler& sampler, bool isHighlighted);
+
+	// 記録したクリックから強調表示までの遅延の集計（作業領域を使い回すので、表示するときだけ呼ぶ）
+	ClickLatencyStats GetClickLatencyStats(InputSampler& sampler);
+}
\ No newline at end of file
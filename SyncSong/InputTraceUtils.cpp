@@ -0,0 +1,498 @@
+#include "InputTraceUtils.hpp"
+#include "BoardSnapshot.hpp"
+
+namespace InputTraceUtils
+{
+	namespace
+	{
+		constexpr std::array<uint8, 4> Magic{ 'S', 'S', 'I', 'T' };
+		constexpr uint32 Version = 9;
+		constexpr uint32 Version1 = 1; // 音楽同期より前の形式（読み込みのみ）
+		constexpr uint32 Version2 = 2; // 初期配置の色より前の形式（読み込みのみ）
+		constexpr uint32 Version3 = 3; // 押した・離した瞬間の位置と時刻より前の形式（読み込みのみ）
+		constexpr uint32 Version4 = 4; // 範囲選択の修飾キーより前の形式（レコードは同じ大きさ、読み込みのみ）
+		constexpr uint32 Version5 = 5; // 元に戻す・やり直しより前の形式（レコードは同じ大きさ、読み込みのみ）
+		constexpr uint32 Version6 = 6; // 履歴の容量をヘッダに持つより前の形式（既定の容量で再生、読み込みのみ）
+		constexpr uint32 Version7 = 7; // 盤面をヘッダに埋め込むより前の形式（読み込みのみ）
+		constexpr uint32 Version8 = 8; // 押していた間のカーソルの移動量より前の形式（読み込みのみ）
+
+		constexpr uint8 FrameTag = 'F';
+		constexpr uint8 EndTag = 'E';
+
+		// 1フレームのレコード: float × 14（カーソル位置・移動量、経過時間、視点・注視点・上方向）+ フラグ + 音楽の再生位置の進み（double）
+		// + float × 6（押した・離した瞬間のカーソル位置と時刻）+ float × 2（押していた間のカーソルの移動量）
+		// 音楽の再生位置の進みは回転角に積み上がるので丸めずに記録する
+		constexpr size_t Version1FrameRecordSize = (sizeof(float) * 14 + 1);
+		constexpr size_t Version2FrameRecordSize = (Version1FrameRecordSize + sizeof(double));
+		constexpr size_t Version8FrameRecordSize = (Version2FrameRecordSize + sizeof(float) * 6);
+		constexpr size_t FrameRecordSize = (Version8FrameRecordSize + sizeof(float) * 2);
+
+		enum FrameFlags : uint8
+		{
+			MouseLDownFlag = (1 << 0),
+			MouseLPressedFlag = (1 << 1),
+			MouseLUpFlag = (1 << 2),
+			AutoRotationFlag = (1 << 3),
+			MusicSyncFlag = (1 << 4),
+			SelectModifierFlag = (1 << 5),
+			UndoFlag = (1 << 6),
+			RedoFlag = (1 << 7),
+		};
+
+		constexpr uint64 FNVOffsetBasis = 14695981039346656037ull;
+		constexpr uint64 FNVPrime = 1099511628211ull;
+
+		uint64 HashBytes(uint64 hash, const void* data, size_t size)
+		{
+			const uint8* bytes = static_cast<const uint8*>(data);
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash = ((hash ^ bytes[i]) * FNVPrime);
+			}
+			return hash;
+		}
+
+		template <class T>
+		uint64 HashArray(uint64 hash, const Array<T>& values)
+		{
+			return HashBytes(hash, values.data(), (values.size() * sizeof(T)));
+		}
+
+		template <class T>
+		void WriteValue(uint8*& p, const T& value)
+		{
+			std::memcpy(p, &value, sizeof(T));
+			p += sizeof(T);
+		}
+
+		template <class T>
+		T ReadValue(const uint8*& p)
+		{
+			T value;
+			std::memcpy(&value, p, sizeof(T));
+			p += sizeof(T);
+			return value;
+		}
+
+		// 記録と同じ float 精度に丸める（記録中のセッションと再生で同じ値をロジックに渡すため）
+		double Quantize(double value)
+		{
+			return static_cast<float>(value);
+		}
+
+		Vec2 Quantize(const Vec2& value)
+		{
+			return Vec2{ Float2{ value } };
+		}
+
+		Vec3 Quantize(const Vec3& value)
+		{
+			return Vec3{ Float3{ value } };
+		}
+	}
+
+	FrameInput CaptureFrameInput(const BasicCamera3D& camera, bool isAutoRotationEnabled, InputSampler& sampler)
+	{
+		FrameInput input;
+		input.cursorPos = Quantize(Cursor::PosF());
+		input.cursorDelta = Quantize(Cursor::DeltaF());
+		input.deltaTime = Quantize(Scene::DeltaTime());
+		input.eyePosition = Quantize(camera.getEyePosition());
+		input.focusPosition = Quantize(camera.getFocusPosition());
+		input.upDirection = Quantize(camera.getUpDirection());
+
+		const MouseButtonFrame button = InputSamplerUtils::Collect(sampler, input.deltaTime);
+		input.mouseLDown = button.down;
+		input.mouseLPressed = button.pressed;
+		input.mouseLUp = button.up;
+		input.mouseLDownPos = Quantize(button.downPos);
+		input.mouseLUpPos = Quantize(button.upPos);
+		input.mouseLDownTime = Min(Quantize(button.downTime), input.deltaTime);
+		input.mouseLUpTime = Min(Quantize(button.upTime), input.deltaTime);
+		input.isSelectModifierPressed = KeyShift.pressed();
+		input.isUndoRequested = (KeyControl.pressed() && KeyZ.down() && (not KeyShift.pressed()));
+		input.isRedoRequested = (KeyControl.pressed() && (KeyY.down() || (KeyZ.down() && KeyShift.pressed())));
+		input.isAutoRotationEnabled = isAutoRotationEnabled;
+		input.pressedCursorDelta = Quantize(GetPressedCursorDelta(input, (input.cursorPos - input.cursorDelta)));
+		return input;
+	}
+
+	void QuantizeFrameInput(FrameInput& input)
+	{
+		input.cursorPos = Quantize(input.cursorPos);
+		input.cursorDelta = Quantize(input.cursorDelta);
+		input.pressedCursorDelta = Quantize(input.pressedCursorDelta);
+		input.deltaTime = Quantize(input.deltaTime);
+		input.eyePosition = Quantize(input.eyePosition);
+		input.focusPosition = Quantize(input.focusPosition);
+		input.upDirection = Quantize(input.upDirection);
+		input.mouseLDownPos = Quantize(input.mouseLDownPos);
+		input.mouseLUpPos = Quantize(input.mouseLUpPos);
+		input.mouseLDownTime = Min(Quantize(input.mouseLDownTime), input.deltaTime);
+		input.mouseLUpTime = Min(Quantize(input.mouseLUpTime), input.deltaTime);
+	}
+
+	Vec2 GetPressedCursorDelta(const FrameInput& input, const Vec2& beginPos)
+	{
+		// 始まりに押していたか（離してから押し直した場合と、離しただけの場合）
+		const bool isReleasedFirst = (input.mouseLDown && input.mouseLUp && (input.mouseLUpTime < input.mouseLDownTime));
+		bool isPressed = (input.mouseLDown ? isReleasedFirst : (input.mouseLUp || input.mouseLPressed));
+
+		Vec2 pos = beginPos;
+		Vec2 delta{ 0, 0 };
+		const auto moveTo = [&](const Vec2& to, bool isPressedAfter)
+		{
+			if (isPressed)
+			{
+				delta += (to - pos);
+			}
+			pos = to;
+			isPressed = isPressedAfter;
+		};
+
+		if (isReleasedFirst)
+		{
+			moveTo(input.mouseLUpPos, false);
+			moveTo(input.mouseLDownPos, true);
+		}
+		else
+		{
+			if (input.mouseLDown)
+			{
+				moveTo(input.mouseLDownPos, true);
+			}
+
+			if (input.mouseLUp)
+			{
+				moveTo(input.mouseLUpPos, false);
+			}
+		}
+
+		moveTo(input.cursorPos, isPressed);
+		return delta;
+	}
+
+	InputTraceHeader MakeHeader(const BasicCamera3D& camera, const GameState& state, bool isBoardLoaded)
+	{
+		InputTraceHeader header{ camera.getSceneSize(), camera.getVerticalFOV(), camera.getNearClip(), GameLogic::GetSlotColors(state), state.history.byteBudget, {} };
+
+		// 取り外した球・回転角・球の並びは色だけでは再現できないので、盤面ごと記録する
+		if (isBoardLoaded)
+		{
+			BoardSnapshotUtils::Encode(state.spheres, state.rotationAngle, header.initialBoard);
+			BoardSnapshotUtils::Seal(header.initialBoard);
+		}
+		return header;
+	}
+
+	void ApplyCamera(BasicCamera3D& camera, const FrameInput& input)
+	{
+		camera.setView(input.eyePosition, input.focusPosition, input.upDirection);
+	}
+
+	bool BeginRecording(InputTraceRecorder& recorder, const FilePath& path, const InputTraceHeader& header)
+	{
+		recorder.writer = BinaryWriter{ path };
+		recorder.frameCount = 0;
+
+		if (not recorder.writer)
+		{
+			return false;
+		}
+
+		recorder.writer.write(Magic);
+		recorder.writer.write(Version);
+		recorder.writer.write(static_cast<int32>(header.sceneSize.x));
+		recorder.writer.write(static_cast<int32>(header.sceneSize.y));
+		recorder.writer.write(header.verticalFOV);
+		recorder.writer.write(header.nearClip);
+		recorder.writer.write(static_cast<uint32>(header.yellowSlotBits.size()));
+		recorder.writer.write(header.yellowSlotBits.data(), (header.yellowSlotBits.size() * sizeof(uint64)));
+		recorder.writer.write(header.editHistoryByteBudget);
+		recorder.writer.write(static_cast<uint64>(header.initialBoard.size()));
+		recorder.writer.write(header.initialBoard.data(), header.initialBoard.size());
+		return true;
+	}
+
+	void RecordFrame(InputTraceRecorder& recorder, const FrameInput& input)
+	{
+		if (not recorder.writer)
+		{
+			return;
+		}
+
+		std::array<uint8, (1 + FrameRecordSize)> record;
+		uint8* p = record.data();
+		WriteValue(p, FrameTag);
+		WriteValue(p, Float2{ input.cursorPos });
+		WriteValue(p, Float2{ input.cursorDelta });
+		WriteValue(p, static_cast<float>(input.deltaTime));
+		WriteValue(p, Float3{ input.eyePosition });
+		WriteValue(p, Float3{ input.focusPosition });
+		WriteValue(p, Float3{ input.upDirection });
+		WriteValue(p, static_cast<uint8>((input.mouseLDown ? MouseLDownFlag : 0)
+			| (input.mouseLPressed ? MouseLPressedFlag : 0)
+			| (input.mouseLUp ? MouseLUpFlag : 0)
+			| (input.isAutoRotationEnabled ? AutoRotationFlag : 0)
+			| (input.isMusicSyncEnabled ? MusicSyncFlag : 0)
+			| (input.isSelectModifierPressed ? SelectModifierFlag : 0)
+			| (input.isUndoRequested ? UndoFlag : 0)
+			| (input.isRedoRequested ? RedoFlag : 0)));
+		WriteValue(p, input.musicDeltaTime);
+		WriteValue(p, Float2{ input.mouseLDownPos });
+		WriteValue(p, Float2{ input.mouseLUpPos });
+		WriteValue(p, static_cast<float>(input.mouseLDownTime));
+		WriteValue(p, static_cast<float>(input.mouseLUpTime));
+		WriteValue(p, Float2{ input.pressedCursorDelta });
+
+		recorder.writer.write(record.data(), record.size());
+		++recorder.frameCount;
+	}
+
+	void EndRecording(InputTraceRecorder& recorder, uint64 finalStateHash)
+	{
+		if (not recorder.writer)
+		{
+			return;
+		}
+
+		recorder.writer.write(EndTag);
+		recorder.writer.write(recorder.frameCount);
+		recorder.writer.write(finalStateHash);
+		recorder.writer.close();
+	}
+
+	Optional<InputTrace> Load(const FilePath& path)
+	{
+		BinaryReader reader{ path };
+		if (not reader)
+		{
+			return none;
+		}
+
+		// ファイル全体を読み込んでからメモリ上で解析
+		Array<uint8> bytes(static_cast<size_t>(reader.size()));
+		if (reader.read(bytes.data(), bytes.size()) != static_cast<int64>(bytes.size()))
+		{
+			return none;
+		}
+
+		constexpr size_t HeaderSize = (sizeof(Magic) + sizeof(uint32) + sizeof(int32) * 2 + sizeof(double) * 2);
+		if (bytes.size() < HeaderSize)
+		{
+			return none;
+		}
+
+		const uint8* p = bytes.data();
+		const uint8* const end = (bytes.data() + bytes.size());
+
+		if (ReadValue<std::array<uint8, 4>>(p) != Magic)
+		{
+			return none;
+		}
+
+		const uint32 version = ReadValue<uint32>(p);
+		if ((version != Version) && (version != Version1) && (version != Version2) && (version != Version3) && (version != Version4) && (version != Version5)
+			&& (version != Version6) && (version != Version7) && (version != Version8))
+		{
+			return none;
+		}
+		const bool hasPressReleaseTimes = ((version == Version4) || (version == Version5) || (version == Version6) || (version == Version7) || (version == Version8)
+			|| (version == Version));
+		const size_t recordSize = ((version == Version1) ? Version1FrameRecordSize : (version == Version) ? FrameRecordSize
+			: hasPressReleaseTimes ? Version8FrameRecordSize : Version2FrameRecordSize);
+
+		InputTrace trace;
+		trace.header.sceneSize.x = ReadValue<int32>(p);
+		trace.header.sceneSize.y = ReadValue<int32>(p);
+		trace.header.verticalFOV = ReadValue<double>(p);
+		trace.header.nearClip = ReadValue<double>(p);
+
+		if ((version == Version3) || hasPressReleaseTimes)
+		{
+			if (static_cast<size_t>(end - p) < sizeof(uint32))
+			{
+				return none;
+			}
+
+			const size_t wordCount = ReadValue<uint32>(p);
+			if ((static_cast<size_t>(end - p) / sizeof(uint64)) < wordCount)
+			{
+				return none;
+			}
+
+			trace.header.yellowSlotBits.resize(wordCount);
+			std::memcpy(trace.header.yellowSlotBits.data(), p, (wordCount * sizeof(uint64)));
+			p += (wordCount * sizeof(uint64));
+		}
+
+		if ((version == Version7) || (version == Version8) || (version == Version))
+		{
+			if (static_cast<size_t>(end - p) < sizeof(uint64))
+			{
+				return none;
+			}
+
+			trace.header.editHistoryByteBudget = ReadValue<uint64>(p);
+		}
+
+		if ((version == Version8) || (version == Version))
+		{
+			if (static_cast<size_t>(end - p) < sizeof(uint64))
+			{
+				return none;
+			}
+
+			const uint64 boardSize = ReadValue<uint64>(p);
+			if (static_cast<uint64>(end - p) < boardSize)
+			{
+				return none;
+			}
+
+			trace.header.initialBoard.assign(p, (p + boardSize));
+			p += boardSize;
+
+			if (trace.header.initialBoard && (not BoardSnapshotUtils::MakeView(trace.header.initialBoard.data(), trace.header.initialBoard.size())))
+			{
+				return none;
+			}
+		}
+
+		trace.frames.reserve(static_cast<size_t>(end - p) / (1 + recordSize));
+
+		while (p < end)
+		{
+			const uint8 tag = ReadValue<uint8>(p);
+
+			if ((tag == FrameTag) && (recordSize <= static_cast<size_t>(end - p)))
+			{
+				FrameInput& input = trace.frames.emplace_back();
+				input.cursorPos = Vec2{ ReadValue<Float2>(p) };
+				input.cursorDelta = Vec2{ ReadValue<Float2>(p) };
+				input.deltaTime = ReadValue<float>(p);
+				input.eyePosition = Vec3{ ReadValue<Float3>(p) };
+				input.focusPosition = Vec3{ ReadValue<Float3>(p) };
+				input.upDirection = Vec3{ ReadValue<Float3>(p) };
+
+				const uint8 flags = ReadValue<uint8>(p);
+				input.mouseLDown = (flags & MouseLDownFlag);
+				input.mouseLPressed = (flags & MouseLPressedFlag);
+				input.mouseLUp = (flags & MouseLUpFlag);
+				input.isAutoRotationEnabled = (flags & AutoRotationFlag);
+				input.isMusicSyncEnabled = (flags & MusicSyncFlag);
+				input.isSelectModifierPressed = (flags & SelectModifierFlag);
+				input.isUndoRequested = (flags & UndoFlag);
+				input.isRedoRequested = (flags & RedoFlag);
+
+				if (version != Version1)
+				{
+					input.musicDeltaTime = ReadValue<double>(p);
+				}
+
+				if (hasPressReleaseTimes)
+				{
+					input.mouseLDownPos = Vec2{ ReadValue<Float2>(p) };
+					input.mouseLUpPos = Vec2{ ReadValue<Float2>(p) };
+					input.mouseLDownTime = ReadValue<float>(p);
+					input.mouseLUpTime = ReadValue<float>(p);
+				}
+				else
+				{
+					// 古い形式はフレームの終わりに押した・離したとみなす
+					input.mouseLDownPos = input.mouseLUpPos = input.cursorPos;
+					input.mouseLDownTime = input.mouseLUpTime = input.deltaTime;
+				}
+
+				if (version == Version)
+				{
+					input.pressedCursorDelta = Vec2{ ReadValue<Float2>(p) };
+				}
+				else
+				{
+					// 古い形式は押している間のフレームの移動量で回していた
+					input.pressedCursorDelta = (input.mouseLPressed ? input.cursorDelta : Vec2{ 0, 0 });
+				}
+			}
+			else if ((tag == EndTag) && ((sizeof(uint64) * 2) <= static_cast<size_t>(end - p)))
+			{
+				const uint64 frameCount = ReadValue<uint64>(p);
+				const uint64 finalStateHash = ReadValue<uint64>(p);
+
+				if (frameCount == trace.frames.size())
+				{
+					trace.finalStateHash = finalStateHash;
+				}
+				break;
+			}
+			else
+			{
+				// 途中で途切れたトレースは読めたフレームまでを使う
+				break;
+			}
+		}
+
+		return trace;
+	}
+
+	uint64 HashGameState(const GameState& state)
+	{
+		const SphereStore& spheres = state.spheres;
+
+		uint64 hash = FNVOffsetBasis;
+		hash = HashArray(hash, spheres.x);
+		hash = HashArray(hash, spheres.y);
+		hash = HashArray(hash, spheres.z);
+		hash = HashArray(hash, spheres.attachedBits);
+		hash = HashArray(hash, spheres.yellowBits);
+		hash = HashArray(hash, spheres.originalIndex);
+		hash = HashBytes(hash, &state.rotationAngle, sizeof(state.rotationAngle));
+
+		const uint8 isDragging = state.dragState.isDragging;
+		hash = HashBytes(hash, &isDragging, sizeof(isDragging));
+		hash = HashBytes(hash, &state.dragState.draggedSphere.slot, sizeof(uint32));
+		hash = HashBytes(hash, &state.dragState.draggedSphere.generation, sizeof(uint32));
+
+		// 範囲選択は使ったときだけ含める（範囲選択より前に記録したトレースのハッシュを変えない）
+		if (state.dragState.isSelecting || state.dragState.selectedSpheres)
+		{
+			const uint8 isSelecting = state.dragState.isSelecting;
+			hash = HashBytes(hash, &isSelecting, sizeof(isSelecting));
+			for (const SphereHandle& handle : state.dragState.selectedSpheres)
+			{
+				hash = HashBytes(hash, &handle.slot, sizeof(uint32));
+				hash = HashBytes(hash, &handle.generation, sizeof(uint32));
+			}
+		}
+		return hash;
+	}
+
+	InputTraceReplayResult Replay(const InputTrace& trace)
+	{
+		GameState state;
+		GameLogic::InitializeGameState(state);
+		if (trace.header.initialBoard)
+		{
+			// Load で形式は確かめてある。格子の設定が違えば初期配置のまま再生し、ハッシュの不一致で分かる
+			BoardSnapshotUtils::Restore(state, *BoardSnapshotUtils::MakeView(trace.header.initialBoard.data(), trace.header.initialBoard.size()));
+		}
+		else if (trace.header.yellowSlotBits)
+		{
+			GameLogic::ApplySlotColors(state, trace.header.yellowSlotBits);
+		}
+		EditHistoryUtils::SetByteBudget(state.history, static_cast<size_t>(trace.header.editHistoryByteBudget));
+
+		FrameArena arena{ Config::FrameArenaSize };
+		BasicCamera3D camera{ trace.header.sceneSize, trace.header.verticalFOV, Vec3{ 10, 0, 0 }, Vec3{ 0, 0, 0 }, Vec3{ 0, 1, 0 }, trace.header.nearClip };
+
+		const Stopwatch stopwatch{ StartImmediately::Yes };
+
+		for (const FrameInput& input : trace.frames)
+		{
+			arena.reset();
+			ApplyCamera(camera, input);
+			GameLogic::UpdateGameState(state, input, camera, arena);
+		}
+
+		return{ trace.frames.size(), HashGameState(state), stopwatch.sF() };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include <Siv3D.hpp>
+#include "GameTypes.hpp"
+#include "GameLogic.hpp"
+#include "InputSampler.hpp"
+
+// 入力トレースのヘッダ（ロジック用カメラの設定と初期配置の色）
+struct InputTraceHeader
+{
+	Size sceneSize{ 0, 0 };
+	double verticalFOV = 0.0;
+	double nearClip = 0.0;
+	Array<uint64> yellowSlotBits; // 記録開始時の格子スロットごとの色（GameLogic::GetSlotColors、空なら InitializeGameState のまま）
+	uint64 editHistoryByteBudget = Config::EditHistoryByteBudget; // 元に戻す・やり直しの履歴の容量（捨てるステップが変わると再生結果が変わる）
+	Array<uint8> initialBoard; // 記録開始時の盤面（BoardSnapshotUtils::Encode して Seal した内容、空なら yellowSlotBits の色の初期配置）
+};
+
+// 読み込んだ入力トレース
+struct InputTrace
+{
+	InputTraceHeader header;
+	Array<FrameInput> frames;
+	Optional<uint64> finalStateHash; // 記録終了時の状態のハッシュ（途中で終わったトレースには無い）
+};
+
+// 入力トレースの記録
+struct InputTraceRecorder
+{
+	BinaryWriter writer;
+	uint64 frameCount = 0;
+};
+
+// ヘッドレス再生の結果
+struct InputTraceReplayResult
+{
+	uint64 frameCount = 0;
+	uint64 finalStateHash = 0;
+	double elapsedSec = 0.0;
+};
+
+namespace InputTraceUtils
+{
+	// 現在のマウス・カメラの状態と sampler が集めた左ボタンのイベントから1フレーム分の入力を作る（記録と同じ精度に丸める）
+	FrameInput CaptureFrameInput(const BasicCamera3D& camera, bool isAutoRotationEnabled, InputSampler& sampler);
+
+	// 入力を記録と同じ精度に丸める（押した・離した時刻は deltaTime を超えないようにする）
+	void QuantizeFrameInput(FrameInput& input);
+
+	// 左ボタンを押していた間のカーソルの移動量（beginPos は入力の始まりのカーソル位置）
+	// 押した・離した瞬間の位置で区切るので、1回の押して離すまでの合計は離した位置 - 押した位置になる
+	Vec2 GetPressedCursorDelta(const FrameInput& input, const Vec2& beginPos);
+
+	// カメラの設定と記録開始時の状態（色と履歴の容量）からヘッダを作る
+	// 盤面スナップショットから始めた場合は isBoardLoaded を true にして、盤面をそのままヘッダに埋め込む
+	InputTraceHeader MakeHeader(const BasicCamera3D& camera, const GameState& state, bool isBoardLoaded);
+
+	// ロジック用カメラを入力の視点に合わせる
+	void ApplyCamera(BasicCamera3D& camera, const FrameInput& input);
+
+	// 記録を開始（ファイルを開けなければ false）
+	bool BeginRecording(InputTraceRecorder& recorder, const FilePath& path, const InputTraceHeader& header);
+
+	// 1フレーム分の入力を追記
+	void RecordFrame(InputTraceRecorder& recorder, const FrameInput& input);
+
+	// 最終状態のハッシュを書き込んで記録を終了
+	void EndRecording(InputTraceRecorder& recorder, uint64 finalStateHash);
+
+	// トレースを読み込む（形式が違えば none）
+	Optional<InputTrace> Load(const FilePath& path);
+
+	// ゲーム状態のハッシュ（FNV-1a、球の並び・位置・フラグと回転角、ドラッグ状態）
+	uint64 HashGameState(const GameState& state);
+
+	// 描画せずに最速で再生し、最終状態のハッシュを返す
+	InputTraceReplayResult Replay(const InputTrace& trace);
+}
\ No newline at end of file
@@ -4,73 +4,663 @@
 #include "RenderUtils.hpp"
 #include "GeometryUtils.hpp"
 #include "GameLogic.hpp"
+#include "FrameArena.hpp"
+#include "AllocationCounter.hpp"
+#include "InputTraceUtils.hpp"
+#include "BenchmarkUtils.hpp"
+#include "FrameProfiler.hpp"
+#include "FrameTracer.hpp"
+#include "SimulationPipeline.hpp"
+#include "DynamicResolution.hpp"
+#include "BoardSnapshot.hpp"
+#include "AudioClock.hpp"
+#include "BeatMap.hpp"
+#include "InputSampler.hpp"
+#include "FixedTimestep.hpp"
+#include "UndoSelfTest.hpp"
+
+namespace
+{
+	// コマンドライン引数 name の次の値を取得
+	Optional<String> GetCommandLineValue(const Array<String>& args, StringView name)
+	{
+		for (size_t i = 0; (i + 1) < args.size(); ++i)
+		{
+			if (args[i] == name)
+			{
+				return args[i + 1];
+			}
+		}
+		return none;
+	}
+
+	// --trace <first>:<count>: 記録するフレーム範囲を解析
+	Optional<std::pair<uint64, uint64>> ParseTraceFrames(const String& value)
+	{
+		const auto separator = value.indexOf(U':');
+		if (separator == String::npos)
+		{
+			return none;
+		}
+
+		const auto first = ParseOpt<uint64>(value.substr(0, separator));
+		const auto count = ParseOpt<uint64>(value.substr(separator + 1));
+		if ((not first) || (not count))
+		{
+			return none;
+		}
+
+		return std::pair{ *first, *count };
+	}
+
+	// --replay <path>: 入力トレースを描画せずに再生し、最終状態のハッシュを検証
+	void RunReplay(const FilePath& path)
+	{
+		Console.open();
+
+		const auto trace = InputTraceUtils::Load(path);
+		if (not trace)
+		{
+			Console << U"failed to load input trace: " << path;
+			return;
+		}
+
+		const InputTraceReplayResult result = InputTraceUtils::Replay(*trace);
+		Console << U"frames: {}, {:.3f} ms ({:.0f} frames/s)"_fmt(result.frameCount, (result.elapsedSec * 1000.0),
+			(result.frameCount / Max(result.elapsedSec, 1e-9)));
+		Console << U"final state hash: {:016X}"_fmt(result.finalStateHash);
+
+		if (trace->finalStateHash)
+		{
+			Console << ((*trace->finalStateHash == result.finalStateHash) ? U"hash: OK" : U"hash: MISMATCH (recorded {:016X})"_fmt(*trace->finalStateHash));
+		}
+		else
+		{
+			Console << U"hash: not recorded";
+		}
+	}
+
+	// --inspect-board <path>: 盤面スナップショットのヘッダを表示し、内容を検証
+	void RunInspectBoard(const FilePath& path)
+	{
+		Console.open();
+
+		BoardSnapshotFile snapshot;
+		if (not BoardSnapshotUtils::Open(snapshot, path))
+		{
+			Console << U"failed to open board snapshot (missing file or wrong format): " << path;
+			return;
+		}
+
+		const BoardSnapshotHeader& header = *snapshot.view.header;
+		Console << U"version: {}, file size: {} bytes"_fmt(header.version, header.fileSize);
+		Console << U"spheres: {}, rotation angle: {:.6f} rad"_fmt(header.sphereCount, header.rotationAngle);
+		Console << U"cylinder: radius {}, height {}, grid {}x{}, margin {}"_fmt(header.cylinderRadius, header.cylinderHeight,
+			header.gridUDiv, header.gridVDiv, header.gridMargin);
+		Console << U"sections: x @{}, y @{}, z @{}, attached @{}, yellow @{}, originalIndex @{}"_fmt(header.xOffset, header.yOffset,
+			header.zOffset, header.attachedBitsOffset, header.yellowBitsOffset, header.originalIndexOffset);
+
+		size_t attachedCount = 0;
+		size_t yellowCount = 0;
+		for (size_t i = 0; i < snapshot.view.attachedBits.size(); ++i)
+		{
+			attachedCount += std::popcount(snapshot.view.attachedBits[i]);
+			yellowCount += std::popcount(snapshot.view.attachedBits[i] & snapshot.view.yellowBits[i]);
+		}
+		Console << U"attached: {} (yellow {}), detached: {}"_fmt(attachedCount, yellowCount, (header.sphereCount - attachedCount));
+
+		const Array<String> problems = BoardSnapshotUtils::Validate(snapshot.view);
+		for (const String& problem : problems)
+		{
+			Console << U"error: " << problem;
+		}
+		Console << (problems.isEmpty() ? U"valid" : U"invalid");
+	}
+
+	// --analyze-beats <path>: 曲を解析してオンセットを表示し、拍のキャッシュに書き出す
+	void RunAnalyzeBeats(const FilePath& path)
+	{
+		Console.open();
+
+		const Stopwatch stopwatch{ StartImmediately::Yes };
+		const auto contentHash = BeatMapUtils::HashFile(path);
+		const double hashSec = stopwatch.sF();
+		const auto beatMap = (contentHash ? BeatMapUtils::Analyze(path, *contentHash) : none);
+		if (not beatMap)
+		{
+			Console << U"failed to decode audio: " << path;
+			return;
+		}
+
+		Console << U"content hash: {:016X} ({:.1f} ms)"_fmt(*contentHash, (hashSec * 1000.0));
+		Console << U"{:.1f} s at {} Hz, {} onsets, analyzed in {:.1f} ms"_fmt(beatMap->durationSec, beatMap->sampleRate,
+			beatMap->onsetTimes.size(), ((stopwatch.sF() - hashSec) * 1000.0));
+
+		for (size_t i = 0; i < Min<size_t>(beatMap->onsetTimes.size(), 16); ++i)
+		{
+			Console << U"onset {:.3f} s (strength {:.4f})"_fmt(beatMap->onsetTimes[i], beatMap->onsetStrengths[i]);
+		}
+
+		const FilePath cachePath = BeatMapUtils::GetCachePath(*contentHash);
+		Console << (BeatMapUtils::SaveCache(*beatMap) ? U"saved {}"_fmt(cachePath) : U"failed to write {}"_fmt(cachePath));
+	}
+
+	// 盤面スナップショットで state を置き換え、結果のメッセージを返す（読み込めなければ state はそのまま）
+	String LoadBoardSnapshot(GameState& state, const FilePath& path)
+	{
+		BoardSnapshotFile snapshot;
+		if (not BoardSnapshotUtils::Open(snapshot, path))
+		{
+			return U"failed to open board snapshot {}"_fmt(path);
+		}
+
+		if (not BoardSnapshotUtils::Restore(state, snapshot.view))
+		{
+			return U"board snapshot {} is corrupted or has a different grid"_fmt(path);
+		}
+
+		return U"loaded {} spheres from {}"_fmt(state.spheres.size(), path);
+	}
+
+	// 音楽同期を止め、記録した同期誤差を書き出して結果のメッセージを返す
+	String StopMusicSync(AudioClock& audioClock)
+	{
+		AudioClockUtils::Stop(audioClock);
+
+		return (AudioClockUtils::SaveCSV(Config::AudioSyncLogPath, audioClock)
+			? U"saved {} sync samples to {}"_fmt(audioClock.samples.size(), Config::AudioSyncLogPath) : U"failed to write {}"_fmt(Config::AudioSyncLogPath));
+	}
+
+	// --selftest-undo: 乱数のドラッグ&ドロップをすべて元に戻してやり直し、各ステップの状態が一致するか確かめる
+	// 既定の容量と、古いステップを捨てる小さな容量の両方で行う
+	void RunUndoSelfTest()
+	{
+		Console.open();
+
+		bool passed = true;
+		for (const size_t byteBudget : { Config::EditHistoryByteBudget, size_t{ 4 * 1024 } })
+		{
+			const UndoSelfTestResult result = UndoSelfTestUtils::Run(1000, byteBudget, 12345);
+			Console << U"budget {} B: {} steps ({} group, {} snapped), undone / redone: {} / {}, discarded: {}, mismatches: {}, pick index: {}"_fmt(
+				result.byteBudget, result.stepCount, result.groupStepCount, result.snapStepCount, result.undoneStepCount, result.redoneStepCount,
+				result.discardedStepCount, result.mismatchCount, (result.isPickIndexValid ? U"OK" : U"MISMATCH"));
+			passed = (passed && result.passed());
+		}
+
+		Console << (passed ? U"undo self-test: OK" : U"undo self-test: FAILED");
+	}
+
+	// --benchmark <path>: 合成盤面でマイクロベンチマークを実行し、結果を JSON Lines で書き出す
+	void RunBenchmark(const FilePath& path)
+	{
+		Console.open();
+
+		const Array<BenchmarkResult> results = BenchmarkUtils::RunAll();
+		for (const BenchmarkResult& result : results)
+		{
+			Console << BenchmarkUtils::ToJSONLine(result);
+		}
+
+		if (not BenchmarkUtils::Save(path, results))
+		{
+			Console << U"failed to write benchmark results: " << path;
+		}
+	}
+}
 
 void Main()
 {
-	// EBhE
+	const Array<String> args = System::GetCommandLineArgs();
+
+	if (const auto replayPath = GetCommandLineValue(args, U"--replay"))
+	{
+		RunReplay(*replayPath);
+		return;
+	}
+
+	if (const auto benchmarkPath = GetCommandLineValue(args, U"--benchmark"))
+	{
+		RunBenchmark(*benchmarkPath);
+		return;
+	}
+
+	if (args.includes(U"--selftest-undo"))
+	{
+		RunUndoSelfTest();
+		return;
+	}
+
+	if (const auto inspectPath = GetCommandLineValue(args, U"--inspect-board"))
+	{
+		RunInspectBoard(*inspectPath);
+		return;
+	}
+
+	if (const auto analyzePath = GetCommandLineValue(args, U"--analyze-beats"))
+	{
+		RunAnalyzeBeats(*analyzePath);
+		return;
+	}
+
+	// ウィンドウ初期化
 	Window::Resize(Config::WindowSize);
 	Scene::SetBackground(Config::BackgroundColor);
 
-	// _[eNX`
-	const MSRenderTexture renderTexture{
-		Scene::Size(),
-		TextureFormat::R8G8B8A8_Unorm_SRGB,
-		HasDepth::Yes
-	};
+	// --render-fps <fps>: 描画のフレームレートを垂直同期によらず決める（0 なら上限なし。ロジックのティックレートには影響しない）
+	if (const auto renderFPS = GetCommandLineValue(args, U"--render-fps"))
+	{
+		const double fps = ParseOpt<double>(*renderFPS).value_or(0.0);
+		Graphics::SetVSyncEnabled(false);
+		Graphics::SetTargetFrameRateHz((0.0 < fps) ? Optional<double>{ fps } : none);
+	}
 
-	// J
-	DebugCamera3D camera{ renderTexture.size(), 45_deg, Vec3{ 10, 0, 0 } };
+	// レンダーテクスチャ（--dynamic-resolution: 描画負荷に応じて縮小した描画先を使う、[R] で切り替え）
+	DynamicResolution dynamicResolution = DynamicResolutionUtils::Create(Scene::Size(), Config::MSAASampleCount);
+	DynamicResolutionUtils::SetEnabled(dynamicResolution, args.includes(U"--dynamic-resolution"));
 
-	// \[X
+	// カメラ（描画先を縮小しても縦横比は同じなので、シーンの大きさはウィンドウに合わせたまま）
+	DebugCamera3D camera{ Scene::Size(), 45_deg, Vec3{ 10, 0, 0 } };
+
+	// リソース生成
 	const Texture gradientTexture = RenderUtils::CreateGradientTexture(
 		Config::TopColor,
 		Config::BottomColor,
 		Config::GradientHeight
 	);
 	const Mesh cylinderMesh = RenderUtils::CreateCylinderMesh(
-		Config::CylinderRadius,
-		Config::CylinderHeight
-	);
-
-	// ̏ԂiׂĉFŎtꂽԁj
-	const Array<Vec3> gridPositions = GeometryUtils::GenerateCylinderGridPositions(
 		Config::CylinderRadius,
 		Config::CylinderHeight,
-		Config::GridUDiv,
-		Config::GridVDiv,
-		Config::GridMargin
+		Config::CylinderMeshQuality
 	);
 
-	Array<SphereState> spheres;
-	for (int32 i = 0; i < gridPositions.size(); ++i)
+	// 球のバッチ描画
+	SphereRenderer sphereRenderer = RenderUtils::CreateSphereRenderer();
+
+	// 球の状態を初期化（すべて黄色で取り付けられた状態）
+	GameState state;
+	GameLogic::InitializeGameState(state);
+
+	// --undo-budget <KiB>: 元に戻す・やり直しの履歴に使う容量（入力トレースのヘッダに記録し、再生でも同じ容量を使う）
+	if (const auto undoBudget = GetCommandLineValue(args, U"--undo-budget"))
 	{
-		spheres.emplace_back(gridPositions[i], true, true, i);
+		EditHistoryUtils::SetByteBudget(state.history, (ParseOpt<size_t>(*undoBudget).value_or(Config::EditHistoryByteBudget / 1024) * 1024));
 	}
 
-	double rotationAngle = 0.0;
 	bool isAutoRotationEnabled = false;
-	DragState dragState;
+	bool isProfilerOverlayEnabled = false;
+	String saveMessage; // 最後に書き出したファイルなどの結果（Config::SaveMessageDurationSec 秒の間かオーバーレイの表示中だけ表示）
+	Stopwatch saveMessageStopwatch;
+	const auto setSaveMessage = [&](String message)
+	{
+		saveMessage = std::move(message);
+		saveMessageStopwatch.restart();
+	};
+
+	// 音楽同期（--music <path> で曲を指定して開始、[M] で切り替え。--audio-latency <ms> で出力の遅延を指定）
+	AudioClock audioClock;
+	const FilePath musicPath = GetCommandLineValue(args, U"--music").value_or(Config::MusicPath);
+	double audioLatencySec = Config::AudioOutputLatencySec;
+	if (const auto latency = GetCommandLineValue(args, U"--audio-latency"))
+	{
+		audioLatencySec = (ParseOpt<double>(*latency).value_or(Config::AudioOutputLatencySec * 1000.0) / 1000.0);
+	}
+	if (GetCommandLineValue(args, U"--music") && (not AudioClockUtils::Start(audioClock, musicPath, audioLatencySec)))
+	{
+		setSaveMessage(U"failed to open {}"_fmt(musicPath));
+	}
+
+	// 曲のオンセットから灰色・黄色の初期配置を決める（--no-beatmap で無効）
+	// キャッシュが無ければ別スレッドで解析してキャッシュに書き出し、次の起動から使う
+	AsyncTask<Optional<BeatMap>> beatMapTask;
+	if (not args.includes(U"--no-beatmap"))
+	{
+		if (const auto beatMap = BeatMapUtils::LoadCache(musicPath))
+		{
+			GameLogic::ApplySlotColors(state, BeatMapUtils::MakeYellowSlotBits(*beatMap, Config::GridUDiv, Config::GridVDiv));
+		}
+		else
+		{
+			beatMapTask = Async([musicPath]()
+			{
+				return BeatMapUtils::AnalyzeAndCache(musicPath);
+			});
+		}
+	}
+
+	// --board <path>: 盤面スナップショットから始める（--record のトレースには読み込んだ盤面を埋め込む）
+	const auto boardPath = GetCommandLineValue(args, U"--board");
+	if (boardPath)
+	{
+		setSaveMessage(LoadBoardSnapshot(state, *boardPath));
+	}
+
+	// 盤面スナップショットの書き出し（バッファは使い回す。タスクが終わるまで触らない）
+	Array<uint8> boardSaveBuffer;
+	AsyncTask<bool> boardSaveTask;
+
+	// ロジック用カメラ（毎フレーム入力の視点に合わせる。再生時と同じ値でロジックを動かすため）
+	BasicCamera3D logicCamera{ camera.getSceneSize(), camera.getVerticalFOV(), camera.getEyePosition(),
+		camera.getFocusPosition(), camera.getUpDirection(), camera.getNearClip() };
 
-	// C[v
+	// --record <path>: 入力トレースを記録
+	InputTraceRecorder traceRecorder;
+	if (const auto recordPath = GetCommandLineValue(args, U"--record"))
+	{
+		InputTraceUtils::BeginRecording(traceRecorder, *recordPath, InputTraceUtils::MakeHeader(camera, state, boardPath.has_value()));
+	}
+
+	// --trace <first>:<count>: 指定したフレーム範囲の区間を記録（SYNCSONG_ENABLE_TRACING を定義したビルドのみ）
+	FrameTracer::SetCurrentThreadName(U"main");
+	if (const auto traceFrames = GetCommandLineValue(args, U"--trace"))
+	{
+		if (const auto range = ParseTraceFrames(*traceFrames))
+		{
+			FrameTracer::RequestCapture(range->first, range->second);
+		}
+	}
+
+	// フレームごとの一時データ
+	FrameArena frameArena{ Config::FrameArenaSize };
+
+	// マウスの左ボタンをフレームの間も読み取る（--no-input-sampler: フレームごとの入力だけを使う）
+	InputSampler inputSampler;
+	if (not args.includes(U"--no-input-sampler"))
+	{
+		InputSamplerUtils::Start(inputSampler);
+	}
+
+	// ロジックは固定間隔のティックで進め、描画は最後の2ティックの間を補間する（--tick-rate <hz> でティックレートを変更）
+	FixedTimestep timestep;
+	if (const auto tickRate = GetCommandLineValue(args, U"--tick-rate"))
+	{
+		FixedTimestepUtils::SetTickRate(timestep, ParseOpt<double>(*tickRate).value_or(Config::LogicTickRate));
+	}
+	Array<FrameInput> tickInputs; // このフレームで進めるティックの入力（使い回す）
+	TickInterpolation previousTick = FixedTimestepUtils::CaptureTickState(state); // 逐次実行で最後のティックを進める前の状態
+
+	// --pipeline: ロジックを別スレッドで進める（[L] で切り替え）
+	SimulationPipeline pipeline;
+	if (args.includes(U"--pipeline"))
+	{
+		SimulationPipelineUtils::Start(pipeline, state, logicCamera);
+	}
+
+	// メインループ
 	while (System::Update())
 	{
-		const Mat4x4 transform = Mat4x4::RotateZ(rotationAngle);
+		frameArena.reset();
+		AllocationCounter::BeginFrame();
+		FrameProfiler::BeginFrame();
+		FrameTracer::BeginFrame();
+
+		// ロジックの実行方式を切り替え（停止時は渡した入力をすべて処理してから戻る）
+		if (KeyL.down())
+		{
+			if (pipeline.running)
+			{
+				SimulationPipelineUtils::Stop(pipeline);
+				previousTick = FixedTimestepUtils::CaptureTickState(state);
+			}
+			else
+			{
+				SimulationPipelineUtils::Start(pipeline, state, logicCamera);
+			}
+		}
 
-		// JXVihbOłȂꍇ̂݁j
-		if (!dragState.isDragging)
+		// [F6] 盤面を読み込む（パイプライン実行中は止めてから状態を置き換える）
+		// 入力トレースは記録開始時の盤面から再生するので、記録中は読み込まない
+		if (KeyF6.down() && traceRecorder.writer)
 		{
+			setSaveMessage(U"cannot load a board while recording an input trace");
+		}
+		else if (KeyF6.down())
+		{
+			const bool wasRunning = pipeline.running;
+			if (wasRunning)
+			{
+				SimulationPipelineUtils::Stop(pipeline);
+			}
+
+			setSaveMessage(LoadBoardSnapshot(state, Config::BoardSnapshotPath));
+			previousTick = FixedTimestepUtils::CaptureTickState(state);
+
+			if (wasRunning)
+			{
+				SimulationPipelineUtils::Start(pipeline, state, logicCamera);
+			}
+		}
+
+		const Stopwatch mainStopwatch{ StartImmediately::Yes };
+
+		// パイプライン実行中は前のフレームまでの入力を反映した状態を描画する（反映されるまで待つので、入力から最大1フレーム遅れ）
+		const SceneSnapshot* snapshot = (pipeline.running ? &SimulationPipelineUtils::AcquireSnapshot(pipeline) : nullptr);
+		const SphereStore& sceneSpheres = (snapshot ? snapshot->spheres : state.spheres);
+		const DragState& sceneDragState = (snapshot ? snapshot->dragState : state.dragState);
+		const double sceneRotationAngle = (snapshot ? snapshot->rotationAngle : state.rotationAngle);
+
+		// [F5] 盤面を書き出す（描画する状態をバッファに複製し、ハッシュの計算とファイルへの書き込みは別スレッドで行う）
+		if (KeyF5.down() && (not boardSaveTask.isValid()))
+		{
+			BoardSnapshotUtils::Encode(sceneSpheres, sceneRotationAngle, boardSaveBuffer);
+			boardSaveTask = Async([&boardSaveBuffer]()
+			{
+				return BoardSnapshotUtils::Save(Config::BoardSnapshotPath, boardSaveBuffer);
+			});
+		}
+
+		if (boardSaveTask.isReady())
+		{
+			setSaveMessage(boardSaveTask.get() ? U"saved board to {}"_fmt(Config::BoardSnapshotPath) : U"failed to write {}"_fmt(Config::BoardSnapshotPath));
+		}
+
+		// 拍の解析が終わったら結果だけ知らせる（入力トレースの記録と食い違わないよう、配置には次の起動から使う）
+		if (beatMapTask.isReady())
+		{
+			const auto beatMap = beatMapTask.get();
+			setSaveMessage(beatMap ? U"analyzed {} onsets in {} (used from next launch)"_fmt(beatMap->onsetTimes.size(), musicPath)
+				: U"failed to analyze {}"_fmt(musicPath));
+		}
+
+		// カメラ更新（ドラッグ中・範囲選択中でない場合のみ）
+		if (not sceneDragState.isInteracting())
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::CameraUpdate };
+			SYNCSONG_TRACE_SCOPE("DebugCamera3D::update");
 			camera.update(2.0);
 		}
 
-		// ]
-		GameLogic::ProcessRotation(rotationAngle, isAutoRotationEnabled, dragState.isDragging);
+		// [M] 音楽同期を切り替え（止めたときに同期誤差を書き出す）
+		if (KeyM.down())
+		{
+			if (audioClock.running)
+			{
+				setSaveMessage(StopMusicSync(audioClock));
+			}
+			else if (not AudioClockUtils::Start(audioClock, musicPath, audioLatencySec))
+			{
+				setSaveMessage(U"failed to open {}"_fmt(musicPath));
+			}
+		}
+
+		// 入力を取得し、固定間隔のティックの入力に分ける（記録中はティックごとにトレースに追記）
+		FrameInput frameInput = InputTraceUtils::CaptureFrameInput(camera, isAutoRotationEnabled, inputSampler);
+		if (audioClock.running)
+		{
+			frameInput.isMusicSyncEnabled = true;
+			frameInput.musicDeltaTime = AudioClockUtils::Update(audioClock);
+		}
+		FixedTimestepUtils::Advance(timestep, frameInput, tickInputs);
+
+		for (const FrameInput& input : tickInputs)
+		{
+			InputTraceUtils::RecordFrame(traceRecorder, input);
+
+			if (pipeline.running)
+			{
+				// 次のフレームのロジックは描画と並行して進める
+				SimulationPipelineUtils::Submit(pipeline, input);
+			}
+			else
+			{
+				const AllocationCounter::ScopedSubsystem allocationScope{ AllocationCounter::Subsystem::Logic };
+
+				// 回転・ドラッグ&ドロップ処理
+				previousTick = FixedTimestepUtils::CaptureTickState(state);
+				InputTraceUtils::ApplyCamera(logicCamera, input);
+				GameLogic::UpdateGameState(state, input, logicCamera, frameArena);
+			}
+		}
+
+		// 描画は最後のティックから次のティックまでの経過の割合だけ補間する
+		TickInterpolation interpolation = (snapshot ? snapshot->previousTick : previousTick);
+		interpolation.alpha = FixedTimestepUtils::GetInterpolationAlpha(timestep);
+
+		// 球の描画方式を切り替え（比較用）
+		if (KeyB.down())
+		{
+			RenderUtils::SelectNextRenderMode(sphereRenderer);
+		}
+
+		// 球のカリングを切り替え（比較用）
+		if (KeyC.down())
+		{
+			sphereRenderer.cullingEnabled = not sphereRenderer.cullingEnabled;
+		}
+
+		// 動的解像度を切り替え
+		if (KeyR.down())
+		{
+			DynamicResolutionUtils::SetEnabled(dynamicResolution, not dynamicResolution.enabled);
+		}
+
+		// 描画
+		{
+			const AllocationCounter::ScopedSubsystem allocationScope{ AllocationCounter::Subsystem::Render };
+			{
+				const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::Render3DScene };
+				SYNCSONG_TRACE_SCOPE("Render3DScene");
+				RenderUtils::Render3DScene(DynamicResolutionUtils::GetRenderTarget(dynamicResolution), camera, cylinderMesh, gradientTexture, sceneSpheres, sceneRotationAngle, sceneDragState, interpolation, sphereRenderer);
+			}
+			RenderUtils::RenderToScreen(dynamicResolution);
+			RenderUtils::DrawSelectionRect(sceneDragState);
+		}
+
+		// クリックした球を強調表示した画面を描き終えるまでの遅延を記録
+		InputSamplerUtils::EndFrame(inputSampler, sceneDragState.isDragging);
+
+		// 描画方式・ロジックの実行方式ごとの時間は CSV の記録から集計する
+		FrameProfiler::AddCount(FrameProfiler::Counter::RenderMode, static_cast<uint64>(sphereRenderer.mode));
+		FrameProfiler::AddCount(FrameProfiler::Counter::LogicPipelined, (pipeline.running ? 1 : 0));
+		FrameProfiler::AddCount(FrameProfiler::Counter::MainThreadUs, static_cast<uint64>(mainStopwatch.sF() * 1e6));
 
-		// hbO&hbv
-		GameLogic::ProcessDragAndDrop(spheres, dragState, camera, transform, gridPositions);
+		// 次のフレームの描画先の倍率を選ぶ
+		DynamicResolutionUtils::Update(dynamicResolution, Scene::DeltaTime(), mainStopwatch.sF());
 
-		// `
-		RenderUtils::Render3DScene(renderTexture, camera, cylinderMesh, gradientTexture, spheres, rotationAngle, dragState);
-		RenderUtils::RenderToScreen(renderTexture);
+		// [P] 状態と処理段階ごとの時間の分布を表示、[F9] 記録を CSV に書き出す（表示しない間は文字列を作らない）
+		if (KeyP.down())
+		{
+			isProfilerOverlayEnabled = (not isProfilerOverlayEnabled);
+		}
+
+		ClearPrint();
+
+		if (isProfilerOverlayEnabled)
+		{
+			Print << U"[B] spheres: {}, [C] culling: {}, [R] dynamic resolution: {}, [L] logic: {}"_fmt(RenderUtils::GetRenderModeName(sphereRenderer.mode),
+				(sphereRenderer.cullingEnabled ? U"on" : U"off"), (dynamicResolution.enabled ? U"on" : U"off"), (pipeline.running ? U"pipeline" : U"serial"));
+
+			const EditHistoryStats historyStats = (snapshot ? snapshot->editHistory : EditHistoryUtils::GetStats(state.history));
+			Print << U"selected: {}, undo / redo: {} / {} steps, history: {} / {} B (discarded {} steps)"_fmt(sceneDragState.selectedSpheres.size(),
+				historyStats.undoStepCount, historyStats.redoStepCount, historyStats.usedBytes, historyStats.byteBudget, historyStats.discardedStepCount);
+
+			Print << U"resolution scale: {:.2f} ({}), frame {:.2f} ms, CPU {:.2f} ms, MSAA: {}x"_fmt(DynamicResolutionUtils::GetScale(dynamicResolution),
+				DynamicResolutionUtils::GetRenderTarget(dynamicResolution).size(), dynamicResolution.averageFrameMs, dynamicResolution.averageWorkMs, dynamicResolution.sampleCount);
+
+			Print << U"{:.0f} ticks/s, ticks this frame: {}, dropped: {}, logic lag: {} ticks"_fmt((1.0 / timestep.tickSec), timestep.lastFrameTickCount,
+				timestep.droppedTickCount, (snapshot ? (pipeline.submittedFrames - snapshot->logicFrame) : 0));
+
+			if (audioClock.running)
+			{
+				const AudioSyncStats syncStats = AudioClockUtils::GetSyncStats(audioClock);
+				Print << U"[M] music sync: {:.3f} s (latency {:.1f} ms), sync error mean / p99 / max: {:.3f} / {:.3f} / {:.3f} ms ({} reports)"_fmt(
+					audioClock.musicTime, (audioClock.latencySec * 1000.0), syncStats.meanAbsErrorMs, syncStats.p99AbsErrorMs, syncStats.maxAbsErrorMs, syncStats.sampleCount);
+			}
+
+			const ClickLatencyStats clickLatency = InputSamplerUtils::GetClickLatencyStats(inputSampler);
+			Print << U"input: {}, click to highlight p50 / p99 / max: {:.2f} / {:.2f} / {:.2f} ms ({} clicks)"_fmt((inputSampler.running ? U"sampled" : U"per frame"),
+				clickLatency.p50Ms, clickLatency.p99Ms, clickLatency.maxMs, clickLatency.sampleCount);
+
+			if (sphereRenderer.mode == SphereRenderMode::Batch)
+			{
+				const SphereLodStats& lodStats = sphereRenderer.lodStats;
+				Print << U"LOD spheres: {}, triangles: {} (full detail: {})"_fmt(lodStats.sphereCounts, lodStats.triangleCount, lodStats.fullDetailTriangleCount);
+			}
+
+			// 前フレームのヒープ確保（SYNCSONG_COUNT_ALLOCATIONS を定義したビルドのみ）
+			if constexpr (AllocationCounter::IsEnabled())
+			{
+				const auto logicStats = AllocationCounter::GetLastFrame(AllocationCounter::Subsystem::Logic);
+				const auto renderStats = AllocationCounter::GetLastFrame(AllocationCounter::Subsystem::Render);
+				const auto otherStats = AllocationCounter::GetLastFrame(AllocationCounter::Subsystem::Other);
+				Print << U"alloc/frame logic: {} ({} B), render: {} ({} B), other: {} ({} B)"_fmt(
+					logicStats.count, logicStats.bytes, renderStats.count, renderStats.bytes, otherStats.count, otherStats.bytes);
+				Print << U"allocating frames: {}, arena peak: {} / {} B"_fmt(
+					AllocationCounter::GetAllocatingFrameCount(), frameArena.highWaterMark, frameArena.capacity());
+			}
+		}
+
+		if (isProfilerOverlayEnabled || KeyF9.down())
+		{
+			const Array<FrameProfiler::FrameSample> samples = FrameProfiler::GetSamples();
+
+			if (KeyF9.down())
+			{
+				setSaveMessage(FrameProfiler::SaveCSV(Config::ProfilerCSVPath, samples)
+					? U"saved {} frames to {}"_fmt(samples.size(), Config::ProfilerCSVPath) : U"failed to write {}"_fmt(Config::ProfilerCSVPath));
+			}
+
+			if (isProfilerOverlayEnabled)
+			{
+				const auto frame = FrameProfiler::GetFramePercentiles(samples);
+				Print << U"frame p50/p95/p99: {:.2f} / {:.2f} / {:.2f} ms"_fmt(frame.p50, frame.p95, frame.p99);
+
+				for (size_t i = 0; i < FrameProfiler::PhaseCount; ++i)
+				{
+					const auto phase = static_cast<FrameProfiler::Phase>(i);
+					const auto percentiles = FrameProfiler::GetPhasePercentiles(samples, phase);
+					Print << U"{}: {:.3f} / {:.3f} / {:.3f} ms"_fmt(FrameProfiler::GetPhaseName(phase), percentiles.p50, percentiles.p95, percentiles.p99);
+				}
+
+				Print << U"ray tests: {}, spheres drawn: {}, culled (frustum / cylinder): {} / {}"_fmt(FrameProfiler::GetLastCount(samples, FrameProfiler::Counter::RayTests),
+					FrameProfiler::GetLastCount(samples, FrameProfiler::Counter::SpheresDrawn),
+					FrameProfiler::GetLastCount(samples, FrameProfiler::Counter::SpheresFrustumCulled),
+					FrameProfiler::GetLastCount(samples, FrameProfiler::Counter::SpheresOccluded));
+
+				RenderUtils::DrawFrameTimeHistogram(
+					FrameProfiler::GetFrameTimeHistogram(samples, Config::ProfilerHistogramBinCount, Config::ProfilerHistogramMaxMs),
+					RectF{ Vec2{ (Scene::Width() - 260), 20 }, Vec2{ 240, 80 } }, Config::ProfilerHistogramMaxMs);
+			}
+		}
+
+		// [T] 次のフレームから区間を記録し、終わったら JSON に書き出す
+		if constexpr (FrameTracer::IsEnabled())
+		{
+			if (KeyT.down())
+			{
+				FrameTracer::RequestCaptureNextFrames(Config::TraceFrameCount);
+			}
+
+			if (FrameTracer::IsCaptureFinished())
+			{
+				setSaveMessage(FrameTracer::SaveJSON(Config::TraceOutputPath)
+					? U"saved trace to {}"_fmt(Config::TraceOutputPath) : U"failed to write {}"_fmt(Config::TraceOutputPath));
+			}
+		}
+
+		if (saveMessage && (isProfilerOverlayEnabled || (saveMessageStopwatch.sF() < Config::SaveMessageDurationSec)))
+		{
+			Print << saveMessage;
+		}
 
 		// UI
 		if (SimpleGUI::Button(isAutoRotationEnabled ? U"ON" : U"OFF", Vec2{ Scene::Width() - 100, Scene::Height() - 40 }))
@@ -78,4 +668,13 @@ void Main()
 			isAutoRotationEnabled = (not isAutoRotationEnabled);
 		}
 	}
+
+	if (audioClock.running)
+	{
+		StopMusicSync(audioClock);
+	}
+
+	InputSamplerUtils::Stop(inputSampler);
+	SimulationPipelineUtils::Stop(pipeline);
+	InputTraceUtils::EndRecording(traceRecorder, InputTraceUtils::HashGameState(state));
 }
\ No newline at end of file
@@ -1,8 +1,224 @@
 #include "RenderUtils.hpp"
 #include "Config.hpp"
+#include "FrameProfiler.hpp"
+#include "FrameTracer.hpp"
+#include "GeometryUtils.hpp"
 
 namespace RenderUtils
 {
+	namespace
+	{
+		// 球の色（バッチ描画と個別描画で共通、sphere_batch シェーダのパレットと同じ並び）
+		const std::array<ColorF, 5> SpherePalette{
+			ColorF{ Palette::Gray },
+			ColorF{ Palette::Yellow },
+			ColorF{ Palette::Gray, 0.7 },      // ドラッグ中の球は少し透明にする
+			ColorF{ Palette::Yellow, 0.7 },
+			ColorF{ 0.0, 1.0, 0.5, 0.8 },      // スナップ候補の球は緑色でハイライト
+		};
+
+		// ドラッグ中の球の現在のインデックス（ドラッグしていなければ -1）
+		int32 GetDraggedIndex(const SphereStore& spheres, const DragState& dragState)
+		{
+			if (not dragState.isDragging)
+			{
+				return -1;
+			}
+
+			const auto index = spheres.indexOf(dragState.draggedSphere);
+			return (index ? static_cast<int32>(*index) : -1);
+		}
+
+		int32 GetSpherePaletteIndex(bool isYellow, int32 index, bool isMarked, const DragState& dragState)
+		{
+			if (dragState.isDragging && dragState.snapTracker.isHighlighted(index))
+			{
+				return 4;
+			}
+
+			// ドラッグ中の球と選択した球は少し透明にする
+			return ((isYellow ? 1 : 0) + (isMarked ? 2 : 0));
+		}
+
+		// 未使用スロット（頂点シェーダで点に潰れる）
+		constexpr SphereInstance UnusedSphereInstance{ Float3{ 0, 0, 0 }, Float2{ 0, -1 } };
+
+		// 描画する球の位置（動かしている球はティックの間を補間した位置）
+		Vec3 GetDrawPosition(const SphereStore& spheres, size_t index, const SphereDragHighlight& dragHighlight)
+		{
+			const Vec3 position = spheres.position(index);
+			return (dragHighlight.isMoving(index) ? (position + dragHighlight.dragOffset) : position);
+		}
+
+		SphereInstance MakeSphereInstance(const SphereStore& spheres, size_t index, const SphereDragHighlight& dragHighlight, const DragState& dragState)
+		{
+			const bool isMarked = ((static_cast<int32>(index) == dragHighlight.draggedIndex) || dragHighlight.isMarked(index));
+			const int32 paletteIndex = GetSpherePaletteIndex(spheres.isYellow(index), static_cast<int32>(index), isMarked, dragState);
+			return{ Float3{ GetDrawPosition(spheres, index, dragHighlight) }, Float2{ paletteIndex, (spheres.isAttached(index) ? 1 : 0) } };
+		}
+
+		// ドラッグ中の球と選択した球を求め、動かしている球のずれを補間する（前のティックでも同じ球をドラッグしていれば）
+		void UpdateDragHighlight(SphereDragHighlight& dragHighlight, const SphereStore& spheres, const DragState& dragState, const TickInterpolation& interpolation)
+		{
+			dragHighlight.markedBits.assign((spheres.size() + 63) / 64, 0);
+			for (const SphereHandle& handle : dragState.selectedSpheres)
+			{
+				if (const auto index = spheres.indexOf(handle))
+				{
+					dragHighlight.markedBits[*index / 64] |= (uint64{ 1 } << (*index % 64));
+				}
+			}
+
+			dragHighlight.draggedIndex = GetDraggedIndex(spheres, dragState);
+			dragHighlight.isGroupDragging = (dragState.isDragging && dragState.groupInitialPositions);
+			dragHighlight.dragOffset = Vec3{ 0, 0, 0 };
+
+			if ((0 <= dragHighlight.draggedIndex) && (interpolation.previousDraggedSphere == dragState.draggedSphere))
+			{
+				const Vec3 position = spheres.position(dragHighlight.draggedIndex);
+				dragHighlight.dragOffset = (interpolation.previousDraggedPosition.lerp(position, interpolation.alpha) - position);
+			}
+		}
+
+		// 取り付けられている球は円筒の回転を適用した位置
+		Vec3 GetRotatedPosition(const SphereStore& spheres, size_t index, double c, double s)
+		{
+			const Vec3 position = spheres.position(index);
+			if (not spheres.isAttached(index))
+			{
+				return position;
+			}
+			return Vec3{ (position.x * c - position.y * s), (position.x * s + position.y * c), position.z };
+		}
+
+		// 現在の LOD と画面上の半径から次の LOD を選ぶ（閾値の前後 SphereLodHysteresis の範囲では今の LOD を保つ）
+		uint8 SelectLod(uint8 currentLod, double radiusPixels)
+		{
+			constexpr auto& thresholds = Config::SphereLodMinRadiusPixels;
+			size_t lod = Min<size_t>(currentLod, thresholds.size());
+
+			// 細かくする
+			while ((0 < lod) && (thresholds[lod - 1] * (1.0 + Config::SphereLodHysteresis) <= radiusPixels))
+			{
+				--lod;
+			}
+
+			// 粗くする
+			while ((lod < thresholds.size()) && (radiusPixels < thresholds[lod] * (1.0 - Config::SphereLodHysteresis)))
+			{
+				++lod;
+			}
+
+			return static_cast<uint8>(lod);
+		}
+
+		// バッチにチャンクを1つ追加（すべて未使用）
+		void AddSphereChunk(SphereBatch& sphereBatch)
+		{
+			const size_t chunkSize = Config::SphereBatchChunkSize;
+			const Array<Vertex3D>& templateVertices = sphereBatch.sphereTemplate.vertices;
+			const Array<TriangleIndex32>& templateIndices = sphereBatch.sphereTemplate.indices;
+			const size_t vertexCount = templateVertices.size();
+
+			MeshData chunk;
+			chunk.vertices.resize(chunkSize * vertexCount);
+			chunk.indices.resize(chunkSize * templateIndices.size());
+
+			for (size_t k = 0; k < chunkSize; ++k)
+			{
+				for (size_t v = 0; v < vertexCount; ++v)
+				{
+					Vertex3D& vertex = chunk.vertices[k * vertexCount + v];
+					vertex.pos = UnusedSphereInstance.position;
+					vertex.normal = templateVertices[v].normal;
+					vertex.tex = UnusedSphereInstance.attribute;
+				}
+
+				const uint32 baseVertex = static_cast<uint32>(k * vertexCount);
+				for (size_t t = 0; t < templateIndices.size(); ++t)
+				{
+					const TriangleIndex32& index = templateIndices[t];
+					chunk.indices[k * templateIndices.size() + t] = { index.i0 + baseVertex, index.i1 + baseVertex, index.i2 + baseVertex };
+				}
+			}
+
+			sphereBatch.chunkMeshes.emplace_back(chunk);
+			sphereBatch.chunkData.push_back(std::move(chunk));
+			sphereBatch.dirtyChunks.push_back(false);
+			sphereBatch.instances.resize(sphereBatch.chunkMeshes.size() * chunkSize, UnusedSphereInstance);
+		}
+
+		// バッチ内の位置 instanceSlot の属性を書き換える（前回と同じなら何もしない）
+		void WriteSphereInstance(SphereBatch& sphereBatch, size_t instanceSlot, const SphereInstance& instance)
+		{
+			if (instance == sphereBatch.instances[instanceSlot])
+			{
+				return;
+			}
+
+			sphereBatch.instances[instanceSlot] = instance;
+
+			const size_t chunkSize = Config::SphereBatchChunkSize;
+			const size_t vertexCount = sphereBatch.sphereTemplate.vertices.size();
+			const size_t chunkIndex = (instanceSlot / chunkSize);
+			Vertex3D* vertices = &sphereBatch.chunkData[chunkIndex].vertices[(instanceSlot % chunkSize) * vertexCount];
+			for (size_t v = 0; v < vertexCount; ++v)
+			{
+				vertices[v].pos = instance.position;
+				vertices[v].tex = instance.attribute;
+			}
+			sphereBatch.dirtyChunks[chunkIndex] = true;
+		}
+
+		// count 個の球の属性をバッチに反映（getInstanceSlot(i) で i 番目の球のバッチ内の位置、getInstance(i) で属性を得る）
+		// 書き込まなかった位置は未使用にし、変化したチャンクだけを再アップロード
+		template <class GetInstanceSlot, class GetInstance>
+		void UpdateSphereChunks(SphereBatch& sphereBatch, size_t count, GetInstanceSlot getInstanceSlot, GetInstance getInstance)
+		{
+			const size_t chunkSize = Config::SphereBatchChunkSize;
+
+			// 書き込む位置に対してチャンクが足りなければ追加
+			size_t requiredSlotCount = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				requiredSlotCount = Max<size_t>(requiredSlotCount, (getInstanceSlot(i) + 1));
+			}
+			while (sphereBatch.instances.size() < requiredSlotCount)
+			{
+				AddSphereChunk(sphereBatch);
+			}
+
+			sphereBatch.drawnInstanceBits.assign(((sphereBatch.instances.size() + 63) / 64), 0);
+			sphereBatch.chunkUseCounts.assign(sphereBatch.chunkMeshes.size(), 0);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint32 instanceSlot = getInstanceSlot(i);
+				sphereBatch.drawnInstanceBits[instanceSlot / 64] |= (uint64{ 1 } << (instanceSlot % 64));
+				++sphereBatch.chunkUseCounts[instanceSlot / chunkSize];
+				WriteSphereInstance(sphereBatch, instanceSlot, getInstance(i));
+			}
+
+			// 前回描画して今回描画しない位置を未使用にする
+			for (size_t instanceSlot = 0; instanceSlot < sphereBatch.instances.size(); ++instanceSlot)
+			{
+				if (not ((sphereBatch.drawnInstanceBits[instanceSlot / 64] >> (instanceSlot % 64)) & 1))
+				{
+					WriteSphereInstance(sphereBatch, instanceSlot, UnusedSphereInstance);
+				}
+			}
+
+			for (size_t chunkIndex = 0; chunkIndex < sphereBatch.chunkMeshes.size(); ++chunkIndex)
+			{
+				if (sphereBatch.dirtyChunks[chunkIndex])
+				{
+					sphereBatch.chunkMeshes[chunkIndex].fill(sphereBatch.chunkData[chunkIndex]);
+					sphereBatch.dirtyChunks[chunkIndex] = false;
+				}
+			}
+		}
+	}
+
 	Texture CreateGradientTexture(const ColorF& topColor, const ColorF& bottomColor, int32 height)
 	{
 		Image gradientImage{ 1, static_cast<size_t>(height) };
@@ -29,65 +245,385 @@ namespace RenderUtils
 		Graphics3D::SetSunDirection(Vec3{ -1, -1, 0.5 }.normalized());
 	}
 
+	SphereBatch CreateSphereBatch(uint32 quality)
+	{
+		SphereBatch sphereBatch;
+		sphereBatch.vertexShader = HLSL{ U"example/shader/hlsl/sphere_batch.hlsl", U"VS" }
+			| GLSL{ U"example/shader/glsl/sphere_batch.vert", { { U"VSPerView", 1 }, { U"VSSphereBatch", 4 } } };
+		sphereBatch.pixelShader = HLSL{ U"example/shader/hlsl/sphere_batch.hlsl", U"PS" }
+			| GLSL{ U"example/shader/glsl/sphere_batch.frag", { { U"PSPerFrame", 0 }, { U"PSPerView", 1 }, { U"PSPerMaterial", 3 } } };
+
+		// シェーダが使えない場合は個別描画にフォールバック
+		sphereBatch.available = (sphereBatch.vertexShader && sphereBatch.pixelShader);
+
+		// 半径1の球。頂点の法線を球の中心からのオフセット方向として使う
+		sphereBatch.sphereTemplate = MeshData::Sphere(1.0, quality);
+		return sphereBatch;
+	}
+
+	SphereBatch CreateSphereImpostorBatch()
+	{
+		SphereBatch sphereBatch;
+		sphereBatch.vertexShader = HLSL{ U"example/shader/hlsl/sphere_impostor.hlsl", U"VS" }
+			| GLSL{ U"example/shader/glsl/sphere_impostor.vert", { { U"VSPerView", 1 }, { U"VSSphereBatch", 4 } } };
+		sphereBatch.pixelShader = HLSL{ U"example/shader/hlsl/sphere_impostor.hlsl", U"PS" }
+			| GLSL{ U"example/shader/glsl/sphere_impostor.frag", { { U"PSPerFrame", 0 }, { U"PSPerView", 1 }, { U"PSPerMaterial", 3 }, { U"PSSphereImpostor", 4 } } };
+
+		sphereBatch.available = (sphereBatch.vertexShader && sphereBatch.pixelShader);
+		sphereBatch.isImpostor = true;
+
+		// 四角形の4隅。頂点の法線の xy を視点を向く面内でのオフセット方向として使う
+		sphereBatch.sphereTemplate.vertices = {
+			Vertex3D{ Float3{ 0, 0, 0 }, Float3{ -1, -1, 0 }, Float2{ 0, 0 } },
+			Vertex3D{ Float3{ 0, 0, 0 }, Float3{ 1, -1, 0 }, Float2{ 0, 0 } },
+			Vertex3D{ Float3{ 0, 0, 0 }, Float3{ 1, 1, 0 }, Float2{ 0, 0 } },
+			Vertex3D{ Float3{ 0, 0, 0 }, Float3{ -1, 1, 0 }, Float2{ 0, 0 } },
+		};
+		sphereBatch.sphereTemplate.indices = { TriangleIndex32{ 0, 2, 1 }, TriangleIndex32{ 0, 3, 2 } };
+		return sphereBatch;
+	}
+
+	SphereRenderer CreateSphereRenderer()
+	{
+		SphereRenderer sphereRenderer;
+		for (const uint32 quality : Config::SphereLodQualities)
+		{
+			sphereRenderer.meshBatches.push_back(CreateSphereBatch(quality));
+		}
+		sphereRenderer.impostorBatch = CreateSphereImpostorBatch();
+		sphereRenderer.lodInstances.resize(Config::SphereLodQualities.size());
+
+		sphereRenderer.mode = (IsAvailable(sphereRenderer, SphereRenderMode::Batch) ? SphereRenderMode::Batch : SphereRenderMode::Immediate);
+		return sphereRenderer;
+	}
+
+	bool IsAvailable(const SphereRenderer& sphereRenderer, SphereRenderMode mode)
+	{
+		switch (mode)
+		{
+		case SphereRenderMode::Batch:
+			return sphereRenderer.meshBatches.all([](const SphereBatch& sphereBatch) { return sphereBatch.available; });
+		case SphereRenderMode::Impostor:
+			return sphereRenderer.impostorBatch.available;
+		default:
+			return true;
+		}
+	}
+
+	void SelectNextRenderMode(SphereRenderer& sphereRenderer)
+	{
+		constexpr size_t ModeCount = static_cast<size_t>(SphereRenderMode::Count);
+
+		for (size_t i = 1; i < ModeCount; ++i)
+		{
+			const auto mode = static_cast<SphereRenderMode>((static_cast<size_t>(sphereRenderer.mode) + i) % ModeCount);
+			if (IsAvailable(sphereRenderer, mode))
+			{
+				sphereRenderer.mode = mode;
+				return;
+			}
+		}
+	}
+
+	StringView GetRenderModeName(SphereRenderMode mode)
+	{
+		switch (mode)
+		{
+		case SphereRenderMode::Batch:
+			return U"batch";
+		case SphereRenderMode::Impostor:
+			return U"impostor";
+		default:
+			return U"immediate";
+		}
+	}
+
+	void CullSpheres(SphereCullResult& cullResult, const SphereStore& spheres, double rotationAngle, const BasicCamera3D& camera, bool enabled)
+	{
+		cullResult.visibleIndices.clear();
+		cullResult.frustumCulledCount = 0;
+		cullResult.occludedCount = 0;
+
+		if (not enabled)
+		{
+			for (size_t i = 0; i < spheres.size(); ++i)
+			{
+				cullResult.visibleIndices.push_back(static_cast<uint32>(i));
+			}
+			return;
+		}
+
+		const std::array<Vec4, 5> frustumPlanes = GeometryUtils::GetFrustumPlanes(camera);
+		const Vec3 eyePosition = camera.getEyePosition();
+		const double c = Math::Cos(rotationAngle);
+		const double s = Math::Sin(rotationAngle);
+
+		// 円筒のメッシュは多角形なので、内接円を遮蔽物とする
+		const double occluderRadius = (Config::CylinderRadius * Math::Cos(Math::Pi / Config::CylinderMeshQuality));
+
+		for (size_t i = 0; i < spheres.size(); ++i)
+		{
+			const Vec3 center = GetRotatedPosition(spheres, i, c, s);
+
+			if (GeometryUtils::IsSphereOutsideFrustum(frustumPlanes, center, Config::SphereRadius))
+			{
+				++cullResult.frustumCulledCount;
+				continue;
+			}
+
+			if (spheres.isAttached(i)
+				&& GeometryUtils::IsSphereOccludedByCylinder(eyePosition, center, Config::SphereRadius, occluderRadius, Config::CylinderHeight))
+			{
+				++cullResult.occludedCount;
+				continue;
+			}
+
+			cullResult.visibleIndices.push_back(static_cast<uint32>(i));
+		}
+	}
+
+	void UpdateSphereInstanceLayout(SphereInstanceLayout& layout, const SphereStore& spheres)
+	{
+		if ((layout.denseToSlot == spheres.denseToSlot) && (layout.attachedBits == spheres.attachedBits))
+		{
+			return;
+		}
+
+		layout.denseToSlot = spheres.denseToSlot;
+		layout.attachedBits = spheres.attachedBits;
+
+		// 取り付けられた球は角度の区切り、取り外された球は最後の区切りに入れ、区切りの中はインデックス順に並べる
+		constexpr int32 BucketCount = Config::SphereBatchAngleBuckets;
+		const auto getBucket = [&](size_t index)
+		{
+			if (not spheres.isAttached(index))
+			{
+				return BucketCount;
+			}
+
+			const Vec3 position = spheres.position(index);
+			const double t = ((Math::Atan2(position.y, position.x) + Math::Pi) / Math::TwoPi);
+			return Clamp(static_cast<int32>(t * BucketCount), 0, (BucketCount - 1));
+		};
+
+		layout.bucketOffsets.assign((BucketCount + 2), 0);
+		for (size_t i = 0; i < spheres.size(); ++i)
+		{
+			++layout.bucketOffsets[getBucket(i) + 2];
+		}
+		for (size_t bucket = 2; bucket < layout.bucketOffsets.size(); ++bucket)
+		{
+			layout.bucketOffsets[bucket] += layout.bucketOffsets[bucket - 1];
+		}
+
+		layout.instanceSlots.resize(spheres.size());
+		for (size_t i = 0; i < spheres.size(); ++i)
+		{
+			layout.instanceSlots[i] = layout.bucketOffsets[getBucket(i) + 1]++;
+		}
+	}
+
+	void UpdateSphereBatch(SphereBatch& sphereBatch, const SphereStore& spheres, const Array<uint32>& visibleIndices, const SphereInstanceLayout& layout,
+		const DragState& dragState, const SphereDragHighlight& dragHighlight)
+	{
+		UpdateSphereChunks(sphereBatch, visibleIndices.size(),
+			[&](size_t i) { return layout.instanceSlots[visibleIndices[i]]; },
+			[&](size_t i) { return MakeSphereInstance(spheres, visibleIndices[i], dragHighlight, dragState); });
+	}
+
+	void UpdateSphereLods(SphereRenderer& sphereRenderer, const SphereStore& spheres, const Array<uint32>& visibleIndices,
+		const DragState& dragState, const SphereDragHighlight& dragHighlight, double rotationAngle, const BasicCamera3D& camera)
+	{
+		// 球の中心までの距離 d で画面上の半径は SphereRadius * focalPixels / d
+		const double focalPixels = (camera.getSceneSize().y * 0.5 / Math::Tan(camera.getVerticalFOV() * 0.5));
+		const Vec3 eyePosition = camera.getEyePosition();
+		const double c = Math::Cos(rotationAngle);
+		const double s = Math::Sin(rotationAngle);
+
+		if (sphereRenderer.slotLods.size() < spheres.slotGenerations.size())
+		{
+			sphereRenderer.slotLods.resize(spheres.slotGenerations.size(), 0);
+		}
+
+		for (Array<SphereDrawItem>& instances : sphereRenderer.lodInstances)
+		{
+			instances.clear();
+		}
+
+		SphereLodStats& stats = sphereRenderer.lodStats;
+		stats = SphereLodStats{};
+
+		for (const uint32 i : visibleIndices)
+		{
+			// 取り付けられている球は円筒の回転を適用した位置で測る
+			const Vec3 center = GetRotatedPosition(spheres, i, c, s);
+
+			const double distance = Max(center.distanceFrom(eyePosition), Config::SphereRadius);
+			const double radiusPixels = (Config::SphereRadius * focalPixels / distance);
+
+			uint8& lod = sphereRenderer.slotLods[spheres.denseToSlot[i]];
+			lod = SelectLod(lod, radiusPixels);
+
+			sphereRenderer.lodInstances[lod].push_back({ sphereRenderer.instanceLayout.instanceSlots[i], MakeSphereInstance(spheres, i, dragHighlight, dragState) });
+		}
+
+		for (size_t lod = 0; lod < sphereRenderer.lodInstances.size(); ++lod)
+		{
+			const size_t count = sphereRenderer.lodInstances[lod].size();
+			stats.sphereCounts[lod] = count;
+			stats.triangleCount += (count * sphereRenderer.meshBatches[lod].sphereTemplate.indices.size());
+			stats.fullDetailTriangleCount += (count * sphereRenderer.meshBatches[0].sphereTemplate.indices.size());
+		}
+	}
+
+	void DrawSphereBatch(SphereBatch& sphereBatch, double rotationAngle, const BasicCamera3D& camera)
+	{
+		sphereBatch.constants->rotation = Float4{ Math::Cos(rotationAngle), Math::Sin(rotationAngle), Config::SphereRadius, 0.0 };
+		for (size_t i = 0; i < SpherePalette.size(); ++i)
+		{
+			sphereBatch.constants->palette[i] = SpherePalette[i].toFloat4();
+		}
+		sphereBatch.constants->eyePosition = Float4{ camera.getEyePosition(), 0.0f };
+
+		Graphics3D::SetVSConstantBuffer(4, sphereBatch.constants);
+
+		if (sphereBatch.isImpostor)
+		{
+			sphereBatch.impostorConstants->worldToProjected = camera.getViewProj();
+			sphereBatch.impostorConstants->radius = Float4{ Config::SphereRadius, 0.0, 0.0, 0.0 };
+			Graphics3D::SetPSConstantBuffer(4, sphereBatch.impostorConstants);
+		}
+
+		const ScopedCustomShader3D shader{ sphereBatch.vertexShader, sphereBatch.pixelShader };
+
+		// 描画する球を含むチャンクだけを描画
+		for (size_t chunkIndex = 0; chunkIndex < sphereBatch.chunkMeshes.size(); ++chunkIndex)
+		{
+			if (sphereBatch.chunkUseCounts[chunkIndex])
+			{
+				sphereBatch.chunkMeshes[chunkIndex].draw();
+			}
+		}
+	}
+
 	void Render3DScene(
-		const MSRenderTexture& renderTexture,
+		const RenderTexture& renderTexture,
 		DebugCamera3D& camera,
 		const Mesh& cylinderMesh,
 		const Texture& gradientTexture,
-		const Array<SphereState>& spheres,
-		double rotationAngle,
-		const DragState& dragState)
+		const SphereStore& spheres,
+		double tickRotationAngle,
+		const DragState& dragState,
+		const TickInterpolation& interpolation,
+		SphereRenderer& sphereRenderer)
 	{
 		const ScopedRenderTarget3D target{ renderTexture.clear(Scene::GetBackground()) };
 		Graphics3D::SetCameraTransform(camera);
 		Setup3DScene();
 
+		// ロジックの最後の2ティックの間を補間して描画（描画のフレームレートがティックレートと違っても滑らかに動く）
+		const double rotationAngle = Math::Lerp(interpolation.previousRotationAngle, tickRotationAngle, interpolation.alpha);
+		SphereDragHighlight& dragHighlight = sphereRenderer.dragHighlight;
+		UpdateDragHighlight(dragHighlight, spheres, dragState, interpolation);
+
 		const auto transform = Mat4x4::RotateZ(rotationAngle);
 		cylinderMesh.draw(transform, gradientTexture);
 
-		// `
-		for (int32 i = 0; i < spheres.size(); ++i)
-		{
-			const auto& sphere = spheres[i];
-			ColorF color = sphere.isYellow ? Palette::Yellow : Palette::Gray;
+		// 見えない球を除いてから描画
+		const SphereCullResult& cullResult = sphereRenderer.cullResult;
+		CullSpheres(sphereRenderer.cullResult, spheres, rotationAngle, camera, sphereRenderer.cullingEnabled);
+		FrameProfiler::AddCount(FrameProfiler::Counter::SpheresDrawn, cullResult.visibleIndices.size());
+		FrameProfiler::AddCount(FrameProfiler::Counter::SpheresFrustumCulled, cullResult.frustumCulledCount);
+		FrameProfiler::AddCount(FrameProfiler::Counter::SpheresOccluded, cullResult.occludedCount);
+		UpdateSphereInstanceLayout(sphereRenderer.instanceLayout, spheres);
 
-			// hbŐ͏ɂ
-			if (dragState.isDragging && dragState.draggedSphereIndex == i)
+		if ((sphereRenderer.mode == SphereRenderMode::Batch) && IsAvailable(sphereRenderer, SphereRenderMode::Batch))
+		{
+			// LOD ごとにまとめて描画
+			UpdateSphereLods(sphereRenderer, spheres, cullResult.visibleIndices, dragState, dragHighlight, rotationAngle, camera);
+			for (size_t lod = 0; lod < sphereRenderer.meshBatches.size(); ++lod)
 			{
-				color.a = 0.7;
+				const Array<SphereDrawItem>& items = sphereRenderer.lodInstances[lod];
+				UpdateSphereChunks(sphereRenderer.meshBatches[lod], items.size(),
+					[&](size_t i) { return items[i].instanceSlot; }, [&](size_t i) { return items[i].instance; });
+				DrawSphereBatch(sphereRenderer.meshBatches[lod], rotationAngle, camera);
 			}
-
-			 // Xibv̋nCCg\
-			if (dragState.isDragging && dragState.snapCandidates.contains(i))
+		}
+		else if ((sphereRenderer.mode == SphereRenderMode::Impostor) && IsAvailable(sphereRenderer, SphereRenderMode::Impostor))
+		{
+			UpdateSphereBatch(sphereRenderer.impostorBatch, spheres, cullResult.visibleIndices, sphereRenderer.instanceLayout, dragState, dragHighlight);
+			DrawSphereBatch(sphereRenderer.impostorBatch, rotationAngle, camera);
+		}
+		else
+		{
+			for (const uint32 index : cullResult.visibleIndices)
 			{
-				color = ColorF{ 0.0, 1.0, 0.5, 0.8 }; // ΐFŃnCCg
-			}
+				const int32 i = static_cast<int32>(index);
+				const Vec3 position = GetDrawPosition(spheres, i, dragHighlight);
+				const bool isMarked = ((i == dragHighlight.draggedIndex) || dragHighlight.isMarked(i));
+				const ColorF& color = SpherePalette[GetSpherePaletteIndex(spheres.isYellow(i), i, isMarked, dragState)];
 
-			// tĂ鋅͉]ϊKpAOꂽ͂̂܂ܕ`
-			if (sphere.isAttached)
-			{
-				Sphere{ sphere.position, Config::SphereRadius }.draw(transform, color);
-			}
-			else
-			{
-				// Oꂽ͉]ϊKpȂ
-				Sphere{ sphere.position, Config::SphereRadius }.draw(color);
+				// 取り付けられている球は回転変換を適用、取り外された球はそのまま描画
+				if (spheres.isAttached(i))
+				{
+					Sphere{ position, Config::SphereRadius }.draw(transform, color);
+				}
+				else
+				{
+					// 取り外された球は回転変換を適用しない
+					Sphere{ position, Config::SphereRadius }.draw(color);
+				}
 			}
 		}
 
-		// fobOpFhbO̓vC[ƃhbOԐ`
-		if (dragState.isDragging && dragState.draggedSphereIndex >= 0)
+		// デバッグ用：ドラッグ中はプレイヤーとドラッグ球を結ぶ線を描画
+		if (dragHighlight.draggedIndex >= 0)
 		{
 			const Vec3 playerPos = camera.getEyePosition();
-			const Vec3 draggedPos = spheres[dragState.draggedSphereIndex].position;
-			Line3D{ playerPos, draggedPos }.draw(ColorF{ 1.0, 0.0, 0.0, 0.5 });
+			Line3D{ playerPos, GetDrawPosition(spheres, dragHighlight.draggedIndex, dragHighlight) }.draw(ColorF{ 1.0, 0.0, 0.0, 0.5 });
 		}
 	}
 
-	void RenderToScreen(const MSRenderTexture& renderTexture)
+	void RenderToScreen(const DynamicResolution& resolution)
 	{
-		Graphics3D::Flush();
-		renderTexture.resolve();
-		Shader::LinearToScreen(renderTexture);
+		{
+			const FrameProfiler::ScopedTimer timer{ FrameProfiler::Phase::Flush };
+			SYNCSONG_TRACE_SCOPE("Graphics3D::Flush");
+			Graphics3D::Flush();
+		}
+		DynamicResolutionUtils::Present(resolution);
+	}
+
+	void DrawSelectionRect(const DragState& dragState)
+	{
+		if (not dragState.isSelecting)
+		{
+			return;
+		}
+
+		const RectF rect = RectF::FromPoints(dragState.selectionStart, dragState.selectionEnd);
+		rect.draw(ColorF{ 0.3, 0.6, 1.0, 0.2 });
+		rect.drawFrame(1.0, ColorF{ 0.3, 0.6, 1.0, 0.8 });
+	}
+
+	void DrawFrameTimeHistogram(const Array<uint32>& histogram, const RectF& rect, double maxMs)
+	{
+		rect.draw(ColorF{ 0.0, 0.5 });
+		if (not histogram)
+		{
+			return;
+		}
+
+		const uint32 maxCount = Max(*std::max_element(histogram.begin(), histogram.end()), 1u);
+		const double binWidth = (rect.w / histogram.size());
+
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			// 60fps（16.7ms）を超えるビンは赤で表示
+			const double binStartMs = (maxMs * i / histogram.size());
+			const ColorF color = ((binStartMs < (1000.0 / 60.0)) ? ColorF{ 0.4, 0.9, 0.4 } : ColorF{ 1.0, 0.4, 0.3 });
+			const double height = (rect.h * histogram[i] / maxCount);
+			RectF{ (rect.x + binWidth * i), (rect.y + rect.h - height), Max(binWidth - 1.0, 1.0), height }.draw(color);
+		}
 	}
 }
\ No newline at end of file
@@ -1,29 +1,198 @@
 #pragma once
 #include <Siv3D.hpp>
 #include "Config.hpp"
+#include "DynamicResolution.hpp"
 #include "GameTypes.hpp"
+#include "SphereStore.hpp"
+
+// 球のバッチ描画用定数バッファ（sphere_batch / sphere_impostor シェーダの VSSphereBatch に対応）
+struct SphereBatchConstants
+{
+	Float4 rotation; // (cos, sin, 球の半径, 未使用)
+	Float4 palette[5];
+	Float4 eyePosition; // (視点, 未使用)（sphere_impostor シェーダのみ使用）
+};
+
+// インポスター描画用定数バッファ（sphere_impostor シェーダの PSSphereImpostor に対応）
+struct SphereImpostorConstants
+{
+	Mat4x4 worldToProjected; // 球の表面の深度を求めるため
+	Float4 radius; // (球の半径, 未使用, 未使用, 未使用)
+};
+
+// バッチ内の球1つ分の属性（頂点の位置と UV に書き込む値）
+struct SphereInstance
+{
+	Float3 position;
+	Float2 attribute; // (パレット番号, 1: 取り付け / 0: 取り外し / -1: 未使用)
+
+	bool operator==(const SphereInstance&) const = default;
+};
+
+// LOD ごとのバッチに入れる球（instanceSlot はバッチ内の位置）
+struct SphereDrawItem
+{
+	uint32 instanceSlot = 0;
+	SphereInstance instance;
+};
+
+// 球のバッチ描画（チャンクごとに1ドローコール、変化したチャンクだけを再アップロード）
+// 球ごとのバッチ内の位置は SphereInstanceLayout で決まり、見えない球の位置は未使用にする
+// インポスター描画では sphereTemplate が視点を向く四角形になり、ピクセルシェーダで球をレイキャストする
+struct SphereBatch
+{
+	VertexShader vertexShader;
+	PixelShader pixelShader;
+	ConstantBuffer<SphereBatchConstants> constants;
+	ConstantBuffer<SphereImpostorConstants> impostorConstants;
+	MeshData sphereTemplate;
+	Array<MeshData> chunkData;
+	Array<DynamicMesh> chunkMeshes;
+	Array<bool> dirtyChunks;
+	Array<SphereInstance> instances; // 最後にアップロードした内容
+	Array<uint32> chunkUseCounts;    // チャンクごとの描画する球の数（0 のチャンクは描画しない）
+	Array<uint64> drawnInstanceBits; // このフレームに書き込んだ位置（64 個ずつ）
+	bool available = false; // シェーダを読み込めたか
+	bool isImpostor = false;
+};
+
+// 球の描画方式
+enum class SphereRenderMode : uint8
+{
+	Immediate, // Sphere::draw を球ごとに呼ぶ
+	Batch,     // 球のメッシュをまとめて描画
+	Impostor,  // 四角形をまとめて描画し、ピクセルシェーダで球をレイキャスト
+	Count,
+};
+
+// 球の LOD の集計（前回の描画分）
+struct SphereLodStats
+{
+	std::array<size_t, Config::SphereLodQualities.size()> sphereCounts{};
+	uint64 triangleCount = 0;
+	uint64 fullDetailTriangleCount = 0; // すべて LOD [0] で描画した場合の三角形数
+};
+
+// 球ごとのバッチ内の位置（取り付けられた球は回転変換前の円筒上の角度順、取り外された球はその後ろ）
+// カリングで詰めた並びを使うと、球が1つ出入りするだけで後ろの球がすべてずれて多くのチャンクを再アップロードすることになる
+// 角度順に固定しておけば、円筒が回転しても変化するのは見え始めた・隠れた角度の球を含むチャンクだけになる
+struct SphereInstanceLayout
+{
+	Array<uint32> instanceSlots; // 球のインデックスごとのバッチ内の位置
+	Array<uint32> denseToSlot;   // 並びを決めたときの球のハンドルのスロットと取り付けの状態（変わったら並べ直す）
+	Array<uint64> attachedBits;
+	Array<uint32> bucketOffsets; // 角度の区切りごとの先頭の位置（並べ直すときに使い回す）
+};
+
+// 球のカリングの結果（前回の描画分）
+struct SphereCullResult
+{
+	Array<uint32> visibleIndices; // 描画する球のインデックス（昇順）
+	size_t frustumCulledCount = 0; // 視錐台の外の球の数
+	size_t occludedCount = 0;      // 円筒に隠れた球の数
+};
+
+// ドラッグ中の球と選択した球の描画（少し透明にし、動かしている球はティックの間を補間した位置に置く）
+struct SphereDragHighlight
+{
+	Array<uint64> markedBits;   // 64 個ずつ、1 がドラッグ中か選択した球
+	int32 draggedIndex = -1;    // ドラッグ中の球（まとめてドラッグ中は掴んだ球）
+	bool isGroupDragging = false; // markedBits の球をすべて動かしているか
+	Vec3 dragOffset{ 0, 0, 0 }; // 動かしている球の、最後のティックの位置から描画する位置までのずれ
+
+	bool isMarked(size_t index) const
+	{
+		return (((index / 64) < markedBits.size()) && ((markedBits[index / 64] >> (index % 64)) & 1));
+	}
+
+	bool isMoving(size_t index) const
+	{
+		return ((static_cast<int32>(index) == draggedIndex) || (isGroupDragging && isMarked(index)));
+	}
+};
+
+// 球の描画方式ごとのバッチと、現在の描画方式
+struct SphereRenderer
+{
+	Array<SphereBatch> meshBatches; // LOD ごとのバッチ（[0] が最も細かい）
+	SphereBatch impostorBatch;
+	SphereRenderMode mode = SphereRenderMode::Immediate;
+
+	Array<uint8> slotLods; // 球のハンドルのスロットごとの LOD（ヒステリシスのため前回の値を保持）
+	Array<Array<SphereDrawItem>> lodInstances; // LOD ごとの描画する球（毎フレーム作り直す）
+	SphereLodStats lodStats;
+
+	bool cullingEnabled = true;
+	SphereCullResult cullResult;
+	SphereInstanceLayout instanceLayout;
+
+	SphereDragHighlight dragHighlight; // 毎フレーム作り直す
+};
 
 namespace RenderUtils
 {
-	// Of[VeNX`
+	// グラデーションテクスチャ生成
 	Texture CreateGradientTexture(const ColorF& topColor, const ColorF& bottomColor, int32 height);
 
-	// ~bV
+	// 円筒メッシュ生成
 	Mesh CreateCylinderMesh(double radius, double height, int32 quality = 24);
 
-	// 3DV[ݒ
+	// 3Dシーン初期設定
 	void Setup3DScene();
 
-	// 3DV[`
+	// 球のバッチ描画を初期化（シェーダを読み込めなかった場合は無効になる）
+	SphereBatch CreateSphereBatch(uint32 quality = Config::SphereMeshQuality);
+
+	// 球のインポスター描画を初期化（シェーダを読み込めなかった場合は無効になる）
+	SphereBatch CreateSphereImpostorBatch();
+
+	// 描画方式ごとのバッチを初期化（使える方式のうちバッチ描画を優先）
+	SphereRenderer CreateSphereRenderer();
+
+	// 描画方式が使えるか
+	bool IsAvailable(const SphereRenderer& sphereRenderer, SphereRenderMode mode);
+
+	// 次に使える描画方式に切り替える
+	void SelectNextRenderMode(SphereRenderer& sphereRenderer);
+
+	StringView GetRenderModeName(SphereRenderMode mode);
+
+	// 視錐台の外の球と、回転した円筒に視点から隠れる取り付けられた球を除き、描画する球の一覧を作る
+	// enabled が false のときはすべての球を描画する
+	void CullSpheres(SphereCullResult& cullResult, const SphereStore& spheres, double rotationAngle, const BasicCamera3D& camera, bool enabled);
+
+	// 球の並びや取り付けの状態が変わっていれば、球ごとのバッチ内の位置を決め直す
+	void UpdateSphereInstanceLayout(SphereInstanceLayout& layout, const SphereStore& spheres);
+
+	// visibleIndices の球の状態を layout の位置でバッチに反映（変化したチャンクだけを再アップロード。動かしている球は dragHighlight のずれを加える）
+	void UpdateSphereBatch(SphereBatch& sphereBatch, const SphereStore& spheres, const Array<uint32>& visibleIndices, const SphereInstanceLayout& layout,
+		const DragState& dragState, const SphereDragHighlight& dragHighlight);
+
+	// 画面上の半径から visibleIndices の球ごとの LOD を選び、LOD ごとの描画する球を作る（動かしている球は dragHighlight のずれを加える）
+	void UpdateSphereLods(SphereRenderer& sphereRenderer, const SphereStore& spheres, const Array<uint32>& visibleIndices,
+		const DragState& dragState, const SphereDragHighlight& dragHighlight, double rotationAngle, const BasicCamera3D& camera);
+
+	// バッチの球を描画（円筒の回転は頂点シェーダで適用）
+	void DrawSphereBatch(SphereBatch& sphereBatch, double rotationAngle, const BasicCamera3D& camera);
+
+	// 3Dシーン描画（回転角とドラッグ中の球の位置は interpolation の前の状態から alpha の割合だけ補間する。まとめてドラッグ中の球は掴んだ球と同じだけずらす）
 	void Render3DScene(
-		const MSRenderTexture& renderTexture,
+		const RenderTexture& renderTexture,
 		DebugCamera3D& camera,
 		const Mesh& cylinderMesh,
 		const Texture& gradientTexture,
-		const Array<SphereState>& spheres,
-		double rotationAngle,
-		const DragState& dragState);
+		const SphereStore& spheres,
+		double tickRotationAngle,
+		const DragState& dragState,
+		const TickInterpolation& interpolation,
+		SphereRenderer& sphereRenderer);
+
+	// 画面への描画（動的解像度の描画先を画面全体に拡大）
+	void RenderToScreen(const DynamicResolution& resolution);
+
+	// 範囲選択中の矩形を画面に描画
+	void DrawSelectionRect(const DragState& dragState);
 
-	// ʂւ̕`
-	void RenderToScreen(const MSRenderTexture& renderTexture);
+	// フレーム時間のヒストグラムを描画（各ビンの高さは最大のビンに合わせる）
+	void DrawFrameTimeHistogram(const Array<uint32>& histogram, const RectF& rect, double maxMs);
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "SimulationPipeline.hpp"
+#include "InputTraceUtils.hpp"
+#include "AllocationCounter.hpp"
+#include "FrameTracer.hpp"
+
+namespace SimulationPipelineUtils
+{
+	namespace
+	{
+		// firstFrame: 開始時点で渡されていたティックの入力の数（submittedFrames は描画側が書き換えるので開始前に読んでおく）
+		void RunWorker(SimulationPipeline& pipeline, uint64 firstFrame)
+		{
+			FrameTracer::SetCurrentThreadName(U"logic");
+			const AllocationCounter::ScopedSubsystem allocationScope{ AllocationCounter::Subsystem::Logic };
+
+			GameState& state = *pipeline.state;
+			uint64 logicFrame = firstFrame;
+			Array<FrameInput> inputs;
+			TickInterpolation previousTick = FixedTimestepUtils::CaptureTickState(state);
+
+			for (;;)
+			{
+				// 入力が届くまで待ち、届いた分をまとめて受け取る
+				{
+					std::unique_lock lock{ pipeline.mutex };
+					pipeline.inputAvailable.wait(lock, [&] { return (pipeline.stopRequested || pipeline.pendingInputs); });
+
+					if (not pipeline.pendingInputs)
+					{
+						return;
+					}
+
+					inputs.swap(pipeline.pendingInputs);
+				}
+
+				for (const FrameInput& input : inputs)
+				{
+					pipeline.arena.reset();
+					previousTick = FixedTimestepUtils::CaptureTickState(state);
+					InputTraceUtils::ApplyCamera(pipeline.logicCamera, input);
+					GameLogic::UpdateGameState(state, input, pipeline.logicCamera, pipeline.arena);
+					++logicFrame;
+				}
+				inputs.clear();
+
+				// 溜まっていた入力をすべて反映した状態だけを描画側に渡す
+				{
+					SYNCSONG_TRACE_SCOPE("CopySnapshot");
+					CopySnapshot(pipeline.snapshots.writeBuffer(), state, previousTick, logicFrame);
+				}
+				pipeline.snapshots.publish();
+
+				{
+					const std::lock_guard lock{ pipeline.mutex };
+					pipeline.publishedFrames = logicFrame;
+				}
+				pipeline.snapshotPublished.notify_one();
+			}
+		}
+	}
+
+	void Start(SimulationPipeline& pipeline, GameState& state, const BasicCamera3D& logicCamera)
+	{
+		if (pipeline.running)
+		{
+			return;
+		}
+
+		pipeline.state = &state;
+		pipeline.logicCamera = logicCamera;
+		pipeline.pendingInputs.clear();
+		pipeline.publishedFrames = pipeline.submittedFrames;
+		pipeline.stopRequested = false;
+
+		// 最初の入力を処理する前でも描画できるように、すべてのバッファを現在の状態にする
+		for (SceneSnapshot& snapshot : pipeline.snapshots.buffers)
+		{
+			CopySnapshot(snapshot, state, FixedTimestepUtils::CaptureTickState(state), pipeline.submittedFrames);
+		}
+
+		pipeline.worker = std::thread{ RunWorker, std::ref(pipeline), pipeline.submittedFrames };
+		pipeline.running = true;
+	}
+
+	void Stop(SimulationPipeline& pipeline)
+	{
+		if (not pipeline.running)
+		{
+			return;
+		}
+
+		{
+			const std::lock_guard lock{ pipeline.mutex };
+			pipeline.stopRequested = true;
+		}
+		pipeline.inputAvailable.notify_one();
+
+		pipeline.worker.join();
+		pipeline.state = nullptr;
+		pipeline.running = false;
+	}
+
+	void Submit(SimulationPipeline& pipeline, const FrameInput& input)
+	{
+		{
+			const std::lock_guard lock{ pipeline.mutex };
+			pipeline.pendingInputs.push_back(input);
+		}
+		pipeline.inputAvailable.notify_one();
+
+		++pipeline.submittedFrames;
+	}
+
+	const SceneSnapshot& AcquireSnapshot(SimulationPipeline& pipeline)
+	{
+		// ロジックが描画より遅いときに入力が溜まり続けないよう、前のフレームまでに渡した入力の反映を待つ
+		{
+			SYNCSONG_TRACE_SCOPE("WaitForSnapshot");
+			std::unique_lock lock{ pipeline.mutex };
+			pipeline.snapshotPublished.wait(lock, [&] { return (pipeline.submittedFrames <= pipeline.publishedFrames); });
+		}
+
+		return pipeline.snapshots.acquire();
+	}
+
+	void CopySnapshot(SceneSnapshot& snapshot, const GameState& state, const TickInterpolation& previousTick, uint64 logicFrame)
+	{
+		if (snapshot.spheres.revision != state.spheres.revision)
+		{
+			snapshot.spheres = state.spheres;
+		}
+		snapshot.rotationAngle = state.rotationAngle;
+		snapshot.dragState = state.dragState;
+		snapshot.previousTick = previousTick;
+		snapshot.editHistory = EditHistoryUtils::GetStats(state.history);
+		snapshot.logicFrame = logicFrame;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <Siv3D.hpp>
+#include "GameTypes.hpp"
+#include "SphereStore.hpp"
+#include "GameLogic.hpp"
+#include "FrameArena.hpp"
+#include "TripleBuffer.hpp"
+#include "FixedTimestep.hpp"
+
+// 描画に必要なゲーム状態の複製（ロジックのスレッドが書き、描画側は読むだけ）
+struct SceneSnapshot
+{
+	SphereStore spheres;
+	double rotationAngle = 0.0;
+	DragState dragState; // ドラッグ中の球とスナップ候補のハイライト
+	TickInterpolation previousTick; // 最後のティックを進める前の状態（描画の補間用）
+	EditHistoryStats editHistory;   // 元に戻す・やり直しの履歴の集計（オーバーレイ表示用）
+	uint64 logicFrame = 0; // 何ティック分の入力を反映したか
+};
+
+// ロジックを別スレッドで進め、描画側には直近のスナップショットを渡すパイプライン
+// 描画側がフレーム N を描画している間にロジックのスレッドがフレーム N+1 のティックを進める
+// 描画の前に前のフレームまでの入力がすべて反映されるのを待つので、描画は入力から最大1フレーム遅れ（ロジックが遅いときは描画側が待つ）
+struct SimulationPipeline
+{
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable inputAvailable;
+	std::condition_variable snapshotPublished;
+	Array<FrameInput> pendingInputs; // ロジックのスレッドがまだ処理していない入力（mutex で保護）
+	uint64 publishedFrames = 0;      // 最後に書き出したスナップショットが反映したティックの入力の数（mutex で保護）
+	bool stopRequested = false;      // mutex で保護
+
+	GameState* state = nullptr; // 実行中はロジックのスレッドだけが触る
+	BasicCamera3D logicCamera;
+	FrameArena arena{ Config::FrameArenaSize };
+	TripleBuffer<SceneSnapshot> snapshots;
+	uint64 submittedFrames = 0; // 描画側が渡したティックの入力の数（描画側だけが触る）
+	bool running = false;
+};
+
+namespace SimulationPipelineUtils
+{
+	// ロジックのスレッドを開始（停止するまで state を触らないこと）
+	void Start(SimulationPipeline& pipeline, GameState& state, const BasicCamera3D& logicCamera);
+
+	// 渡した入力をすべて処理してからロジックのスレッドを停止
+	void Stop(SimulationPipeline& pipeline);
+
+	// 1ティック分の入力を渡す（ロジックのスレッドが受け取った順に処理する）
+	void Submit(SimulationPipeline& pipeline, const FrameInput& input);
+
+	// これまでに渡した入力をすべて反映したスナップショット（書き出されるまで待つ。次の AcquireSnapshot まで有効）
+	const SceneSnapshot& AcquireSnapshot(SimulationPipeline& pipeline);
+
+	// 状態と最後のティックを進める前の状態をスナップショットに複製（確保済みの領域を使い回す）
+	// 球はスナップショットに複製した後に変わったときだけ複製する（回転だけのティックでは O(1)、ドラッグ中は球の数に比例）
+	void CopySnapshot(SceneSnapshot& snapshot, const GameState& state, const TickInterpolation& previousTick, uint64 logicFrame);
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "SphereStore.hpp"
+
+namespace
+{
+	constexpr uint64 BitMask(size_t index)
+	{
+		return (uint64{ 1 } << (index % 64));
+	}
+
+	void SetBit(Array<uint64>& bits, size_t index, bool value)
+	{
+		if (value)
+		{
+			bits[index / 64] |= BitMask(index);
+		}
+		else
+		{
+			bits[index / 64] &= ~BitMask(index);
+		}
+	}
+
+	bool GetBit(const Array<uint64>& bits, size_t index)
+	{
+		return ((bits[index / 64] & BitMask(index)) != 0);
+	}
+}
+
+size_t SphereStore::size() const
+{
+	return x.size();
+}
+
+bool SphereStore::isEmpty() const
+{
+	return x.isEmpty();
+}
+
+void SphereStore::clear()
+{
+	++revision;
+
+	x.clear();
+	y.clear();
+	z.clear();
+	attachedBits.clear();
+	yellowBits.clear();
+	originalIndex.clear();
+	denseToSlot.clear();
+	slotToDense.clear();
+	slotGenerations.clear();
+	freeSlots.clear();
+}
+
+void SphereStore::reserve(size_t capacity)
+{
+	x.reserve(capacity);
+	y.reserve(capacity);
+	z.reserve(capacity);
+	attachedBits.reserve((capacity + 63) / 64);
+	yellowBits.reserve((capacity + 63) / 64);
+	originalIndex.reserve(capacity);
+	denseToSlot.reserve(capacity);
+	slotToDense.reserve(capacity);
+	slotGenerations.reserve(capacity);
+	freeSlots.reserve(capacity);
+}
+
+void SphereStore::assignAttached(size_t count, bool isYellow)
+{
+	clear();
+
+	x.resize(count);
+	y.resize(count);
+	z.resize(count);
+	originalIndex.resize(count);
+	denseToSlot.resize(count);
+	slotToDense.resize(count);
+	slotGenerations.resize(count, 0);
+
+	std::iota(originalIndex.begin(), originalIndex.end(), 0);
+	std::iota(denseToSlot.begin(), denseToSlot.end(), 0u);
+	std::iota(slotToDense.begin(), slotToDense.end(), 0u);
+
+	// 球の数を超えるビットは 0 にしておく
+	const size_t wordCount = ((count + 63) / 64);
+	attachedBits.assign(wordCount, ~uint64{ 0 });
+	yellowBits.assign(wordCount, (isYellow ? ~uint64{ 0 } : 0));
+	if (const size_t remaining = (count % 64); remaining != 0)
+	{
+		attachedBits.back() &= ((uint64{ 1 } << remaining) - 1);
+		yellowBits.back() &= ((uint64{ 1 } << remaining) - 1);
+	}
+}
+
+SphereHandle SphereStore::push_back(const SphereState& sphere)
+{
+	++revision;
+
+	const size_t index = size();
+
+	// 空いているスロットがあれば再利用
+	uint32 slot;
+	if (freeSlots)
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<uint32>(slotToDense.size());
+		slotToDense.push_back(0);
+		slotGenerations.push_back(0);
+	}
+	slotToDense[slot] = static_cast<uint32>(index);
+	denseToSlot.push_back(slot);
+
+	x.push_back(static_cast<float>(sphere.position.x));
+	y.push_back(static_cast<float>(sphere.position.y));
+	z.push_back(static_cast<float>(sphere.position.z));
+	originalIndex.push_back(sphere.originalIndex);
+
+	if ((index % 64) == 0)
+	{
+		attachedBits.push_back(0);
+		yellowBits.push_back(0);
+	}
+
+	SetBit(attachedBits, index, sphere.isAttached);
+	SetBit(yellowBits, index, sphere.isYellow);
+
+	return{ slot, slotGenerations[slot] };
+}
+
+void SphereStore::erase(size_t index)
+{
+	++revision;
+
+	const size_t last = (size() - 1);
+
+	// 削除した球のスロットは世代を進めて空きに戻す
+	const uint32 slot = denseToSlot[index];
+	++slotGenerations[slot];
+	freeSlots.push_back(slot);
+
+	// 末尾の球を index に移動
+	if (index != last)
+	{
+		x[index] = x[last];
+		y[index] = y[last];
+		z[index] = z[last];
+		originalIndex[index] = originalIndex[last];
+		denseToSlot[index] = denseToSlot[last];
+		SetBit(attachedBits, index, GetBit(attachedBits, last));
+		SetBit(yellowBits, index, GetBit(yellowBits, last));
+		slotToDense[denseToSlot[index]] = static_cast<uint32>(index);
+	}
+
+	x.pop_back();
+	y.pop_back();
+	z.pop_back();
+	originalIndex.pop_back();
+	denseToSlot.pop_back();
+	SetBit(attachedBits, last, false);
+	SetBit(yellowBits, last, false);
+
+	// 使われなくなったワードを削除
+	if ((size() % 64) == 0)
+	{
+		attachedBits.pop_back();
+		yellowBits.pop_back();
+	}
+}
+
+SphereHandle SphereStore::insert(size_t index, const SphereState& sphere)
+{
+	const SphereHandle handle = push_back(sphere);
+	const size_t last = (size() - 1);
+
+	// 追加した末尾の球と index の球を入れ替える
+	if (index != last)
+	{
+		std::swap(x[index], x[last]);
+		std::swap(y[index], y[last]);
+		std::swap(z[index], z[last]);
+		std::swap(originalIndex[index], originalIndex[last]);
+		std::swap(denseToSlot[index], denseToSlot[last]);
+
+		const bool isAttachedAtIndex = GetBit(attachedBits, index);
+		const bool isYellowAtIndex = GetBit(yellowBits, index);
+		SetBit(attachedBits, index, GetBit(attachedBits, last));
+		SetBit(yellowBits, index, GetBit(yellowBits, last));
+		SetBit(attachedBits, last, isAttachedAtIndex);
+		SetBit(yellowBits, last, isYellowAtIndex);
+
+		slotToDense[denseToSlot[index]] = static_cast<uint32>(index);
+		slotToDense[denseToSlot[last]] = static_cast<uint32>(last);
+	}
+
+	return handle;
+}
+
+bool SphereStore::contains(SphereHandle handle) const
+{
+	return ((handle.slot < slotGenerations.size()) && (slotGenerations[handle.slot] == handle.generation));
+}
+
+Optional<size_t> SphereStore::indexOf(SphereHandle handle) const
+{
+	if (not contains(handle))
+	{
+		return none;
+	}
+
+	return slotToDense[handle.slot];
+}
+
+SphereHandle SphereStore::handleAt(size_t index) const
+{
+	const uint32 slot = denseToSlot[index];
+	return{ slot, slotGenerations[slot] };
+}
+
+Vec3 SphereStore::position(size_t index) const
+{
+	return{ x[index], y[index], z[index] };
+}
+
+void SphereStore::setPosition(size_t index, const Vec3& pos)
+{
+	++revision;
+	x[index] = static_cast<float>(pos.x);
+	y[index] = static_cast<float>(pos.y);
+	z[index] = static_cast<float>(pos.z);
+}
+
+bool SphereStore::isAttached(size_t index) const
+{
+	return GetBit(attachedBits, index);
+}
+
+void SphereStore::setAttached(size_t index, bool attached)
+{
+	++revision;
+	SetBit(attachedBits, index, attached);
+}
+
+bool SphereStore::isYellow(size_t index) const
+{
+	return GetBit(yellowBits, index);
+}
+
+void SphereStore::setYellow(size_t index, bool yellow)
+{
+	++revision;
+	SetBit(yellowBits, index, yellow);
+}
+
+SphereState SphereStore::get(size_t index) const
+{
+	return SphereState{ position(index), isAttached(index), isYellow(index), originalIndex[index] };
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include <Siv3D.hpp>
+#include "GameTypes.hpp"
+
+// 球の状態を配列の構造体（SoA）で保持するコンテナ
+// 位置は float の x/y/z 配列、フラグは 64 個ずつ詰めたビット列で持つ
+// 配列は詰めて保持し（削除時は末尾の球を移動）、外部からは世代付きハンドルで安定して参照する
+struct SphereStore
+{
+	Array<float> x;
+	Array<float> y;
+	Array<float> z;
+	Array<uint64> attachedBits; // 取り付けられているか
+	Array<uint64> yellowBits;   // 黄色か
+	Array<int32> originalIndex; // 格子スロットのインデックス
+	Array<uint32> denseToSlot;  // 配列のインデックス → ハンドルのスロット
+
+	Array<uint32> slotToDense;     // ハンドルのスロット → 配列のインデックス
+	Array<uint32> slotGenerations; // スロットの世代（削除のたびに進める）
+	Array<uint32> freeSlots;       // 再利用できるスロット
+
+	uint64 revision = 0; // 変更するたびに進める（変わっていない球の複製を省くため。配列を直接書き換えるときは先に進める）
+
+	size_t size() const;
+	bool isEmpty() const;
+	void clear();
+	void reserve(size_t capacity);
+
+	// count 個の取り付けられた球（originalIndex は 0, 1, 2, ...）で置き換える
+	// 位置は呼び出し側が x/y/z に書き込む（格子を SoA で直接生成するため）
+	void assignAttached(size_t count, bool isYellow);
+
+	// 末尾に追加し、ハンドルを返す
+	SphereHandle push_back(const SphereState& sphere);
+
+	// index の球を O(1) で削除（末尾の球が index に移動する）
+	void erase(size_t index);
+
+	// erase の逆: index にあった球を末尾に移し（ハンドルはそのまま）、index に追加した球のハンドルを返す
+	SphereHandle insert(size_t index, const SphereState& sphere);
+
+	// ハンドルが指す球が存在するか
+	bool contains(SphereHandle handle) const;
+
+	// ハンドルが指す球の現在のインデックス（削除済みなら none）
+	Optional<size_t> indexOf(SphereHandle handle) const;
+
+	// index の球のハンドル
+	SphereHandle handleAt(size_t index) const;
+
+	Vec3 position(size_t index) const;
+	void setPosition(size_t index, const Vec3& pos);
+	bool isAttached(size_t index) const;
+	void setAttached(size_t index, bool attached);
+	bool isYellow(size_t index) const;
+	void setYellow(size_t index, bool yellow);
+	SphereState get(size_t index) const;
+
+	// 取り付けられている球を昇順に列挙（fn が bool を返す場合、false で打ち切り）
+	template <class Fn>
+	void forEachAttached(Fn&& fn) const
+	{
+		forEachMasked([](uint64 attached, uint64) { return attached; }, fn);
+	}
+
+	// 取り付けられている灰色の球を昇順に列挙
+	template <class Fn>
+	void forEachAttachedGray(Fn&& fn) const
+	{
+		forEachMasked([](uint64 attached, uint64 yellow) { return (attached & ~yellow); }, fn);
+	}
+
+	// 取り付けられている黄色の球を昇順に列挙
+	template <class Fn>
+	void forEachAttachedYellow(Fn&& fn) const
+	{
+		forEachMasked([](uint64 attached, uint64 yellow) { return (attached & yellow); }, fn);
+	}
+
+	// 取り外された球を昇順に列挙
+	template <class Fn>
+	void forEachDetached(Fn&& fn) const
+	{
+		forEachMasked([](uint64 attached, uint64) { return ~attached; }, fn);
+	}
+
+private:
+
+	template <class MaskFn, class Fn>
+	void forEachMasked(MaskFn maskFn, Fn& fn) const
+	{
+		const size_t count = size();
+
+		for (size_t word = 0; word < attachedBits.size(); ++word)
+		{
+			uint64 bits = maskFn(attachedBits[word], yellowBits[word]);
+
+			// 最後のワードは球の数を超えるビットを落とす
+			if (const size_t remaining = (count - word * 64); remaining < 64)
+			{
+				bits &= ((uint64{ 1 } << remaining) - 1);
+			}
+
+			while (bits)
+			{
+				const int32 index = static_cast<int32>(word * 64 + std::countr_zero(bits));
+				bits &= (bits - 1);
+
+				if constexpr (std::is_same_v<std::invoke_result_t<Fn&, int32>, bool>)
+				{
+					if (not fn(index))
+					{
+						return;
+					}
+				}
+				else
+				{
+					fn(index);
+				}
+			}
+		}
+	}
+};
\ No newline at end of file
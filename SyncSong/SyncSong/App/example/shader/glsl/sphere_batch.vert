@@ -0,0 +1,76 @@
+//	SyncSong: sphere batch shader
+//
+//	Each vertex carries one sphere instance:
+//	position = sphere center, normal = unit offset on the sphere,
+//	uv = (palette index, attachment: 1 attached / 0 detached / -1 unused)
+
+# version 410
+
+//
+//	VSInput
+//
+layout(location = 0) in vec4 VertexPosition;
+layout(location = 1) in vec3 VertexNormal;
+layout(location = 2) in vec2 VertexUV;
+
+//
+//	VSOutput
+//
+layout(location = 0) out vec3 WorldPosition;
+layout(location = 1) out vec2 UV;
+layout(location = 2) out vec3 Normal;
+layout(location = 3) out vec4 Color;
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+//
+//	Constant Buffer
+//
+layout(std140) uniform VSPerView // slot 1
+{
+	mat4x4 g_worldToProjected;
+};
+
+layout(std140) uniform VSSphereBatch // slot 4
+{
+	vec4 g_rotation; // (cos, sin, sphere radius, unused)
+	vec4 g_palette[5];
+};
+
+//
+//	Functions
+//
+vec3 RotateZ(vec3 v)
+{
+	return vec3(v.x * g_rotation.x - v.y * g_rotation.y, v.x * g_rotation.y + v.y * g_rotation.x, v.z);
+}
+
+void main()
+{
+	float attachment = VertexUV.y;
+	vec3 offset = (VertexNormal * g_rotation.z);
+
+	// Attached spheres follow the cylinder rotation, detached ones are already in world space
+	vec3 worldPosition = (VertexPosition.xyz + offset);
+	vec3 normal = VertexNormal;
+
+	if (0.5 < attachment)
+	{
+		worldPosition = RotateZ(worldPosition);
+		normal = RotateZ(normal);
+	}
+
+	// Unused slots collapse to a point and produce no pixels
+	if (attachment < -0.5)
+	{
+		worldPosition = vec3(0.0);
+	}
+
+	gl_Position		= vec4(worldPosition, 1.0) * g_worldToProjected;
+	WorldPosition	= worldPosition;
+	UV				= VertexUV;
+	Normal			= normal;
+	Color			= g_palette[int(VertexUV.x)];
+}
@@ -0,0 +1,102 @@
+//	SyncSong: sphere impostor shader
+
+# version 410
+
+//
+//	PSInput
+//
+layout(location = 0) in vec3 WorldPosition;
+layout(location = 1) in vec2 UV;
+layout(location = 2) flat in vec3 Center;
+layout(location = 3) in vec4 Color;
+
+//
+//	PSOutput
+//
+layout(location = 0) out vec4 FragColor;
+
+//
+//	Constant Buffer
+//
+layout(std140) uniform PSPerFrame // slot 0
+{
+	vec3 g_globalAmbientColor;
+	vec3 g_sunColor;
+	vec3 g_sunDirection;
+};
+
+layout(std140) uniform PSPerView // slot 1
+{
+	vec3 g_eyePosition;
+};
+
+layout(std140) uniform PSPerMaterial // slot 3
+{
+	vec3  g_ambientColor;
+	uint  g_hasTexture;
+	vec4  g_diffuseColor;
+	vec3  g_specularColor;
+	float g_shininess;
+	vec3  g_emissionColor;
+};
+
+layout(std140) uniform PSSphereImpostor // slot 4
+{
+	mat4x4 g_impostorWorldToProjected;
+	vec4 g_impostorRadius; // (sphere radius, unused, unused, unused)
+};
+
+//
+//	Functions
+//
+vec3 CalculateDiffuseReflection(vec3 n, vec3 l, vec3 lightColor, vec3 diffuseColor, vec3 ambientColor)
+{
+	vec3 directColor = lightColor * max(dot(n, l), 0.0f);
+	return ((ambientColor + directColor) * diffuseColor);
+}
+
+vec3 CalculateSpecularReflection(vec3 n, vec3 h, float shininess, float nl, vec3 lightColor, vec3 specularColor)
+{
+	float highlight = pow(max(dot(n, h), 0.0f), shininess) * float(0.0f < nl);
+	return (lightColor * specularColor * highlight);
+}
+
+void main()
+{
+	// Ray-cast the sphere from the eye through this fragment of the quad
+	float radius = g_impostorRadius.x;
+	vec3 rayDirection = normalize(WorldPosition - g_eyePosition);
+	vec3 oc = (g_eyePosition - Center);
+	float b = dot(oc, rayDirection);
+	float c = dot(oc, oc) - (radius * radius);
+	float discriminant = (b * b - c);
+
+	if (discriminant < 0.0)
+	{
+		discard;
+	}
+
+	vec3 hitPosition = (g_eyePosition + rayDirection * (-b - sqrt(discriminant)));
+	vec4 projected = vec4(hitPosition, 1.0) * g_impostorWorldToProjected;
+
+	vec3 lightColor		= g_sunColor;
+	vec3 lightDirection	= g_sunDirection;
+
+	vec3 n = ((hitPosition - Center) / radius);
+	vec3 l = lightDirection;
+	vec4 diffuseColor = (g_diffuseColor * Color);
+	vec3 ambientColor = (g_ambientColor * g_globalAmbientColor);
+
+	// Diffuse
+	vec3 diffuseReflection = CalculateDiffuseReflection(n, l, lightColor, diffuseColor.rgb, ambientColor);
+
+	// Specular
+	vec3 v = -rayDirection;
+	vec3 h = normalize(v + lightDirection);
+	vec3 specularReflection = CalculateSpecularReflection(n, h, g_shininess, dot(n, l), lightColor, g_specularColor);
+
+	FragColor = vec4(diffuseReflection + specularReflection + g_emissionColor, diffuseColor.a);
+
+	// Same depth mapping the rasterizer applies to gl_Position
+	gl_FragDepth = (((projected.z / projected.w) * gl_DepthRange.diff) + gl_DepthRange.near + gl_DepthRange.far) * 0.5;
+}
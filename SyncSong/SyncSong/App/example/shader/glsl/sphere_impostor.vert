@@ -0,0 +1,88 @@
+//	SyncSong: sphere impostor shader
+//
+//	Each sphere is drawn as a quad facing the eye; the fragment shader ray-casts the sphere.
+//	Each vertex carries one sphere instance:
+//	position = sphere center, normal.xy = quad corner (-1 or 1),
+//	uv = (palette index, attachment: 1 attached / 0 detached / -1 unused)
+
+# version 410
+
+//
+//	VSInput
+//
+layout(location = 0) in vec4 VertexPosition;
+layout(location = 1) in vec3 VertexNormal;
+layout(location = 2) in vec2 VertexUV;
+
+//
+//	VSOutput
+//
+layout(location = 0) out vec3 WorldPosition;
+layout(location = 1) out vec2 UV;
+layout(location = 2) flat out vec3 Center;
+layout(location = 3) out vec4 Color;
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+//
+//	Constant Buffer
+//
+layout(std140) uniform VSPerView // slot 1
+{
+	mat4x4 g_worldToProjected;
+};
+
+layout(std140) uniform VSSphereBatch // slot 4
+{
+	vec4 g_rotation; // (cos, sin, sphere radius, unused)
+	vec4 g_palette[5];
+	vec4 g_impostorEyePosition; // (eye position, unused)
+};
+
+//
+//	Functions
+//
+vec3 RotateZ(vec3 v)
+{
+	return vec3(v.x * g_rotation.x - v.y * g_rotation.y, v.x * g_rotation.y + v.y * g_rotation.x, v.z);
+}
+
+void main()
+{
+	float attachment = VertexUV.y;
+	float radius = g_rotation.z;
+
+	// Attached spheres follow the cylinder rotation, detached ones are already in world space
+	vec3 center = VertexPosition.xyz;
+
+	if (0.5 < attachment)
+	{
+		center = RotateZ(center);
+	}
+
+	// The quad lies on the plane through the center facing the eye,
+	// large enough to cover the silhouette cone of the sphere
+	vec3 toEye = (g_impostorEyePosition.xyz - center);
+	float distance = length(toEye);
+	vec3 forward = (toEye / max(distance, 1e-6));
+	vec3 helper = ((abs(forward.y) < 0.99) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0));
+	vec3 right = normalize(cross(helper, forward));
+	vec3 up = cross(forward, right);
+	float extent = (radius * distance * inversesqrt(max((distance * distance) - (radius * radius), 1e-6)));
+
+	vec3 worldPosition = (center + (right * VertexNormal.x + up * VertexNormal.y) * extent);
+
+	// Unused slots collapse to a point and produce no pixels
+	if (attachment < -0.5)
+	{
+		worldPosition = vec3(0.0);
+	}
+
+	gl_Position		= vec4(worldPosition, 1.0) * g_worldToProjected;
+	WorldPosition	= worldPosition;
+	UV				= VertexUV;
+	Center			= center;
+	Color			= g_palette[int(VertexUV.x)];
+}
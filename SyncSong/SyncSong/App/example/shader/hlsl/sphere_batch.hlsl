@@ -0,0 +1,146 @@
+//
+//	SyncSong: sphere batch shader
+//
+//	Each vertex carries one sphere instance:
+//	position = sphere center, normal = unit offset on the sphere,
+//	uv = (palette index, attachment: 1 attached / 0 detached / -1 unused)
+//
+
+namespace s3d
+{
+	//
+	//	VS Input
+	//
+	struct VSInput
+	{
+		float4 position : POSITION;
+		float3 normal : NORMAL;
+		float2 uv : TEXCOORD0;
+	};
+
+	//
+	//	VS Output / PS Input
+	//
+	struct PSInput
+	{
+		float4 position : SV_POSITION;
+		float3 worldPosition : TEXCOORD0;
+		float2 uv : TEXCOORD1;
+		float3 normal : TEXCOORD2;
+		float4 color : TEXCOORD3;
+	};
+}
+
+//
+//	Constant Buffer
+//
+cbuffer VSPerView : register(b1)
+{
+	row_major float4x4 g_worldToProjected;
+}
+
+cbuffer VSSphereBatch : register(b4)
+{
+	float4 g_rotation; // (cos, sin, sphere radius, unused)
+	float4 g_palette[5];
+}
+// [C++]
+//struct SphereBatchConstants
+//{
+//	Float4 rotation;
+//	Float4 palette[5];
+//};
+
+cbuffer PSPerFrame : register(b0)
+{
+	float3 g_globalAmbientColor;
+	float3 g_sunColor;
+	float3 g_sunDirection;
+}
+
+cbuffer PSPerView : register(b1)
+{
+	float3 g_eyePosition;
+}
+
+cbuffer PSPerMaterial : register(b3)
+{
+	float3 g_ambientColor;
+	uint   g_hasTexture;
+	float4 g_diffuseColor;
+	float3 g_specularColor;
+	float  g_shininess;
+	float3 g_emissionColor;
+}
+
+//
+//	Functions
+//
+float3 RotateZ(float3 v)
+{
+	return float3(v.x * g_rotation.x - v.y * g_rotation.y, v.x * g_rotation.y + v.y * g_rotation.x, v.z);
+}
+
+s3d::PSInput VS(s3d::VSInput input)
+{
+	s3d::PSInput result;
+
+	const float attachment = input.uv.y;
+	const float3 offset = (input.normal * g_rotation.z);
+
+	// Attached spheres follow the cylinder rotation, detached ones are already in world space
+	float3 worldPosition = (input.position.xyz + offset);
+	float3 normal = input.normal;
+
+	if (0.5 < attachment)
+	{
+		worldPosition = RotateZ(worldPosition);
+		normal = RotateZ(normal);
+	}
+
+	// Unused slots collapse to a point and produce no pixels
+	if (attachment < -0.5)
+	{
+		worldPosition = float3(0.0, 0.0, 0.0);
+	}
+
+	result.position			= mul(float4(worldPosition, 1.0), g_worldToProjected);
+	result.worldPosition	= worldPosition;
+	result.uv				= input.uv;
+	result.normal			= normal;
+	result.color			= g_palette[(uint)input.uv.x];
+	return result;
+}
+
+float3 CalculateDiffuseReflection(float3 n, float3 l, float3 lightColor, float3 diffuseColor, float3 ambientColor)
+{
+	const float3 directColor = lightColor * saturate(dot(n, l));
+	return ((ambientColor + directColor) * diffuseColor);
+}
+
+float3 CalculateSpecularReflection(float3 n, float3 h, float shininess, float nl, float3 lightColor, float3 specularColor)
+{
+	const float highlight = pow(saturate(dot(n, h)), shininess) * float(0.0 < nl);
+	return (lightColor * specularColor * highlight);
+}
+
+float4 PS(s3d::PSInput input) : SV_TARGET
+{
+	const float3 lightColor		= g_sunColor;
+	const float3 lightDirection	= g_sunDirection;
+
+	const float3 n = normalize(input.normal);
+	const float3 l = lightDirection;
+	const float4 diffuseColor = (g_diffuseColor * input.color);
+	const float3 ambientColor = (g_ambientColor * g_globalAmbientColor);
+
+	// Diffuse
+	const float3 diffuseReflection = CalculateDiffuseReflection(n, l, lightColor, diffuseColor.rgb, ambientColor);
+
+	// Specular
+	const float3 v = normalize(g_eyePosition - input.worldPosition);
+	const float3 h = normalize(v + lightDirection);
+	const float3 specularReflection = CalculateSpecularReflection(n, h, g_shininess, dot(n, l), lightColor, g_specularColor);
+
+	return float4(diffuseReflection + specularReflection + g_emissionColor, diffuseColor.a);
+}
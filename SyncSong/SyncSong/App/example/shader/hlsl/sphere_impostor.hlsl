@@ -0,0 +1,201 @@
+//
+//	SyncSong: sphere impostor shader
+//
+//	Each sphere is drawn as a quad facing the eye; the pixel shader ray-casts the sphere
+//	and writes its depth and normal, so the result matches a tessellated sphere.
+//	Each vertex carries one sphere instance:
+//	position = sphere center, normal.xy = quad corner (-1 or 1),
+//	uv = (palette index, attachment: 1 attached / 0 detached / -1 unused)
+//
+
+namespace s3d
+{
+	//
+	//	VS Input
+	//
+	struct VSInput
+	{
+		float4 position : POSITION;
+		float3 normal : NORMAL;
+		float2 uv : TEXCOORD0;
+	};
+
+	//
+	//	VS Output / PS Input
+	//
+	struct PSInput
+	{
+		float4 position : SV_POSITION;
+		float3 worldPosition : TEXCOORD0;
+		float2 uv : TEXCOORD1;
+		nointerpolation float3 center : TEXCOORD2;
+		float4 color : TEXCOORD3;
+	};
+
+	//
+	//	PS Output
+	//
+	struct PSOutput
+	{
+		float4 color : SV_TARGET;
+		float depth : SV_DEPTH;
+	};
+}
+
+//
+//	Constant Buffer
+//
+cbuffer VSPerView : register(b1)
+{
+	row_major float4x4 g_worldToProjected;
+}
+
+cbuffer VSSphereBatch : register(b4)
+{
+	float4 g_rotation; // (cos, sin, sphere radius, unused)
+	float4 g_palette[5];
+	float4 g_impostorEyePosition; // (eye position, unused)
+}
+// [C++]
+//struct SphereBatchConstants
+//{
+//	Float4 rotation;
+//	Float4 palette[5];
+//	Float4 eyePosition;
+//};
+
+cbuffer PSPerFrame : register(b0)
+{
+	float3 g_globalAmbientColor;
+	float3 g_sunColor;
+	float3 g_sunDirection;
+}
+
+cbuffer PSPerView : register(b1)
+{
+	float3 g_eyePosition;
+}
+
+cbuffer PSPerMaterial : register(b3)
+{
+	float3 g_ambientColor;
+	uint   g_hasTexture;
+	float4 g_diffuseColor;
+	float3 g_specularColor;
+	float  g_shininess;
+	float3 g_emissionColor;
+}
+
+cbuffer PSSphereImpostor : register(b4)
+{
+	row_major float4x4 g_impostorWorldToProjected;
+	float4 g_impostorRadius; // (sphere radius, unused, unused, unused)
+}
+// [C++]
+//struct SphereImpostorConstants
+//{
+//	Mat4x4 worldToProjected;
+//	Float4 radius;
+//};
+
+//
+//	Functions
+//
+float3 RotateZ(float3 v)
+{
+	return float3(v.x * g_rotation.x - v.y * g_rotation.y, v.x * g_rotation.y + v.y * g_rotation.x, v.z);
+}
+
+s3d::PSInput VS(s3d::VSInput input)
+{
+	s3d::PSInput result;
+
+	const float attachment = input.uv.y;
+	const float radius = g_rotation.z;
+
+	// Attached spheres follow the cylinder rotation, detached ones are already in world space
+	float3 center = input.position.xyz;
+
+	if (0.5 < attachment)
+	{
+		center = RotateZ(center);
+	}
+
+	// The quad lies on the plane through the center facing the eye,
+	// large enough to cover the silhouette cone of the sphere
+	const float3 toEye = (g_impostorEyePosition.xyz - center);
+	const float distance = length(toEye);
+	const float3 forward = (toEye / max(distance, 1e-6));
+	const float3 helper = ((abs(forward.y) < 0.99) ? float3(0.0, 1.0, 0.0) : float3(1.0, 0.0, 0.0));
+	const float3 right = normalize(cross(helper, forward));
+	const float3 up = cross(forward, right);
+	const float extent = (radius * distance * rsqrt(max((distance * distance) - (radius * radius), 1e-6)));
+
+	float3 worldPosition = (center + (right * input.normal.x + up * input.normal.y) * extent);
+
+	// Unused slots collapse to a point and produce no pixels
+	if (attachment < -0.5)
+	{
+		worldPosition = float3(0.0, 0.0, 0.0);
+	}
+
+	result.position			= mul(float4(worldPosition, 1.0), g_worldToProjected);
+	result.worldPosition	= worldPosition;
+	result.uv				= input.uv;
+	result.center			= center;
+	result.color			= g_palette[(uint)input.uv.x];
+	return result;
+}
+
+float3 CalculateDiffuseReflection(float3 n, float3 l, float3 lightColor, float3 diffuseColor, float3 ambientColor)
+{
+	const float3 directColor = lightColor * saturate(dot(n, l));
+	return ((ambientColor + directColor) * diffuseColor);
+}
+
+float3 CalculateSpecularReflection(float3 n, float3 h, float shininess, float nl, float3 lightColor, float3 specularColor)
+{
+	const float highlight = pow(saturate(dot(n, h)), shininess) * float(0.0 < nl);
+	return (lightColor * specularColor * highlight);
+}
+
+s3d::PSOutput PS(s3d::PSInput input)
+{
+	s3d::PSOutput result;
+
+	// Ray-cast the sphere from the eye through this pixel of the quad
+	const float radius = g_impostorRadius.x;
+	const float3 rayDirection = normalize(input.worldPosition - g_eyePosition);
+	const float3 oc = (g_eyePosition - input.center);
+	const float b = dot(oc, rayDirection);
+	const float c = dot(oc, oc) - (radius * radius);
+	const float discriminant = (b * b - c);
+
+	if (discriminant < 0.0)
+	{
+		discard;
+	}
+
+	const float3 hitPosition = (g_eyePosition + rayDirection * (-b - sqrt(discriminant)));
+	const float4 projected = mul(float4(hitPosition, 1.0), g_impostorWorldToProjected);
+
+	const float3 lightColor		= g_sunColor;
+	const float3 lightDirection	= g_sunDirection;
+
+	const float3 n = ((hitPosition - input.center) / radius);
+	const float3 l = lightDirection;
+	const float4 diffuseColor = (g_diffuseColor * input.color);
+	const float3 ambientColor = (g_ambientColor * g_globalAmbientColor);
+
+	// Diffuse
+	const float3 diffuseReflection = CalculateDiffuseReflection(n, l, lightColor, diffuseColor.rgb, ambientColor);
+
+	// Specular
+	const float3 v = -rayDirection;
+	const float3 h = normalize(v + lightDirection);
+	const float3 specularReflection = CalculateSpecularReflection(n, h, g_shininess, dot(n, l), lightColor, g_specularColor);
+
+	result.color = float4(diffuseReflection + specularReflection + g_emissionColor, diffuseColor.a);
+	result.depth = (projected.z / projected.w);
+	return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 書き込み側と読み出し側の2スレッドで値を受け渡すトリプルバッファ（ロックなし）
+// 書き込み側は writeBuffer() に書いて publish()、読み出し側は acquire() で最新の値を得る
+// 読み出し側は次の acquire() まで同じバッファを使い続けられ、書き込み側はそれを上書きしない
+template <class Type>
+struct TripleBuffer
+{
+	std::array<Type, 3> buffers{};
+
+	// 書き込み中のバッファ（書き込み側のみ）
+	Type& writeBuffer()
+	{
+		return buffers[writeIndex];
+	}
+
+	// 書き込んだバッファを公開し、空いているバッファを次の書き込み先にする
+	void publish()
+	{
+		writeIndex = (sharedIndex.exchange((writeIndex | NewDataBit), std::memory_order_acq_rel) & IndexMask);
+	}
+
+	// 新しく公開されたバッファがあれば読み出し中のバッファと交換し、読み出し中のバッファを返す（読み出し側のみ）
+	const Type& acquire()
+	{
+		if (sharedIndex.load(std::memory_order_relaxed) & NewDataBit)
+		{
+			readIndex = (sharedIndex.exchange(readIndex, std::memory_order_acq_rel) & IndexMask);
+		}
+
+		return buffers[readIndex];
+	}
+
+private:
+
+	static constexpr uint8 IndexMask = 0b011;
+	static constexpr uint8 NewDataBit = 0b100;
+
+	uint8 writeIndex = 0;
+	uint8 readIndex = 1;
+	std::atomic<uint8> sharedIndex{ 2 }; // 書き込み側と読み出し側の間で受け渡すバッファ
+};
\ No newline at end of file
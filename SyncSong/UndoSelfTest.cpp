@@ -0,0 +1,236 @@
+#include "UndoSelfTest.hpp"
+#include "Config.hpp"
+#include "GameLogic.hpp"
+#include "InputTraceUtils.hpp"
+
+namespace UndoSelfTestUtils
+{
+	namespace
+	{
+		const Size SceneSize{ 800, 600 };
+
+		constexpr size_t MaxPickAttempts = 400;   // 条件に合う球が見える画面上の点を探すときに試す数
+		constexpr size_t DragTickCount = 4;       // 押してから離すまでにカーソルを動かすティック数
+		constexpr size_t PickCheckCount = 64;     // ピッキング用インデックスを確かめる画面上の点の数
+		constexpr int32 MaxRotationTicks = 30;    // ステップの間に自動回転で進めるティック数の上限
+		constexpr size_t MaxSkippedSteps = 1000;  // 掴める球が見つからずに飛ばしたステップの数の上限
+
+		FrameInput MakeInput()
+		{
+			FrameInput input;
+			input.deltaTime = (1.0 / Config::LogicTickRate);
+			input.eyePosition = Vec3{ 10, 0, 0 };
+			return input;
+		}
+
+		// 選択を解除し、回転角を除いた状態のハッシュ（元に戻す・やり直しは回転を変えず、選択を解除する）
+		uint64 HashEditedState(GameState& state)
+		{
+			const double rotationAngle = state.rotationAngle;
+			state.rotationAngle = 0.0;
+			state.dragState.selectedSpheres.clear();
+			const uint64 hash = InputTraceUtils::HashGameState(state);
+			state.rotationAngle = rotationAngle;
+			return hash;
+		}
+
+		// ピッキング用インデックスが球の状態から作り直したものと同じ結果を返すか
+		bool IsPickIndexValid(const GameState& state, const BasicCamera3D& camera, SmallRNG& rng, FrameArena& arena)
+		{
+			SpherePickIndex rebuilt{ Config::CylinderRadius, Config::CylinderHeight, Config::GridUDiv, Config::GridVDiv, Config::GridMargin };
+			GameLogic::RebuildPickIndex(state.spheres, rebuilt);
+			if (rebuilt.slotSpheres != state.pickIndex.slotSpheres)
+			{
+				return false;
+			}
+
+			const Mat4x4 transform = Mat4x4::RotateZ(state.rotationAngle);
+			for (size_t i = 0; i < PickCheckCount; ++i)
+			{
+				const Vec2 pos{ Random(0.0, static_cast<double>(SceneSize.x), rng), Random(0.0, static_cast<double>(SceneSize.y), rng) };
+				const auto expected = GameLogic::CheckSphereClick(pos, state.spheres, rebuilt, camera, transform, arena);
+				const auto actual = GameLogic::CheckSphereClick(pos, state.spheres, state.pickIndex, camera, transform, arena);
+				arena.reset();
+
+				if (expected != actual)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	UndoSelfTestResult Run(size_t stepCount, size_t byteBudget, uint64 seed)
+	{
+		UndoSelfTestResult result;
+		result.byteBudget = byteBudget;
+
+		SmallRNG rng{ seed };
+		FrameArena arena{ Config::FrameArenaSize };
+		const BasicCamera3D camera{ SceneSize, 45_deg, Vec3{ 10, 0, 0 } };
+
+		// 半分ほどの格子スロットを灰色にしてスナップ先を作る
+		GameState state;
+		GameLogic::InitializeGameState(state);
+		Array<uint64> yellowSlotBits(((state.gridPositions.size() + 63) / 64), 0);
+		for (size_t slot = 0; slot < state.gridPositions.size(); ++slot)
+		{
+			if (Random(0, 1, rng))
+			{
+				yellowSlotBits[slot / 64] |= (uint64{ 1 } << (slot % 64));
+			}
+		}
+		GameLogic::ApplySlotColors(state, yellowSlotBits);
+		EditHistoryUtils::SetByteBudget(state.history, byteBudget);
+
+		const auto tick = [&](const FrameInput& input)
+		{
+			arena.reset();
+			GameLogic::UpdateGameState(state, input, camera, arena);
+		};
+
+		// predicate を満たす球が手前に見える画面上の点を探す
+		const auto findSphereOnScreen = [&](auto predicate) -> Optional<std::pair<Vec2, int32>>
+		{
+			const Mat4x4 transform = Mat4x4::RotateZ(state.rotationAngle);
+			for (size_t attempt = 0; attempt < MaxPickAttempts; ++attempt)
+			{
+				const Vec2 pos{ Random(0.0, static_cast<double>(SceneSize.x), rng), Random(0.0, static_cast<double>(SceneSize.y), rng) };
+				const auto index = GameLogic::CheckSphereClick(pos, state.spheres, state.pickIndex, camera, transform, arena);
+				arena.reset();
+
+				if (index && predicate(*index))
+				{
+					return std::pair{ pos, *index };
+				}
+			}
+			return none;
+		};
+
+		// from で押して to で離す（isSelectModifierPressed なら範囲選択）
+		const auto drag = [&](const Vec2& from, const Vec2& to, bool isSelectModifierPressed)
+		{
+			FrameInput press = MakeInput();
+			press.mouseLDown = true;
+			press.mouseLPressed = true;
+			press.mouseLDownPos = from;
+			press.cursorPos = from;
+			press.isSelectModifierPressed = isSelectModifierPressed;
+			tick(press);
+
+			for (size_t i = 1; i < DragTickCount; ++i)
+			{
+				FrameInput move = MakeInput();
+				move.mouseLPressed = true;
+				move.cursorPos = from.lerp(to, (static_cast<double>(i) / DragTickCount));
+				tick(move);
+			}
+
+			FrameInput release = MakeInput();
+			release.mouseLUp = true;
+			release.mouseLUpPos = to;
+			release.cursorPos = to;
+			release.mouseLUpTime = release.deltaTime;
+			tick(release);
+		};
+
+		const auto requestUndo = [&]()
+		{
+			FrameInput input = MakeInput();
+			input.isUndoRequested = true;
+			tick(input);
+		};
+
+		const auto requestRedo = [&]()
+		{
+			FrameInput input = MakeInput();
+			input.isRedoRequested = true;
+			tick(input);
+		};
+
+		// stateHashes[k]: k ステップ目を記録した後の状態（[0] は初期状態）
+		Array<uint64> stateHashes{ HashEditedState(state) };
+		size_t skippedStepCount = 0;
+
+		while ((result.stepCount < stepCount) && (skippedStepCount < MaxSkippedSteps))
+		{
+			// ステップの間は円筒を回して、クリック・スナップの回転変換を変える
+			FrameInput rotation = MakeInput();
+			rotation.isAutoRotationEnabled = true;
+			for (int32 i = Random(0, MaxRotationTicks, rng); 0 < i; --i)
+			{
+				tick(rotation);
+			}
+
+			// 3回に1回は範囲選択してから、選択した球をまとめてドラッグする
+			bool isGroupStep = false;
+			if (Random(0, 2, rng) == 0)
+			{
+				const Vec2 corner0{ Random(0.0, static_cast<double>(SceneSize.x), rng), Random(0.0, static_cast<double>(SceneSize.y), rng) };
+				const Vec2 corner1 = (corner0 + Vec2{ Random(-300.0, 300.0, rng), Random(-300.0, 300.0, rng) });
+				drag(corner0, corner1, true);
+				isGroupStep = (2 <= state.dragState.selectedSpheres.size());
+			}
+
+			const auto grabbed = findSphereOnScreen([&](int32 index)
+			{
+				return (state.spheres.isYellow(index)
+					&& ((not isGroupStep) || state.dragState.selectedSpheres.includes(state.spheres.handleAt(index))));
+			});
+			if (not grabbed)
+			{
+				state.dragState.selectedSpheres.clear();
+				++skippedStepCount;
+				continue;
+			}
+
+			// 半分は灰色の球が見える位置に落としてスナップさせ、残りは適当な位置に落とす
+			const auto snapTarget = ((Random(0, 1, rng) == 0)
+				? findSphereOnScreen([&](int32 index) { return (state.spheres.isAttached(index) && (not state.spheres.isYellow(index))); }) : none);
+			const Vec2 dropPos = (snapTarget ? snapTarget->first
+				: (grabbed->first + Vec2{ Random(-150.0, 150.0, rng), Random(-150.0, 150.0, rng) }));
+			const SphereHandle snapHandle = (snapTarget ? state.spheres.handleAt(snapTarget->second) : SphereHandle{});
+
+			drag(grabbed->first, dropPos, false);
+
+			const auto snapIndex = state.spheres.indexOf(snapHandle);
+			result.snapStepCount += ((snapIndex && state.spheres.isYellow(*snapIndex)) ? 1 : 0);
+			result.groupStepCount += (isGroupStep ? 1 : 0);
+			++result.stepCount;
+			stateHashes.push_back(HashEditedState(state));
+
+			// ときどき途中で元に戻してやり直す（1ステップだけで容量を超えて捨てた場合は戻せない）
+			if ((Random(0, 4, rng) == 0) && EditHistoryUtils::GetStats(state.history).undoStepCount)
+			{
+				requestUndo();
+				result.mismatchCount += ((HashEditedState(state) != stateHashes[stateHashes.size() - 2]) ? 1 : 0);
+				requestRedo();
+				result.mismatchCount += ((HashEditedState(state) != stateHashes.back()) ? 1 : 0);
+			}
+		}
+
+		result.discardedStepCount = EditHistoryUtils::GetStats(state.history).discardedStepCount;
+		result.isPickIndexValid = IsPickIndexValid(state, camera, rng, arena);
+
+		// 戻せるところまで元に戻す
+		while (EditHistoryUtils::GetStats(state.history).undoStepCount)
+		{
+			requestUndo();
+			++result.undoneStepCount;
+			result.mismatchCount += ((HashEditedState(state) != stateHashes[result.stepCount - result.undoneStepCount]) ? 1 : 0);
+		}
+		result.isPickIndexValid = (result.isPickIndexValid && IsPickIndexValid(state, camera, rng, arena));
+
+		// すべてやり直す
+		while (EditHistoryUtils::GetStats(state.history).redoStepCount)
+		{
+			requestRedo();
+			++result.redoneStepCount;
+			result.mismatchCount += ((HashEditedState(state) != stateHashes[result.stepCount - result.undoneStepCount + result.redoneStepCount]) ? 1 : 0);
+		}
+		result.isPickIndexValid = (result.isPickIndexValid && IsPickIndexValid(state, camera, rng, arena));
+
+		return result;
+	}
+}
\ No newline at end of file
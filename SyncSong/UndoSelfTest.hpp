@@ -0,0 +1,30 @@
+#pragma once
+#include <Siv3D.hpp>
+
+// 元に戻す・やり直しの自己テストの結果
+struct UndoSelfTestResult
+{
+	size_t byteBudget = 0;
+	size_t stepCount = 0;       // 記録したドラッグ&ドロップの数
+	size_t groupStepCount = 0;  // そのうち範囲選択した球をまとめて動かした数
+	size_t snapStepCount = 0;   // そのうち灰色の球にスナップした数
+	size_t undoneStepCount = 0; // 最後に元に戻せたステップの数（容量を超えて捨てた分だけ stepCount より少ない）
+	size_t redoneStepCount = 0;
+	uint64 discardedStepCount = 0;
+	size_t mismatchCount = 0;   // 元に戻す・やり直しの後の状態が、記録したときの状態と一致しなかった回数
+	bool isPickIndexValid = true; // ピッキングの結果が球の状態から作り直したインデックスと一致したか
+
+	bool passed() const
+	{
+		return ((mismatchCount == 0) && isPickIndexValid && (undoneStepCount == redoneStepCount)
+			&& ((undoneStepCount + discardedStepCount) == stepCount));
+	}
+};
+
+namespace UndoSelfTestUtils
+{
+	// 乱数で stepCount 回のドラッグ&ドロップ（取り外し・移動・スナップ・まとめてドラッグ）を入力として与え、
+	// 途中でも元に戻してやり直し、最後にすべて元に戻してから、すべてやり直す
+	// 1ステップごとに、記録したときの状態のハッシュ（InputTraceUtils::HashGameState、回転角を除く）と比べる
+	UndoSelfTestResult Run(size_t stepCount, size_t byteBudget, uint64 seed);
+}
\ No newline at end of file